@@ -1,6 +1,6 @@
 from fastapi import FastAPI, Request, HTTPException
 from fastapi.middleware.cors import CORSMiddleware
-from models import StatusPayload
+from models import StatusPayload, StatusBatchPayload
 import os
 import hmac
 import hashlib
@@ -8,7 +8,7 @@ import base64
 import httpx
 import json
 from pydantic import BaseModel
-from typing import List, Dict, Optional
+from typing import List, Dict, Optional, Tuple
 from threading import Lock
 
 # =========================
@@ -27,13 +27,19 @@ app.add_middleware(
 # Globals
 # =========================
 
-# เก็บแพ็กเก็ตสถานะล่าสุดจาก ESP32 (แบบแปลงแล้ว)
+# เก็บแพ็กเก็ตสถานะล่าสุดจาก ESP32 (แบบแปลงแล้ว) ของแผงใดก็ได้ที่ส่งมาล่าสุด
 _last_payload: Optional[StatusPayload] = None
 
+# snapshot ล่าสุดแยกตาม device_id (ฐานของโหมด delta: แต่ละแผงต่อ delta กับ snapshot ของตัวเอง)
+_payloads: Dict[str, StatusPayload] = {}
+
 # เก็บค่าเวลา "ดิบ" ที่ ESP ส่งมาจริง ๆ (เพราะใน model อาจจะไม่ได้ define ไว้)
 _last_clean_ts_ms: Optional[int] = None
 _ts_ms: Optional[int] = None
 
+# บล็อก "perf" ล่าสุดต่อ device_id (histogram เวลาแต่ละขั้นของเฟิร์มแวร์, มาเฉพาะกับ payload เต็ม)
+_last_perf: Dict[str, dict] = {}
+
 # เก็บผลการประเมินความสะอาด (แบบประเมินจาก EvaluationPage)
 # NOTE: เก็บในหน่วยความจำ (RAM) ชั่วคราวก่อน / ยังไม่ได้เขียนลง DB
 class EvaluationRecord(BaseModel):
@@ -43,6 +49,15 @@ class EvaluationRecord(BaseModel):
 evaluation_records: List[EvaluationRecord] = []
 eval_lock = Lock()
 
+# เก็บประวัติเหตุการณ์ใช้งาน (เริ่ม/จบ session, รีเซ็ต) ที่ ESP ส่งมาแบบ batch
+# NOTE: เก็บใน RAM เหมือน evaluation_records / จำกัดจำนวนกันหน่วยความจำบวม
+USAGE_EVENTS_MAX = 10000
+usage_events: List[dict] = []
+usage_lock = Lock()
+# seq สูงสุดที่รับแล้วต่อ (device, boot) (กันรับซ้ำเมื่อ ESP ส่ง batch เดิมซ้ำ)
+# seq/ts_ms ของ ESP นับใหม่ได้หลังไฟดับ -> แยกตาม boot_id ไม่เช่นนั้น event แรก ๆ หลังรีบูตถูกทิ้งว่าซ้ำ
+_acked_seq: Dict[Tuple[str, int], int] = {}
+
 # =========================
 # LINE Messaging API config
 # =========================
@@ -145,6 +160,36 @@ async def health():
     }
 
 
+def _apply_status(raw: dict) -> Optional[StatusPayload]:
+    """
+    รวม payload สถานะ (เต็ม หรือ delta) เข้ากับ snapshot ล่าสุดของแผงนั้น แล้วเก็บไว้
+    โหมด delta: ESP ส่งมาเฉพาะห้องที่เปลี่ยนจากครั้งล่าสุดที่เราตอบ ok
+    คืน None ถ้าเป็น delta แต่ไม่มีฐานให้ต่อ (ผู้เรียกตอบ need_full ให้ ESP ส่งแบบเต็มมาใหม่)
+    ใช้ทั้ง POST สถานะเดี่ยวและ "status" ใน batch
+    บล็อก "perf" (มากับ payload เต็ม) ถูกเก็บที่นี่ด้วย -> ได้ทั้งสองทาง
+    """
+    global _last_payload, _last_clean_ts_ms, _ts_ms
+
+    if raw.get("perf") is not None:
+        _last_perf[raw.get("device_id")] = raw["perf"]
+
+    if raw.get("delta"):
+        base = _payloads.get(raw.get("device_id"))
+        if base is None:
+            return None
+        merged = {r.room_id: r.dict() for r in base.rooms}
+        for r in raw.get("rooms", []):
+            merged[r["room_id"]] = r
+        raw = {**raw, "rooms": [merged[k] for k in sorted(merged)]}
+
+    p = StatusPayload(**raw)
+    _payloads[p.device_id] = p
+    _last_payload = p
+    _last_clean_ts_ms = raw.get("last_clean_ts_ms")
+    _ts_ms = raw.get("ts_ms")
+    return p
+
+
 @app.post("/api/restroom/status")
 async def receive_status(request: Request):
     """
@@ -152,18 +197,14 @@ async def receive_status(request: Request):
     เราเก็บ payload ล่าสุดไว้ แล้วตอบกลับ 200 OK
     เพิ่มเติม: เราดึง last_clean_ts_ms / ts_ms จาก JSON ดิบด้วย
     """
-    global _last_payload, _last_clean_ts_ms, _ts_ms
-
     # อ่าน json ดิบก่อน เพื่อให้ได้ทุก field ที่ ESP ส่งมา
     raw = await request.json()
 
-    # เก็บเวลาจริงที่ ESP ส่งมา (ถ้ามี)
-    _last_clean_ts_ms = raw.get("last_clean_ts_ms")
-    _ts_ms = raw.get("ts_ms")
-
-    # จากนั้นค่อยแปลงเป็น model เดิมของคุณ
-    p = StatusPayload(**raw)
-    _last_payload = p
+    # รวม delta เข้ากับ snapshot ของแผงนั้น (ไม่มีฐาน -> ขอให้ ESP ส่งแบบเต็มมาใหม่)
+    p = _apply_status(raw)
+    if p is None:
+        print("[WARN] delta without base payload -> ask device for full status")
+        return {"ok": False, "need_full": True}
 
     print("\n=== STATUS RECEIVED ===")
     print(f"device = {p.device_id}")
@@ -195,22 +236,78 @@ async def receive_status(request: Request):
     }
 
 
+@app.post("/api/restroom/status/batch")
+async def receive_status_batch(batch: StatusBatchPayload):
+    """
+    ESP32 ส่ง event ที่ค้างใน journal (ช่วง Wi-Fi หลุด) มาทีละชุด + สถานะล่าสุด
+    ใช้ POST เดียวแทนการยิงทีละ event
+    หมายเหตุ: ESP จะลบ event ออกจาก journal ก็ต่อเมื่อได้ "ok": true
+    ถ้าคำตอบหายระหว่างทาง อาจได้ event ซ้ำ (seq เดิม) -> ข้ามตัวที่ seq <= ที่รับแล้วของ boot นั้น
+    event ที่ค้างจาก boot ก่อน (spill ใน NVS) มี ts_ms คนละฐานเวลา -> age_ms = None
+    status อาจเป็น delta (เหมือน POST สถานะ) -> ไม่มีฐานให้ต่อ: ยังรับ event ตามปกติ
+    แต่ตอบ need_full ให้ ESP ส่งสถานะเต็มตามมา
+    """
+    status = _apply_status(batch.status)
+    if status is None:
+        print(f"[WARN] batch delta without base payload ({batch.device_id}) -> need_full")
+
+    accepted = 0
+    with usage_lock:
+        for ev in batch.events:
+            key = (batch.device_id, ev.boot_id)
+            if ev.seq <= _acked_seq.get(key, -1):
+                continue
+            _acked_seq[key] = ev.seq
+            # แปลงเวลา ms ของ ESP (นับจากบูต) เป็น "ก่อนส่งกี่ ms" เพื่อให้ frontend คำนวณเวลาได้
+            same_boot = ev.boot_id == batch.boot_id
+            usage_events.append({
+                "device_id": batch.device_id,
+                **ev.dict(),
+                "age_ms": max(0, batch.ts_ms - ev.ts_ms) if same_boot else None,
+            })
+            accepted += 1
+        del usage_events[:-USAGE_EVENTS_MAX]
+
+    print(f"\n=== STATUS BATCH RECEIVED === device={batch.device_id} "
+          f"events={len(batch.events)} accepted={accepted}")
+
+    resp = {
+        "ok": True,
+        "device": batch.device_id,
+        "accepted": accepted,
+        "last_seq": batch.events[-1].seq if batch.events else None,
+    }
+    if status is None:
+        resp["need_full"] = True
+    return resp
+
+
+@app.get("/api/restroom/events")
+async def get_usage_events():
+    """
+    ดึงประวัติเหตุการณ์ใช้งานที่ได้จาก batch
+    """
+    with usage_lock:
+        return {"ok": True, "data": list(usage_events)}
+
+
 @app.get("/api/restroom/status/latest")
-async def latest():
+async def latest(device_id: Optional[str] = None):
     """
     ดึง snapshot ล่าสุดที่เราเก็บไว้ใน _last_payload
+    ระบุ ?device_id=... เพื่อดู snapshot ล่าสุดของแผงนั้น (กรณีมีหลายแผง)
     """
-    if _last_payload is None:
+    p = _payloads.get(device_id) if device_id else _last_payload
+    if p is None:
         return {"ok": False, "message": "no data yet"}
 
-    p = _last_payload
     return {
         "ok": True,
         "device": p.device_id,
         "cleaning_required": p.cleaning_required,
         # ⬇⬇ ตอนนี้ส่งค่าที่เราเก็บจาก JSON ดิบจริง ๆ
-        "last_clean_ts_ms": _last_clean_ts_ms,
-        "ts_ms": _ts_ms,
+        "last_clean_ts_ms": _last_clean_ts_ms if p is _last_payload else p.last_clean_ts_ms,
+        "ts_ms": _ts_ms if p is _last_payload else p.ts_ms,
         "rooms": [
             {
                 "room_id": r.room_id,
@@ -219,6 +316,7 @@ async def latest():
                 "total_use_ms": r.total_use_ms,
             } for r in p.rooms
         ],
+        "perf": _last_perf.get(p.device_id),
     }
 
 # =========================
@@ -1,10 +1,10 @@
 from pydantic import BaseModel, Field
-from typing import List, Literal
+from typing import Any, Dict, List, Literal
 
 RoomState = Literal["vacant", "occupied", "cleaning"]
 
 class RoomPayload(BaseModel):
-    room_id: int = Field(ge=1, le=3)
+    room_id: int = Field(ge=1, le=32)   # แผงหนึ่งรองรับได้ถึง 32 ห้อง (RoomController)
     state: RoomState
     # เพิ่มตัวนับการใช้งานและเวลาสะสมต่อห้อง (มิลลิวินาที)
     use_count: int = Field(ge=0)
@@ -16,3 +16,22 @@ class StatusPayload(BaseModel):
     cleaning_required: bool
     rooms: List[RoomPayload]
     ts_ms: int
+
+# เหตุการณ์ที่ ESP32 จดไว้ใน journal (ส่งย้อนหลังเป็นชุดเมื่อเน็ตกลับมา)
+UsageEventKind = Literal["start", "end", "reset"]
+
+class UsageEvent(BaseModel):
+    seq: int = Field(ge=0)
+    boot_id: int = Field(ge=0)  # ตัวนับการบูตของ ESP
+    room_id: int = Field(ge=0, le=32)  # 0 = ทุกห้อง (ใช้กับ reset)
+    kind: UsageEventKind
+    ts_ms: int = Field(ge=0)
+    dur_ms: int = Field(ge=0)
+
+class StatusBatchPayload(BaseModel):
+    device_id: str
+    boot_id: int = Field(ge=0)  # บูตปัจจุบัน (ts_ms ของ batch นับจากบูตนี้)
+    ts_ms: int
+    events: List[UsageEvent]
+    # payload สถานะดิบ (เต็ม หรือ "delta":true เฉพาะห้องที่เปลี่ยน) -> backend รวมเข้ากับ snapshot ของแผงเอง
+    status: Dict[str, Any]
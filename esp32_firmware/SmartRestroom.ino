@@ -6,51 +6,35 @@
 #include <Preferences.h>      // ✅ ใช้ NVS (แฟลช) เก็บตัวนับข้ามการหลับ/รีบูต
 #include "esp_task_wdt.h"     // ✅ Hardware Task Watchdog (กันค้าง)
 
+#include "panel_config.h"     // ✅ ตารางขา PIR/ประตู/LED ของแผงนี้ + RoomController<N, PinMap>
+#include "panel_policy.h"     // ✅ ปุ่ม double click + เงื่อนไขเข้า sleep (ใช้ร่วมกับตัวจำลองบน PC)
 #include "send_to_backend.h"  // ✅ ส่งสถานะไป Backend ผ่าน HTTP JSON
 #include "send_to_line.h"     // ✅ แจ้งเตือนเข้า LINE OA (push message)
-
-/* ====== กำหนดขาต่าง ๆ ของระบบ ====== */
-#define PIR1 27
-#define PIR2 26
-#define PIR3 25
-#define LED1 18
-#define LED2 17
-#define LED3 16
+#include "net_task.h"         // ✅ คิวงานเครือข่าย + task แยก (loop ไม่ต้องรอ Wi-Fi/HTTP)
+#include "edge_capture.h"     // ✅ จับขอบสัญญาณ PIR/ประตูด้วย interrupt + timestamp (us)
+#include "persist_log.h"      // ✅ บันทึกตัวนับแบบต่อท้าย + CRC (ลดการเขียนแฟลช)
+#include "oled_view.h"        // ✅ model ของจอ + ฟังก์ชันวาดหน้าหลัก/หน้าทำความสะอาด
+#include "oled_partial.h"     // ✅ ส่งเฉพาะ page/คอลัมน์ที่เปลี่ยนไปจอ SSD1306
+#include "perf_probe.h"       // ✅ histogram เวลาแต่ละขั้น + watchdog near-miss (คำสั่ง "perf" ทาง Serial)
+#include "driver/uart.h"      // uart_set_wakeup_threshold() (พิมพ์คำสั่งขณะ light sleep)
+
+/* ====== กำหนดขาต่าง ๆ ของระบบ (ขาของแต่ละห้องอยู่ใน panel_config.h) ====== */
 #define BUZZER_PIN 19
-#define RESET_BTN 34   // ⚠️ GPIO34 เป็น input-only และไม่มี internal pull-up/down -> ต้องมี pull-down ภายนอกจริง
-
-/* ---- Reed switches (ประตู) ----
- * ใช้ GPIO 32, 33, 35 (input-only, ไม่มี internal pull-up/down)
- * แนะนำ: ต่อ pull-up ภายนอก แล้วให้ reed ต่อกราวด์
- * => เมื่อ "ประตูปิด" (reed ปิดวงจร) digitalRead() จะ LOW (เพราะดึงลงกราวด์)
- */
-#define DOOR1 32
-#define DOOR2 33
-#define DOOR3 35
-const bool REED_ACTIVE_LOW = true;   // true = logic LOW แปลว่า "ประตูปิด"
 
 const bool LED_ACTIVE_LOW = false; 
 
-/* ====== ค่าพารามิเตอร์ระบบ ====== */
-const unsigned long DEBOUNCE_MS = 30;              // หน่วงกันเด้งปุ่มสำหรับ double-click reset
-const unsigned long HOLD_ON_MS  = 10UL * 1000UL;   // เวลาคอยดับไฟเมื่อไม่มี motion ต่อเนื่อง (10s)
-const unsigned int  USES_THRESHOLD_PER_ROOM = 5;   // เกณฑ์จำนวนรอบการใช้งานต่อห้องก่อนแจ้ง "ต้องทำความสะอาด"
-const unsigned long TOTAL_MS_THRESHOLD_PER_ROOM =
-  2UL * 60UL * 1000UL;                             // เกณฑ์เวลาสะสม >= 2 นาที ต่อห้องก่อนแจ้ง "ต้องทำความสะอาด"
-
 /* ====== โหมดประหยัดพลังงาน (Light Sleep) ====== */
-static const unsigned long SLEEP_IDLE_MS = 2UL * 60UL * 1000UL;  // ถ้าห้องว่างทุกห้องนานเกิน 2 นาที -> เข้าหลับ
-static const uint64_t LIGHT_SLEEP_INTERVAL_US =
-  5ULL * 60ULL * 1000000ULL; // ปลุกตัวเองอัตโนมัติทุก ~5 นาที (heartbeat)
-const unsigned long AWAKE_HOLDOFF_MS = 1500;       // ตื่นมาแล้วอย่างน้อย 1.5s ก่อนค่อยหลับใหม่
 static unsigned long lastWakeMs = 0;
+static SleepStats sleepStats;                      // หลับ/ตื่นสะสมตั้งแต่บูต (ทั้งแบบว่างนานและระหว่าง deadline)
+#if TICK_SLEEP_ASSOCIATED
+static BeaconWindow beaconWindow;                  // ต่อ AP อยู่: ได้ beacon ล่าสุดเมื่อไร (คุมระยะหลับ)
+#endif
 
 /* ====== Watchdog ====== */
 // ถ้า loop ไม่ feed ภายใน 10 วินาที จะ trigger panic -> รีบูตอัตโนมัติ
 #define WDT_TIMEOUT_SEC 10
 
 /* ====== Buzzer (เตือนเมื่อถึงเกณฑ์ต้องทำความสะอาด) ====== */
-const unsigned long BUZZER_TOGGLE_MS = 3000UL;     // กระพริบเสียงเข้า/ออกทุก 3 วินาทีตอนแจ้งเตือน
 bool buzzerState = false;
 unsigned long lastBuzzerToggle = 0;
 
@@ -61,118 +45,86 @@ unsigned long lastBuzzerToggle = 0;
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
 bool oledOn = true; // ธงบอกสถานะจอเปิด/ปิด (ใช้ตอน sleep)
 
-/* ====== โครงสร้างสถานะของแต่ละห้อง (runtime เฉพาะรอบปัจจุบัน) ====== */
-struct RoomState {
-  bool lightOn = false;             // ตอนนี้ห้องกำลังถูกใช้งานอยู่หรือไม่ (true=มีคน)
-  unsigned long lastMotionMs = 0;   // เวลาเกิด motion ครั้งล่าสุด
-  unsigned long sessionStartMs = 0; // เวลาเริ่มรอบการใช้งานครั้งนี้
-  unsigned long uses = 0;           // จำนวนรอบการใช้งาน (นับเพิ่มตอนจบ session)
-  bool needCleaning = false;        // ธงว่าห้องนี้ถึงเกณฑ์ต้องทำความสะอาดแล้วหรือยัง
-} room[3];
-
-/* ====== สถานะประตู (รีดสวิตช์) ของแต่ละห้อง ====== */
-bool doorClosed[3] = {false,false,false}; // true = ประตูปิด (รีดปิดวงจร)
+/* ====== สถานะของทุกห้อง (struct-of-arrays ใน RoomController) ====== */
+Panel panel({
+  HOLD_ON_MS,
+  USES_THRESHOLD_PER_ROOM,
+  TOTAL_MS_THRESHOLD_PER_ROOM,
+  DOOR_DEBOUNCE_MS,
+});
 
 /* ====== ตัวแปรสำหรับเชื่อมต่อ Backend/LINE และ Persist ====== */
 bool cleaningRequired = false;      // ถ้ามีอย่างน้อยหนึ่งห้องที่ needCleaning -> true
 unsigned long lastCleanTimestamp = 0; // เวลาที่รีเซ็ตล่าสุด (ms นับจากบูต)
-Room rooms[3];                      // โครงสร้างที่ mirror state เพื่อนำไปส่ง backend
 
 bool backend_ok = false;            // ธงผลล่าสุดที่ POST ไป backend (true=สำเร็จ)
-uint32_t reportUses[3]    = {0,0,0};
-uint32_t reportTotalMs[3] = {0,0,0};
 bool persistLoaded        = false;
 
 /* ====== Persist (เซฟค่าลง RTC + NVS) ====== */
 // เก็บตัวนับ uses, totalMs และธง needCleaning เพื่อให้คงอยู่ข้าม sleep/reboot
-typedef struct {
-  uint32_t magic;
-  uint32_t uses[3];
-  uint32_t totalMs[3];
-  uint8_t  needCleaning[3];
-} PersistCounters;
+// บันทึกผ่าน persist_log.h (record ต่อท้าย + CRC + seq, ข้ามถ้าไม่เปลี่ยน)
+// (ขนาดขึ้นกับจำนวนห้อง ROOM_COUNT; ถ้าเปลี่ยนจำนวนห้อง record เดิมจะไม่ผ่านการตรวจและเริ่มนับใหม่)
+typedef Panel::Persist PersistCounters;
 
 #define PERSIST_MAGIC 0xA55A2025
 
-RTC_DATA_ATTR PersistCounters persistRTC = {0}; // เก็บลง RTC RAM (อยู่รอดตอน light sleep)
-Preferences prefs;                              // NVS สำหรับสำรองบนแฟลช
+Preferences prefs;                              // NVS (ใช้อ่าน key "counters" รุ่นเก่าตอนย้ายข้อมูลเท่านั้น)
 
-/* ====== โหลด/บันทึก Persist จาก/ลง NVS ====== */
-bool nvsLoad(PersistCounters &out) {
-  prefs.begin("restroom", true);                       // โหมดอ่าน
+/* ====== ย้ายข้อมูลจาก key "counters" รุ่นเก่า (blob เดียวเขียนทับ) ======
+ * อ่านได้ -> คืน true พร้อมข้อมูล, และลบ key ทิ้งเสมอ (compact)
+ */
+bool nvsTakeLegacy(PersistCounters &out) {
+  prefs.begin("restroom", false);
   size_t sz = prefs.getBytesLength("counters");
   bool ok = false;
   if (sz == sizeof(PersistCounters)) {
     size_t got = prefs.getBytes("counters", &out, sizeof(PersistCounters));
     ok = (got == sizeof(PersistCounters) && out.magic == PERSIST_MAGIC);
   }
+  if (sz) prefs.remove("counters");
   prefs.end();
   return ok;
 }
 
-void nvsSave(const PersistCounters &in) {
-  prefs.begin("restroom", false);                      // โหมดเขียน
-  prefs.putBytes("counters", &in, sizeof(PersistCounters));
-  prefs.end();
-}
-
 /* ====== สร้างโครง Persist จากค่าปัจจุบันใน RAM ====== */
 inline void buildPersistFromRuntime(PersistCounters &out) {
-  out.magic = PERSIST_MAGIC;
-  for (int i=0;i<3;i++) {
-    out.uses[i]         = rooms[i].useCount;           // ดึงจาก struct ที่ส่ง backend
-    out.totalMs[i]      = rooms[i].totalUseMS;
-    out.needCleaning[i] = room[i].needCleaning ? 1 : 0;
+  panel.savePersist(out, PERSIST_MAGIC);
+}
+
+/* ====== บันทึกตัวนับปัจจุบัน (ไม่แตะแฟลชถ้าไม่มีอะไรเปลี่ยนจากครั้งล่าสุด) ====== */
+void savePersist() {
+  PersistCounters tmp;
+  buildPersistFromRuntime(tmp);
+  if (persistLogAppend(&tmp, sizeof(tmp))) {
+    // seq ของ record = จำนวนครั้งที่เขียนแฟลชสะสม จึงพิมพ์ค่าเดียว
+    Serial.printf("[PERSIST] saved (flash writes: %lu total, %lu this boot, %lu skipped)\n",
+                  (unsigned long)persistLogFlashWrites(), (unsigned long)persistLogWrites,
+                  (unsigned long)persistLogSkipped);
   }
 }
 
 /* ====== โหลด Persist เข้าสู่ตัวแปร runtime ====== */
 void loadPersistIntoRuntime() {
   PersistCounters tmp = {0};
-  bool loaded = false;
 
-  // 1) ถ้ามีใน RTC แล้ว ใช้อันนั้นก่อน (เร็ว ไม่ต้องแตะแฟลช)
-  if (persistRTC.magic == PERSIST_MAGIC) {
-    tmp = persistRTC;
-    loaded = true;
-  }
-  // 2) ถ้า RTC ไม่มี ลองอ่านจาก NVS (แฟลช)
-  else if (nvsLoad(tmp)) {
-    loaded = true;
-    persistRTC = tmp; // sync กลับเข้า RTC ด้วย
-  }
+  // 1) record ใหม่สุดที่ CRC ถูกต้อง (RTC หรือ NVS)
+  bool loaded = persistLogRecover(&tmp, sizeof(tmp));
 
-  // 3) ถ้าเจอข้อมูล -> โยนเข้า runtime
-  if (loaded) {
-    for (int i=0;i<3;i++) {
-      room[i].uses         = tmp.uses[i];
-      rooms[i].useCount    = tmp.uses[i];
-      rooms[i].totalUseMS  = tmp.totalMs[i];
-      room[i].needCleaning = (tmp.needCleaning[i] != 0);
-    }
-  } else {
-    // 4) ไม่เจอข้อมูลเลย -> เริ่มใหม่และเซฟลง NVS
-    memset(&persistRTC, 0, sizeof(persistRTC));
-    persistRTC.magic = PERSIST_MAGIC;
-    nvsSave(persistRTC);
+  // 2) ไม่มี -> ลองย้ายจาก key รุ่นเก่า (และลบ key เก่าทิ้งทุกกรณี)
+  PersistCounters legacy;
+  if (nvsTakeLegacy(legacy) && !loaded) {
+    tmp = legacy;
+    loaded = true;
+    Serial.println("[PERSIST] migrated legacy counters");
   }
 
-  // เตรียม snapshot สำหรับส่ง backend
-  for (int i=0;i<3;i++) {
-    reportUses[i]    = rooms[i].useCount;
-    reportTotalMs[i] = rooms[i].totalUseMS;
-  }
+  // 3) ถ้าเจอข้อมูล -> โยนเข้า runtime แล้วเขียนเป็น record (ถ้าย้ายมาจากรุ่นเก่า)
+  //    ไม่เจอเลย -> เริ่มจากศูนย์
+  if (loaded) panel.loadPersist(tmp);
+  savePersist();
   persistLoaded = true;
 }
 
-/* ====== อัปเดต snapshot ก่อนส่ง backend ====== */
-inline void refreshReportSnapshotFromRuntime() {
-  for (int i=0;i<3;i++) {
-    reportUses[i]    = rooms[i].useCount;
-    reportTotalMs[i] = rooms[i].totalUseMS;
-  }
-}
-
 /* ====== Helper คุม LED แบบรองรับ active-low ====== */
 inline void setLed(int pin, bool on) {
   if (LED_ACTIVE_LOW) digitalWrite(pin, on ? LOW : HIGH);
@@ -183,251 +135,182 @@ inline void setLed(int pin, bool on) {
 void buzzerOn()  { pinMode(BUZZER_PIN, OUTPUT); digitalWrite(BUZZER_PIN, LOW); } // โมดูลบางแบบ trigger LOW
 void buzzerOff() { pinMode(BUZZER_PIN, INPUT); }                                 // ปล่อยขาให้ Hi-Z = เงียบ
 
-/* ====== อ่านรีดสวิตช์ (สถานะประตู) ====== */
-inline bool readDoorRaw(int pin) {
-  int v = digitalRead(pin);
-  // กำหนดทิศทางไว้ชัด: ถ้า REED_ACTIVE_LOW = true -> LOW แปลว่าประตูปิด
-  return REED_ACTIVE_LOW ? (v == LOW) : (v == HIGH);
+/* เวลา motion ล่าสุดของทุกห้อง (ms) ใช้ตัดสินใจว่า "ว่างนาน" หรือยัง */
+inline unsigned long lastAnyMotionMs() {
+  return (unsigned long)(panel.lastAnyMotionUs() / 1000);
 }
 
-inline void readAllDoors() {
-  doorClosed[0] = readDoorRaw(DOOR1);
-  doorClosed[1] = readDoorRaw(DOOR2);
-  doorClosed[2] = readDoorRaw(DOOR3);
-}
+/* ====== ส่วนแสดงผลบนจอ OLED ======
+ * วาดผ่าน oled_view.h (model -> framebuffer) แล้วส่งด้วย oled_partial.h
+ * เฉพาะ page/คอลัมน์ที่เปลี่ยนจริง แทน display() ทั้งจอ 1KB ทุก 250ms
+ */
+struct WireOledBus {
+  void window(uint8_t p0, uint8_t p1, uint8_t c0, uint8_t c1) {
+    Wire.beginTransmission(OLED_ADDR);
+    Wire.write((uint8_t)0x00);                      // control: ตามด้วยคำสั่ง
+    Wire.write((uint8_t)SSD1306_COLUMNADDR); Wire.write(c0); Wire.write(c1);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);   Wire.write(p0); Wire.write(p1);
+    Wire.endTransmission();
+  }
+  void data(const uint8_t *p, size_t n) {
+    Wire.beginTransmission(OLED_ADDR);
+    Wire.write((uint8_t)0x40);                      // control: ตามด้วยข้อมูล GDDRAM
+    Wire.write(p, n);
+    Wire.endTransmission();
+  }
+};
 
-/* ====== ส่วนแสดงผลบนจอ OLED ====== */
-static void drawCenteredText(int size, const char* line, int y) {
-  display.setTextSize(size);
-  display.setTextColor(SSD1306_WHITE);
-  int16_t x1, y1;
-  uint16_t w, h;
-  display.getTextBounds(line, 0, 0, &x1, &y1, &w, &h);
-  int16_t cx = (SCREEN_WIDTH - w) / 2;
-  display.setCursor(cx, y);
-  display.println(line);
-}
+static WireOledBus    oledBus;
+static OledShadow     oledShadow;        // valid=false -> ครั้งแรกส่งทั้งจอ
+static OledFlushStats oledStats;         // byte บนสาย I2C สะสม (ใช้วัดผล)
 
-void drawMainPage() {
-  // แสดงสถานะรวมของแต่ละห้อง + จำนวนรอบใช้งาน U
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 0);
-  display.println(F("Smart Restroom"));
-  for (int i = 0; i < 3; i++) {
-    int y = 14 + i * 16;
-    display.setCursor(0, y);
-    display.print(F("R")); display.print(i + 1); display.print(F(": "));
-    if (room[i].needCleaning)      display.print(F("Clean"));
-    else if (room[i].lightOn)      display.print(F("Occupied"));
-    else                           display.print(F("Vacant"));
-    display.setCursor(90, y);
-    display.print(F("U=")); display.print(room[i].uses);
-  }
-  display.display();
+typedef OledModel<ROOM_COUNT> PanelOledModel;
+static PanelOledModel oledShown;         // model ที่อยู่บนจอตอนนี้
+static bool oledShownValid = false;      // false = ต้องวาดใหม่รอบถัดไป (หลัง toast/ปิดจอ)
+
+/* ส่ง framebuffer ไปจอ (เฉพาะส่วนที่เปลี่ยน) แทน display.display() */
+void oledPush() {
+  oledFlushChanged(display.getBuffer(), oledShadow, oledBus, oledStats);
 }
 
-void drawCleaningOverlay() {
-  // โหมดแจ้ง "กำลังทำความสะอาด" พร้อมกรอบกระพริบ
-  bool blink = (millis() / 500) % 2;
-  display.clearDisplay();
-  drawCenteredText(2, "CLEANING!", 8);
-  if (blink) {
-    display.drawRoundRect(2, 2, SCREEN_WIDTH - 4, SCREEN_HEIGHT - 4, 6, SSD1306_WHITE);
-  }
-  drawCenteredText(1, "Please wait...", 44);
-  display.display();
+/* วาดหน้าหลักหรือหน้าทำความสะอาดเฉพาะเมื่อสิ่งที่ต้องแสดงเปลี่ยน */
+void drawDisplayIfChanged() {
+  PerfScope probe(PERF_DRAW);
+  PanelOledModel m;
+  oledBuildModel(m, panel, cleaningRequired, millis());
+  if (oledShownValid && oledModelEqual(m, oledShown)) return;   // ไม่มีอะไรเปลี่ยน -> ไม่วาด ไม่ส่ง
+
+  oledRender(display, m);
+  oledPush();
+  oledShown = m;
+  oledShownValid = true;
 }
 
 void showResetToast() {
   // แสดงข้อความสั้น ๆ เมื่อรีเซ็ตตัวนับเสร็จ
   display.clearDisplay();
-  drawCenteredText(2, "Counters", 18);
-  drawCenteredText(2, "Reset",    36);
-  display.display();
+  oledDrawCentered(display, 2, "Counters", 18);
+  oledDrawCentered(display, 2, "Reset",    36);
+  oledPush();
+  oledShownValid = false;   // หลัง toast วาดหน้าปกติใหม่
   delay(800);
 }
 
-/* ====== mirrorRoomToBackendStruct: สะท้อนสถานะเพื่อส่ง backend ====== */
-void mirrorRoomToBackendStruct(int idx, int pirPin, int ledPin) {
-  rooms[idx].pirPin   = pirPin;
-  rooms[idx].ledPin   = ledPin;
-  rooms[idx].occupied = room[idx].lightOn;  // ตรงนี้คือแกนหลักที่ backend ใช้แสดงว่าง/ไม่ว่าง
-}
-
 /* ====== อัปเดตธงรวมว่ามีห้องไหนต้องทำความสะอาดไหม ====== */
 void updateCleaningRequiredFlag() {
-  cleaningRequired = false;
-  for (int i=0;i<3;i++) {
-    if (room[i].needCleaning) {
-      cleaningRequired = true;    // ถ้ามีซักห้อง -> ธงรวม = true
-      break;
-    }
-  }
+  cleaningRequired = panel.anyNeedCleaning();   // ถ้ามีซักห้อง -> ธงรวม = true
 }
 
-/* ====== ปุ่มรีเซ็ตแบบ "กด 2 ครั้งติดกัน" เพื่อกันกดพลาด ====== */
-const unsigned long BOOT_GRACE_MS    = 5000; // กันกดตอนบูต 5s แรก
-const unsigned long DOUBLE_WINDOW_MS = 800;  // ต้องกดครั้งที่ 2 ภายใน 0.8s
-
-unsigned long bootAtMs      = 0;
-static int btnLastStable    = LOW;
-static unsigned long btnLastChange = 0;
-static unsigned long firstClickAt  = 0;
-static bool firstClickArmed = false;
+/* ====== ปุ่มรีเซ็ตแบบ "กด 2 ครั้งติดกัน" เพื่อกันกดพลาด (ลอจิกอยู่ใน panel_policy.h) ====== */
+static DoublePressDetector resetButton(DEBOUNCE_MS, DOUBLE_WINDOW_MS, BOOT_GRACE_MS);
 
 bool readButtonDoublePressed() {
-  unsigned long now = millis();
-  if (now - bootAtMs < BOOT_GRACE_MS) return false; // ยังไม่รับกดช่วงบูต
-
-  int raw = digitalRead(RESET_BTN);
-  // ตรวจจับขอบสัญญาณแบบหน่วงกันเด้ง
-  if (raw != btnLastStable && now - btnLastChange >= DEBOUNCE_MS) {
-    btnLastChange = now;
-    btnLastStable = raw;
-
-    if (btnLastStable == HIGH) { // นับเฉพาะตอนปล่อยเป็น HIGH (หรือเลือกตอนกดก็ได้ตามวงจร)
-      if (!firstClickArmed) {
-        // ครั้งที่ 1 -> ติดธงรอครั้งที่ 2
-        firstClickArmed = true;
-        firstClickAt = now;
-      } else if (now - firstClickAt <= DOUBLE_WINDOW_MS) {
-        // ครั้งที่ 2 มาทันเวลา -> นับว่า double click สำเร็จ
-        firstClickArmed = false;
-        return true;
-      } else {
-        // คลิกช้าไป -> เลื่อนหน้าต่างใหม่
-        firstClickAt = now;
-      }
-    }
-  }
-
-  // ถ้ารอครั้งที่สองนานเกินหน้าต่าง -> ยกเลิก
-  if (firstClickArmed && (now - firstClickAt > DOUBLE_WINDOW_MS)) {
-    firstClickArmed = false;
-  }
-
-  return false;
+  return resetButton.feed(digitalRead(RESET_BTN) == HIGH, millis());
 }
 
 /* ====== แกนหลักตรวจจับ "เข้า/ออกห้อง" (PIR + ประตู) ======
- * กติกา:
- * - เริ่ม "ใช้งาน" เมื่อ PIR มี motion + ประตูปิดและยังไม่อยู่ในสถานะใช้งาน
- * - จบ "ใช้งาน" เมื่อประตูเปิด หรือไม่มี motion เกิน HOLD_ON_MS
+ * ลอจิกอยู่ใน RoomController (room_controller.h)
+ * ตรงนี้คือ "ผลข้างเคียง" เมื่อเริ่ม/จบ session: LED, journal, log, ส่ง backend/LINE
  */
-void updateRoom(int idx, int pirPin, int ledPin, unsigned long now) {
-  int  motion       = digitalRead(pirPin);
-  bool doorIsClosed = doorClosed[idx];
-
-  /* --- เริ่ม session --- */
-  if (motion == HIGH) {
-    // เริ่ม session ใหม่ เฉพาะเมื่อ "ยังไม่ ON" และ "ประตูปิด"
-    if (!room[idx].lightOn && doorIsClosed) {
-      room[idx].lightOn        = true;
-      room[idx].sessionStartMs = now;
-      setLed(ledPin, true);  // เปิดไฟในห้อง
-      Serial.printf("[R%d] ON (motion + door closed)\n", idx+1);
-
-      // อัปเดตโครงสร้างสำหรับ backend และคำนวณธงรวม
-      mirrorRoomToBackendStruct(idx, pirPin, ledPin);
-      updateCleaningRequiredFlag();
+struct PanelSink {
+  void onSessionStart(size_t i, int64_t tUs) {
+    setLed(PanelPins::led[i], true);  // เปิดไฟในห้อง
+    journalAppend(JEV_START, i, (uint32_t)(tUs / 1000), 0);  // จดลง journal (ส่งย้อนหลังได้ถ้าเน็ตหลุด)
+    Serial.printf("[R%u] ON (motion + door closed)\n", (unsigned)i+1);
 
-      // ส่ง snapshot ปัจจุบันขึ้น backend (บันทึกว่าเริ่มใช้งานแล้ว)
-      refreshReportSnapshotFromRuntime();
-      sendStatusImmediately();
-    }
-    // บันทึกเวลามี motion ล่าสุด (ใช้ตัดสินใจ timeout)
-    room[idx].lastMotionMs = now;
+    // ส่ง snapshot ปัจจุบันขึ้น backend (บันทึกว่าเริ่มใช้งานแล้ว) — ฝากคิว ไม่ block
+    updateCleaningRequiredFlag();
+    netRequestStatus();
   }
 
-  /* --- จบ session --- */
-  bool timeout           = room[idx].lightOn && (now - room[idx].lastMotionMs > HOLD_ON_MS);
-  bool doorOpenedWhileOn = room[idx].lightOn && !doorIsClosed;
-
-  if (timeout || doorOpenedWhileOn) {
-    // ปิดสถานะใช้งาน + ดับไฟ
-    room[idx].lightOn = false;
-    setLed(ledPin, false);
-
-    // นับจำนวนรอบ และบันทึกเวลาที่ใช้ไปในรอบนี้
-    room[idx].uses++;
-    unsigned long dur = now - room[idx].sessionStartMs;
+  void onSessionEnd(size_t i, int64_t endUs, uint32_t durMs, bool byTimeout, bool becameDirty) {
+    // ดับไฟ + บันทึกเวลาที่ใช้ไปในรอบนี้
+    setLed(PanelPins::led[i], false);
+    journalAppend(JEV_END, i, (uint32_t)(endUs / 1000), durMs);
 
     Serial.printf(
-      "[R%d] OFF (%s) | dur=%.2f min | uses=%lu\n",
-      idx+1,
-      doorOpenedWhileOn ? "door opened" : "timeout",
-      dur / 60000.0,
-      room[idx].uses
+      "[R%u] OFF (%s) | dur=%.2f min | uses=%lu\n",
+      (unsigned)i+1,
+      byTimeout ? "timeout" : "door opened",
+      durMs / 60000.0,
+      (unsigned long)panel.uses[i]
     );
 
-    // อัปเดตค่าที่สะสมไว้เพื่อส่ง backend/เก็บ persist
-    rooms[idx].useCount    = room[idx].uses;
-    rooms[idx].totalUseMS += dur;
-
-    // ตรวจเกณฑ์ "ต้องทำความสะอาด": ตามจำนวนครั้ง หรือ เวลาสะสม
-    if (!room[idx].needCleaning &&
-        (room[idx].uses >= USES_THRESHOLD_PER_ROOM ||
-         rooms[idx].totalUseMS >= TOTAL_MS_THRESHOLD_PER_ROOM)) {
-
-      room[idx].needCleaning = true;
-      Serial.printf("[R%d] -> Clean\n", idx+1);
-
-      // แจ้ง LINE ให้แม่บ้านทราบ (ensure WiFi ก่อน)
-      wifiEnsure();
-      notifyCleaningRequired(idx, room[idx].uses);
+    // ถึงเกณฑ์ "ต้องทำความสะอาด": แจ้ง LINE ให้แม่บ้านทราบ (net task จะ ensure WiFi ให้เอง)
+    if (becameDirty) {
+      Serial.printf("[R%u] -> Clean\n", (unsigned)i+1);
+      netNotifyCleaningRequired(i, panel.uses[i]);
     }
 
-    // อัปเดตภาพสะท้อนไป backend + ธงรวม แล้วส่งสถานะล่าสุด
-    mirrorRoomToBackendStruct(idx, pirPin, ledPin);
+    // อัปเดตธงรวม แล้วส่งสถานะล่าสุด
     updateCleaningRequiredFlag();
+    netRequestStatus();
+  }
+};
+
+static PanelSink panelSink;
 
-    refreshReportSnapshotFromRuntime();
-    sendStatusImmediately();
+/* ====== อ่านระดับขาจริงแล้วตั้งค่าใหม่ (ตอนบูต, หลังตื่นจาก sleep, หรือ edge queue ล้น) ====== */
+void resyncRoomInputs(int64_t nowUs) {
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    panel.resync(i,
+                 digitalRead(PanelPins::pir[i])  == HIGH,
+                 digitalRead(PanelPins::door[i]) == HIGH,
+                 nowUs);
   }
 }
 
+/* ====== ดึง edge ทั้งหมดที่ค้าง -> อัปเดตทุกห้องตามลำดับเวลา ====== */
+void processRoomInputs(int64_t nowUs) {
+  {
+    PerfScope probe(PERF_SENSE);
+    EdgeEvent e;
+    while (edgePop(e)) {
+      panel.applyEdge(e.pin, e.level == HIGH, e.tUs, panelSink);
+    }
+    if (edgeTakeOverflow()) {
+      Serial.println("[EDGE] queue overflow -> resync from pins");
+      resyncRoomInputs(nowUs);
+    }
+  }
+
+  // ยืนยันประตูที่นิ่งแล้ว + ตรวจ timeout + ต่อเวลา motion ของห้องที่ PIR ยังค้าง HIGH
+  PerfScope probe(PERF_ROOM);
+  panel.tick(nowUs, panelSink);
+}
+
 /* ====== รีเซ็ตตัวนับทั้งหมด (แม่บ้านมากดเมื่อทำความสะอาดแล้ว) ====== */
 void doResetCounters() {
   // ล้างตัวนับทุกห้อง
-  for (int i = 0; i < 3; i++) {
-    room[i].uses         = 0;
-    room[i].needCleaning = 0;
-    rooms[i].useCount    = 0;
-    rooms[i].totalUseMS  = 0;
-  }
+  panel.resetCounters();
 
   lastCleanTimestamp = millis(); // บันทึกเวลาที่รีเซ็ต
+  journalAppend(JEV_RESET, JOURNAL_ALL_ROOMS, lastCleanTimestamp, 0);
   updateCleaningRequiredFlag();
   buzzerOff(); buzzerState = false;
 
-  // สร้างข้อมูล persist จาก runtime แล้วเซฟลง RTC + NVS
-  PersistCounters tmp;
-  buildPersistFromRuntime(tmp);
-  persistRTC = tmp;
-  nvsSave(tmp);
+  // เซฟตัวนับที่ล้างแล้วลง RTC + NVS
+  savePersist();
 
   // แจ้ง backend ว่ารีเซ็ตแล้ว + ขึ้นหน้าจอ
-  refreshReportSnapshotFromRuntime();
   Serial.println("[RESET] All counters cleared.");
   showResetToast();
-  sendStatusImmediately();
+  netRequestStatus();
 
   // แจ้ง LINE บอกว่าเคลียร์แล้ว
-  wifiEnsure();
-  notifyCountersReset();
+  netNotifyCountersReset();
 }
 
 /* ====== Utilities เกี่ยวกับการ Sleep/จอ ====== */
-static inline uint64_t rtcMaskFor(uint8_t gpio) { return (1ULL << gpio); }
+static constexpr uint64_t rtcMaskFor(uint8_t gpio) { return (1ULL << gpio); }
 
 void oledOff() {
   if (oledOn) {
     display.clearDisplay();
-    display.display();
+    oledPush();
     display.ssd1306_command(SSD1306_DISPLAYOFF);
     oledOn = false;
+    oledShownValid = false;   // ตื่นแล้ววาดใหม่
   }
 }
 
@@ -441,46 +324,32 @@ void oledOnWake() {
 bool heartbeatOnWake = false; // ธงว่าเพิ่งตื่นจาก timer (ปลุกทุก ~5 นาที)
 
 /* ====== พยายามเข้าหลับ (Light Sleep) เมื่อระบบว่าง ======
- * เงื่อนไขเข้าหลับ:
+ * เงื่อนไขเข้าหลับ (lightSleepAllowed() ใน panel_policy.h):
  * - ตื่นมานานพอ (AWAKE_HOLDOFF_MS)
- * - ทุกห้องว่าง และไม่มีธง cleaningRequired
+ * - ทุกห้องว่าง ไม่มีธง cleaningRequired ไม่มีงานเน็ตค้าง และประตูเปิดหมด
  * - ไม่มี motion รวมกันนานเกิน SLEEP_IDLE_MS
  * ปลุกได้จาก: PIR/ปุ่ม (EXT1) หรือ RTC timer 5 นาที
  */
-void maybeEnterLightSleep(unsigned long now) {
-  // 1) ยังไม่ตื่นมานานพอ
-  if (now - lastWakeMs < AWAKE_HOLDOFF_MS) return;
-
-  // 2) ยังมีห้องใช้งานอยู่
-  if (room[0].lightOn || room[1].lightOn || room[2].lightOn) return;
-
-  // 3) ยังมีห้องต้องทำความสะอาด
-  if (cleaningRequired) return;
-
-  // 4) ถ้ามีประตูบานไหนยังปิดอยู่ (reed = closed) ไม่ต้องหลับ
-  if (doorClosed[0] || doorClosed[1] || doorClosed[2]) {
-    return;
-  }
-
-  unsigned long lastAnyMotion =
-    max(room[0].lastMotionMs, max(room[1].lastMotionMs, room[2].lastMotionMs));
-
-  if (now - lastAnyMotion < SLEEP_IDLE_MS) return;
+bool maybeEnterLightSleep(unsigned long now) {
+  SleepGateInputs in;
+  in.nowMs            = now;
+  in.lastWakeMs       = lastWakeMs;
+  in.lastMotionMs     = lastAnyMotionMs();
+  in.anyOccupied      = panel.anyOccupied();
+  in.cleaningRequired = cleaningRequired;
+  in.netBusy          = netBusy();   // หลับตอนส่งอยู่ Wi-Fi/HTTP จะขาดกลางทาง
+  in.anyDoorClosed    = panel.anyDoorClosed();
+  if (!lightSleepAllowed(in, AWAKE_HOLDOFF_MS, SLEEP_IDLE_MS)) return false;
 
   // ก่อนหลับ: เซฟ persist ล่าสุด (กันไฟดับ/ตื่นมาแล้วตัวนับไม่ตรง)
-  PersistCounters tmp;
-  buildPersistFromRuntime(tmp);
-  persistRTC = tmp;
-  nvsSave(tmp);
+  // ถ้าไม่มี session ใหม่ตั้งแต่ครั้งก่อน จะไม่เขียนแฟลชเลย
+  savePersist();
 
   buzzerOff();
   oledOff();
 
-  // ตั้งเงื่อนไขปลุก: PIR ทั้ง 3 + ปุ่ม reset + timer 5 นาที
-  uint64_t mask = rtcMaskFor(PIR1) |
-                  rtcMaskFor(PIR2) |
-                  rtcMaskFor(PIR3) |
-                  rtcMaskFor(RESET_BTN);
+  // ตั้งเงื่อนไขปลุก: PIR ทุกห้อง + ปุ่ม reset + timer 5 นาที (mask คำนวณตอนคอมไพล์)
+  constexpr uint64_t mask = Panel::pirWakeMask() | rtcMaskFor(RESET_BTN);
 
   esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
   esp_sleep_enable_ext1_wakeup(mask, ESP_EXT1_WAKEUP_ANY_HIGH);
@@ -490,11 +359,20 @@ void maybeEnterLightSleep(unsigned long now) {
   Serial.flush();
 
   // เข้าหลับจริง
+  int64_t t0 = esp_timer_get_time();
   esp_light_sleep_start();
 
   // ตรวจเหตุปลุก
   esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
   lastWakeMs = millis();
+#if TICK_SLEEP_ASSOCIATED
+  beaconNoteWake(beaconWindow, lastWakeMs);
+#endif
+  sleepStatsAdd(sleepStats, (uint64_t)(esp_timer_get_time() - t0),
+                cause == ESP_SLEEP_WAKEUP_EXT1, SCHED_HEARTBEAT);
+
+  // ระหว่างหลับ ISR ไม่ทำงาน -> อ่านระดับขาจริงใหม่ (ขอบที่ปลุกเราอาจไม่ถูกจับ)
+  resyncRoomInputs(esp_timer_get_time());
 
   if (cause == ESP_SLEEP_WAKEUP_EXT1) {
     // มีการเคลื่อนไหว/กดปุ่ม -> เปิดจอ
@@ -503,6 +381,166 @@ void maybeEnterLightSleep(unsigned long now) {
     // ปลุกตามรอบ -> ทำ heartbeat หลังจากนี้ใน loop()
     heartbeatOnWake = true;
   }
+  return true;
+}
+
+/* ====== Tickless: หา deadline ถัดไปของทุก timer แล้วรอ/หลับจนถึงตอนนั้น ======
+ * เดิม loop ตื่นทุก 20ms แล้วไล่เช็ค millis() ของแต่ละ timer
+ * ตอนนี้ schedNextDeadline() (panel_policy.h) รวม: timeout HOLD_ON/ประตูของทุกห้อง,
+ * กรอบกระพริบ, heartbeat, buzzer, feed watchdog และปุ่มที่กำลังกด
+ * - รอนาน >= TICK_SLEEP_MIN_MS, net task ว่าง และ Wi-Fi ไม่ได้ต่อ AP อยู่ -> light sleep (จอยังเปิด)
+ *   ปลุกด้วย timer ตาม deadline หรือขา PIR/ประตู/ปุ่มเปลี่ยน (GPIO wake แบบ level)
+ * - ไม่เช่นนั้น -> edgeWait() จนถึง deadline (ต่อ AP อยู่: CPU พักใน idle + Wi-Fi ใน modem sleep)
+ *   edge/ปุ่มมี interrupt ปลุกเอง ไม่ต้อง poll
+ * - TICK_SLEEP_ASSOCIATED=1 (ทดลอง): ต่อ AP อยู่ก็หลับได้ไม่เกิน BEACON_BUDGET_MS จาก beacon ล่าสุด
+ */
+static unsigned long lastBeat = 0;          // heartbeat ปกติล่าสุด
+static unsigned long lastFeedPrint = 0;     // log watchdog ล่าสุด
+static unsigned long lastSerialRxMs = 0;    // รับตัวอักษรทาง Serial ล่าสุด (กัน tick sleep ขณะพิมพ์)
+#define SERIAL_AWAKE_MS 10000               // หลังพิมพ์ ไม่ tick sleep ช่วงนี้ (UART หยุดรับขณะหลับ)
+
+static const SchedPeriods schedPeriods = {HEARTBEAT_MS, BUZZER_TOGGLE_MS, WDT_FEED_MS, BUTTON_POLL_MS};
+
+SchedNext loopNextDeadline(int64_t nowUs) {
+  int64_t roomAtUs = panel.nextDeadlineUs();
+  SchedInputs in;
+  in.nowMs              = (uint32_t)(nowUs / 1000);
+  in.roomWaitMs         = roomAtUs == ROOM_NO_DEADLINE ? SCHED_NEVER
+                        : roomAtUs <= nowUs            ? 0
+                        : (uint32_t)((roomAtUs - nowUs + 999) / 1000);   // ปัดขึ้น ไม่ตื่นก่อนครบ
+  in.blinkMs            = (oledOn && cleaningRequired) ? OLED_BLINK_MS : 0;
+  in.lastBeatMs         = lastBeat;
+  in.buzzerActive       = cleaningRequired;
+  in.lastBuzzerToggleMs = lastBuzzerToggle;
+  in.lastFeedMs         = lastFeedPrint;
+  in.buttonBusy         = resetButton.busy(digitalRead(RESET_BTN) == HIGH);
+  return schedNextDeadline(in, schedPeriods);
+}
+
+/* light sleep นานสุด waitMs (หรือจนกว่าขาใดเปลี่ยน) */
+void tickSleep(uint32_t waitMs, uint8_t reason) {
+  // ระดับขาที่ state machine รู้ตอนนี้ -> ปลุกเมื่อขาใดต่างไปจากนี้
+  uint8_t pins[Panel::kEdgePinCount];
+  uint8_t levels[Panel::kEdgePinCount];
+  Panel::edgePins(pins);
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    levels[i]              = panel.pirHigh[i] ? HIGH : LOW;
+    levels[ROOM_COUNT + i] = panel.doorLevelHigh(i) ? HIGH : LOW;
+  }
+  if (!edgeSleepArm(pins, levels, Panel::kEdgePinCount)) return;   // มี edge เข้ามาพอดี -> ไม่หลับ
+  gpio_intr_disable((gpio_num_t)RESET_BTN);                         // wakeup แบบ level ใช้ตัวเดียวกับ interrupt
+  gpio_wakeup_enable((gpio_num_t)RESET_BTN, GPIO_INTR_HIGH_LEVEL);  // ปุ่มว่าง (LOW) -> กดแล้วตื่น
+
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_uart_wakeup(UART_NUM_0);   // พิมพ์ทาง Serial -> ตื่น (ตัวอักษรแรก ๆ หายได้)
+  esp_sleep_enable_timer_wakeup((uint64_t)waitMs * 1000ULL);
+
+  int64_t t0 = esp_timer_get_time();
+  esp_light_sleep_start();
+  int64_t t1 = esp_timer_get_time();
+  bool byGpio = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+
+  gpio_wakeup_disable((gpio_num_t)RESET_BTN);
+  gpio_set_intr_type((gpio_num_t)RESET_BTN, GPIO_INTR_ANYEDGE);
+  gpio_intr_enable((gpio_num_t)RESET_BTN);
+  edgeSleepDisarm(pins, levels, Panel::kEdgePinCount, t1);   // ขาที่เปลี่ยนระหว่างหลับ -> edge เวลา t1
+
+#if TICK_SLEEP_ASSOCIATED
+  beaconNoteWake(beaconWindow, (uint32_t)(t1 / 1000));
+#endif
+  sleepStatsAdd(sleepStats, (uint64_t)(t1 - t0), byGpio, reason);
+}
+
+void waitForNextDeadline(int64_t nowUs) {
+  SchedNext next = loopNextDeadline(nowUs);
+  if (next.waitMs == 0) return;
+
+  bool consoleActive = millis() - lastSerialRxMs < SERIAL_AWAKE_MS;   // กำลังพิมพ์คำสั่ง -> ไม่หลับ
+  bool associated = WiFi.status() == WL_CONNECTED;
+#if TICK_SLEEP_ASSOCIATED
+  uint32_t nowMs = (uint32_t)(nowUs / 1000);
+  beaconNoteAwake(beaconWindow, nowMs, BEACON_LISTEN_MS);
+  TickPlan plan = tickSleepPlan(next, netBusy(), associated, beaconWindow, nowMs,
+                                BEACON_BUDGET_MS, BEACON_LISTEN_MS, TICK_SLEEP_MIN_MS);
+#else
+  TickPlan plan = {next.waitMs, tickSleepAllowed(next, netBusy(), associated, TICK_SLEEP_MIN_MS)};
+#endif
+  if (consoleActive || !plan.sleep) {
+    // หลับไม่ได้ (รอสั้น/เน็ตกำลังส่ง/ต่อ AP อยู่) -> รอ edge; ขา PIR/ประตู/ปุ่มมี interrupt ปลุก
+    edgeWait(plan.waitMs);
+    return;
+  }
+  tickSleep(plan.waitMs, next.reason);
+}
+
+/* ====== คำสั่งทาง Serial: "perf" = สรุปเวลาแต่ละขั้น, "perf reset" = ล้างสถิติ ====== */
+#define SERIAL_CMD_MAX  32
+
+/* คัดลอกตัวนับอื่นของเครื่องมาไว้คู่กับ histogram (ใช้ทั้ง Serial และ payload) */
+void perfSnapshotCounters() {
+  perf.counters.flashWrites   = persistLogFlashWrites();
+  perf.counters.i2cBytes      = oledStats.bytes;
+  perf.counters.awakePermille = sleepStatsAwakePermille(sleepStats, (uint64_t)esp_timer_get_time());
+  perf.counters.sleeps        = sleepStats.sleeps;
+}
+
+void printPerf() {
+  perfSnapshotCounters();
+  Serial.println("[PERF] stage      n      p50us     p99us     maxus     avgus");
+  for (uint8_t s = 0; s < PERF_STAGES; s++) {
+    const PerfHist &h = perf.stage[s];
+    Serial.printf("[PERF] %-5s %8lu %9lu %9lu %9lu %9lu\n", perfStageNames[s],
+                  (unsigned long)h.count,
+                  (unsigned long)perfPercentileUs(h, 0.50), (unsigned long)perfPercentileUs(h, 0.99),
+                  (unsigned long)h.maxUs,
+                  (unsigned long)(h.count ? h.sumUs / h.count : 0));
+  }
+  Serial.printf("[PERF] wdt near-miss=%lu (>= %d%% of %ds) max gap=%lums\n",
+                (unsigned long)perf.wdtNearMiss, PERF_WDT_NEAR_PCT, WDT_TIMEOUT_SEC,
+                (unsigned long)perf.wdtMaxGapMs);
+  Serial.printf("[PERF] flash writes=%lu  i2c bytes=%lu  awake %lu.%lu%%  sleeps=%lu\n",
+                (unsigned long)perf.counters.flashWrites, (unsigned long)perf.counters.i2cBytes,
+                (unsigned long)(perf.counters.awakePermille / 10),
+                (unsigned long)(perf.counters.awakePermille % 10),
+                (unsigned long)perf.counters.sleeps);
+  Serial.printf("[PERF] wifi fast ok=%lu fail=%lu (max %lums)  full ok=%lu fail=%lu (max %lums)\n",
+                (unsigned long)wifiStats.fastOk, (unsigned long)wifiStats.fastFail,
+                (unsigned long)wifiStats.fastMaxMs,
+                (unsigned long)wifiStats.fullOk, (unsigned long)wifiStats.fullFail,
+                (unsigned long)wifiStats.fullMaxMs);
+  // endpoint ถูกอัปเดตใน net task: เป็นแค่ภาพรวม อาจคลาดเคลื่อนเล็กน้อย
+  httpPrintStats(backendEndpoint());
+  httpPrintStats(lineEndpoint());
+  lineDispatchPrintStats();
+}
+
+/* อ่าน Serial แบบไม่บล็อก สะสมทีละบรรทัด */
+void pollSerialCommands() {
+  static char line[SERIAL_CMD_MAX];
+  static uint8_t len = 0;
+
+  while (Serial.available() > 0) {
+    char c = (char)Serial.read();
+    lastSerialRxMs = millis();
+    if (c != '\n' && c != '\r') {
+      if (len < SERIAL_CMD_MAX - 1) line[len++] = c;
+      continue;
+    }
+    if (len == 0) continue;
+    line[len] = '\0';
+    len = 0;
+
+    if (strcmp(line, "perf") == 0) {
+      printPerf();
+    } else if (strcmp(line, "perf reset") == 0) {
+      perfReset();
+      netKick();               // net task ล้างขั้น http/line/wifi ของตัวเองเมื่อตื่น
+      Serial.println("[PERF] reset");
+    } else {
+      Serial.printf("[CMD] unknown '%s' (perf | perf reset)\n", line);
+    }
+  }
 }
 
 /* ====== setup(): ตั้งค่าฮาร์ดแวร์และวอร์มระบบ ====== */
@@ -517,11 +555,19 @@ void setup() {
   else                                     Serial.println("[BOOT] Power-on/reset");
 
   // ตั้งโหมดขาต่าง ๆ
-  pinMode(PIR1, INPUT); pinMode(PIR2, INPUT); pinMode(PIR3, INPUT);
-  pinMode(LED1, OUTPUT); pinMode(LED2, OUTPUT); pinMode(LED3, OUTPUT);
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    pinMode(PanelPins::pir[i], INPUT);
+    pinMode(PanelPins::led[i], OUTPUT);
+    pinMode(PanelPins::door[i], INPUT);   // ⚠️ ต้องมี pull-up ภายนอกสำหรับ reed
+  }
   pinMode(RESET_BTN, INPUT); // ⚠️ ต้องมีตัวต้านทาน pull-down ภายนอกจริง
-  
-  pinMode(DOOR1, INPUT); pinMode(DOOR2, INPUT); pinMode(DOOR3, INPUT); // ⚠️ ต้องมี pull-up ภายนอกสำหรับ reed
+
+  // จับขอบ PIR + ประตูด้วย interrupt แล้วอ่านระดับเริ่มต้นจากขาจริง
+  uint8_t edgePins[Panel::kEdgePinCount];
+  Panel::edgePins(edgePins);
+  edgeCaptureBegin(edgePins, Panel::kEdgePinCount);
+  edgeWakeOnChange(RESET_BTN);   // กดปุ่ม -> loop ตื่นมาอ่านทันที (รอ deadline ได้เต็ม ๆ)
+  resyncRoomInputs(esp_timer_get_time());
 
   // ปิด buzzer ไว้ก่อน
   buzzerOff();
@@ -537,25 +583,22 @@ void setup() {
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(30,28);
     display.println(F("System Ready"));
-    display.display();
+    oledPush();
     delay(800);
   }
 
-  // สร้าง mirror โครงสร้างส่ง backend สำหรับทั้ง 3 ห้อง
-  mirrorRoomToBackendStruct(0,PIR1,LED1);
-  mirrorRoomToBackendStruct(1,PIR2,LED2);
-  mirrorRoomToBackendStruct(2,PIR3,LED3);
+  // เตรียม journal เหตุการณ์ (event ที่ค้างจากก่อนหลับ/รีบูตจะถูกส่งเมื่อเน็ตพร้อม)
+  journalInit();
 
   // โหลดตัวนับที่เคยบันทึก (ถ้ามี) + คำนวณธงรวม
   loadPersistIntoRuntime();
   updateCleaningRequiredFlag();
 
-  // ส่ง snapshot เริ่มต้นไป backend (เพื่อแสดงสถานะทันที)
-  refreshReportSnapshotFromRuntime();
-  sendStatusImmediately();
+  // ส่ง snapshot เริ่มต้นไป backend (เพื่อแสดงสถานะทันที) — net task จะหยิบไปส่งเมื่อเริ่มทำงาน
+  netRequestStatus();
 
   // บันทึกเวลาตอนบูต/ตื่น
-  bootAtMs   = millis();
+  resetButton.bootAtMs = millis();
   lastWakeMs = millis();
 
   /* ---------- Watchdog init (กันค้าง) ----------
@@ -580,27 +623,30 @@ void setup() {
     }
   }
 
+  // เริ่ม task เครือข่าย (หลัง WDT init เพื่อให้ task นี้ add ตัวเองเข้า watchdog ได้)
+  netTaskStart();
+
   Serial.println("=== Smart Restroom (LINE Alerts + Persist + Sleep + WDT) ===");
 }
 
 /* ====== loop(): วนหลักของระบบ ======
  * ลำดับหลัก:
- * 1) อ่านสถานะประตู → อัปเดตแต่ละห้อง (PIR + ประตู) → เช็คปุ่ม reset
+ * 1) ดึง edge PIR/ประตูจาก ISR → อัปเดตแต่ละห้อง → เช็คปุ่ม reset
  * 2) ถ้าตื่นจาก RTC timer -> ส่ง heartbeat (backend + LINE)
- * 3) วาดจอทุก ~250ms
+ * 3) เช็คจอ (วาด/ส่งเฉพาะส่วนที่เปลี่ยน)
  * 4) ส่ง heartbeat ปกติทุก 10s (ตอนที่ยัง active)
  * 5) ควบคุม buzzer เมื่อถึงเกณฑ์ทำความสะอาด
- * 6) พิจารณาเข้าหลับถ้าว่างนาน
+ * 6) พิจารณาเข้าหลับยาวถ้าว่างนาน
  * 7) feed watchdog ให้แน่ใจว่าไม่ค้าง
+ * 8) รอ/หลับสั้น ๆ จนถึง deadline ถัดไปหรือมี edge
  */
 void loop() {
-  unsigned long now = millis();
+  int64_t nowUs = esp_timer_get_time();
+  unsigned long now = (unsigned long)(nowUs / 1000);   // ฐานเวลาเดียวกับ millis()
+  uint64_t sleptAtStart = sleepStats.sleptUs;           // ไม่นับเวลาหลับในขั้น 6 เป็นงานของ loop
 
-  /* 1) อ่านประตู + อัปเดต 3 ห้อง */
-  readAllDoors();
-  updateRoom(0, PIR1, LED1, now);
-  updateRoom(1, PIR2, LED2, now);
-  updateRoom(2, PIR3, LED3, now);
+  /* 1) ดึง edge PIR/ประตูจาก ISR -> อัปเดตทุกห้อง (เวลาแม่นระดับ us) */
+  processRoomInputs(nowUs);
 
   // ปุ่มรีเซ็ตแบบ double click
   if (readButtonDoublePressed()) {
@@ -612,40 +658,25 @@ void loop() {
     heartbeatOnWake = false;
 
     updateCleaningRequiredFlag();
-    refreshReportSnapshotFromRuntime();
-    sendStatusImmediately(); // ส่ง backend
+    netRequestStatus(); // ส่ง backend
 
     // แจ้ง LINE แบบย่อ (ถ้าไม่อยากให้เด้งบ่อยสามารถคอมเมนต์บล็อกนี้ออก)
-    wifiEnsure();
-    notifyHeartbeatSummary(
-      cleaningRequired,
-      rooms[0].useCount,
-      rooms[1].useCount,
-      rooms[2].useCount
-    );
+    netNotifyHeartbeatSummary(cleaningRequired);
   }
 
-  /* 3) วาดจอทุก ~250ms */
-  static unsigned long lastDraw=0;
-  if (oledOn && millis()-lastDraw>250) {
-    if (cleaningRequired) drawCleaningOverlay();
-    else                  drawMainPage();
-    lastDraw = millis();
+  /* 3) เช็คจอทุกรอบ (เทียบ model ถูกมาก): วาด/ส่งเฉพาะเมื่อสิ่งที่แสดงเปลี่ยน
+   *    กรอบกระพริบของหน้าทำความสะอาดมี deadline ของตัวเองใน scheduler */
+  if (oledOn) {
+    drawDisplayIfChanged();
   }
 
   /* 4) heartbeat ปกติทุก 10s (เฉพาะช่วงที่ยัง active และไม่ติดธง cleaning) */
-  static unsigned long lastBeat=0;
-  if (millis()-lastBeat>10000UL) {
+  if (schedDueIn(millis(), lastBeat, HEARTBEAT_MS) == 0) {
     lastBeat = millis();
 
-    unsigned long lastAnyMotion =
-      max(room[0].lastMotionMs, max(room[1].lastMotionMs, room[2].lastMotionMs));
-    bool idleTooLong = (millis()-lastAnyMotion >= SLEEP_IDLE_MS);
-
-    if (!idleTooLong && !cleaningRequired) {
+    if (heartbeatSendsStatus(millis(), lastAnyMotionMs(), cleaningRequired, SLEEP_IDLE_MS)) {
       updateCleaningRequiredFlag();
-      refreshReportSnapshotFromRuntime();
-      sendStatusImmediately();
+      netRequestStatus();
     }
   }
 
@@ -663,17 +694,27 @@ void loop() {
     buzzerState=false;
   }
 
-  /* 6) ลองเข้าหลับ ถ้าระบบว่างนานพอ */
-  maybeEnterLightSleep(now);
-
-  /* 7) Feed Watchdog: แสดง log ทุก ~2s และรีเฟรช watchdog ทุกลูป */
-  static unsigned long lastFeedPrint = 0;
-  if (millis() - lastFeedPrint > 2000) {
-    Serial.println("[WDT] feed watchdog");
+  /* 6) ลองเข้าหลับยาว ถ้าระบบว่างนานพอ (ตื่นมาแล้วให้ loop รอบใหม่จัดการก่อน) */
+  bool sleptIdle = maybeEnterLightSleep(now);
+
+  /* 7) Feed Watchdog: รีเฟรชทุกลูป + log สถิติการหลับทุก WDT_FEED_MS */
+  if (millis() - lastFeedPrint >= WDT_FEED_MS) {
+    uint32_t awake = sleepStatsAwakePermille(sleepStats, (uint64_t)esp_timer_get_time());
+    Serial.printf("[WDT] feed watchdog | awake %lu.%lu%% sleeps=%lu (gpio=%lu timer=%lu)\n",
+                  (unsigned long)(awake / 10), (unsigned long)(awake % 10),
+                  (unsigned long)sleepStats.sleeps, (unsigned long)sleepStats.wakeGpio,
+                  (unsigned long)sleepStats.wakeTimer);
+    perfSnapshotCounters();
     lastFeedPrint = millis();
   }
+  perfWdtFeed(esp_timer_get_time(), sleepStats.sleptUs, WDT_TIMEOUT_SEC * 1000);
   esp_task_wdt_reset();
 
-  // เวลาหน่วงสั้น ๆ เพื่อให้ loop ไม่หนักเกินไป
-  delay(5);
+  pollSerialCommands();
+
+  int64_t workUs = (esp_timer_get_time() - nowUs) - (int64_t)(sleepStats.sleptUs - sleptAtStart);
+  perfRecord(PERF_LOOP, workUs > 0 ? (uint32_t)workUs : 0);
+
+  /* 8) รอถึง deadline ถัดไป (หลับถ้าคุ้ม) — ตื่นเมื่อมี edge/ปุ่ม หรือครบกำหนด */
+  if (!sleptIdle) waitForNextDeadline(esp_timer_get_time());
 }
\ No newline at end of file
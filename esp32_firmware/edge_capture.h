@@ -0,0 +1,173 @@
+#ifndef EDGE_CAPTURE_H
+#define EDGE_CAPTURE_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "soc/soc.h"        // REG_READ
+#include "soc/gpio_reg.h"   // GPIO_IN_REG / GPIO_IN1_REG
+#include "driver/gpio.h"    // gpio_wakeup_enable() สำหรับปลุกจาก light sleep
+
+/* =========================================================
+ * จับขอบสัญญาณ PIR/รีดสวิตช์ด้วย interrupt (แทนการ poll digitalRead ทุก 5ms)
+ *
+ * - ISR อ่านระดับขาจาก register ตรง ๆ + เวลา esp_timer_get_time() (ความละเอียด us)
+ *   แล้วใส่ลง ring buffer ขนาดคงที่ จากนั้นปลุก task ที่รออยู่ (loop)
+ * - loop() ดึง event ออกมาตามลำดับเวลาแล้วป้อนเข้า state machine ของห้อง
+ *   -> ได้เวลาเริ่ม/จบ session ระดับ us และไม่พลาดพัลส์ประตูเปิดสั้น ๆ แม้ loop ช้า
+ * - ถ้า ring ล้น (event ถี่ผิดปกติ) จะตั้งธง overflow ให้ loop resync จากระดับขาจริง
+ * - ช่วงไม่มี event loop รอด้วย edgeWait() (block) แทน delay() ทำให้ CPU ได้พัก
+ * - รอนานพอ -> light sleep: edgeSleepArm() ปลุกเมื่อขาใดต่างจากระดับที่รู้,
+ *   edgeSleepDisarm() ใส่ edge สังเคราะห์ของขาที่เปลี่ยนระหว่างหลับ
+ * - ขาที่ loop อ่านเอง (ปุ่ม) ผูกด้วย edgeWakeOnChange(): ไม่ลงคิว แค่ปลุก loop ที่รออยู่
+ * ========================================================= */
+
+struct EdgeEvent {
+  int64_t tUs;     // esp_timer_get_time() ตอนเกิดขอบ
+  uint8_t pin;
+  uint8_t level;   // ระดับ "หลัง" เปลี่ยน (HIGH/LOW)
+};
+
+#define EDGE_QUEUE_LEN 64          // ต้องเป็นกำลังสองของ 2
+
+static EdgeEvent edgeQueue[EDGE_QUEUE_LEN];
+static volatile uint32_t edgeHead = 0;      // เขียนใน ISR เท่านั้น
+static volatile uint32_t edgeTail = 0;      // เขียนใน loop เท่านั้น
+static volatile bool     edgeOverflow = false;
+static portMUX_TYPE      edgeMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t      edgeWaiter = nullptr;
+
+/* อ่านระดับขาใน ISR (digitalRead ไม่รับประกันว่าอยู่ใน IRAM) */
+static inline int IRAM_ATTR edgeReadPinIsr(uint8_t pin) {
+  if (pin < 32) return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+  return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+}
+
+/* ปลุก task ที่รออยู่ใน edgeWait() */
+static inline void IRAM_ATTR edgeNotifyIsr() {
+  if (edgeWaiter) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(edgeWaiter, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+}
+
+static void IRAM_ATTR edgeIsr(void *arg) {
+  uint8_t pin = (uint8_t)(uintptr_t)arg;
+  int64_t t   = esp_timer_get_time();
+  uint8_t lvl = (uint8_t)edgeReadPinIsr(pin);
+
+  portENTER_CRITICAL_ISR(&edgeMux);
+  uint32_t head = edgeHead;
+  if (head - edgeTail < EDGE_QUEUE_LEN) {
+    EdgeEvent &e = edgeQueue[head & (EDGE_QUEUE_LEN - 1)];
+    e.tUs   = t;
+    e.pin   = pin;
+    e.level = lvl;
+    edgeHead = head + 1;
+  } else {
+    edgeOverflow = true;
+  }
+  portEXIT_CRITICAL_ISR(&edgeMux);
+
+  edgeNotifyIsr();
+}
+
+/* ขาเปลี่ยนแต่ไม่ต้องเก็บ edge: ปลุก loop ให้อ่านระดับขาเอง */
+static void IRAM_ATTR edgeWakeIsr(void *) {
+  edgeNotifyIsr();
+}
+
+/* ผูก interrupt แบบ CHANGE ให้ทุกขาในรายการ (เรียกจาก setup() ซึ่งรันใน loopTask) */
+static inline void edgeCaptureBegin(const uint8_t *pins, size_t count) {
+  edgeWaiter = xTaskGetCurrentTaskHandle();
+  for (size_t i = 0; i < count; i++) {
+    attachInterruptArg(pins[i], edgeIsr, (void *)(uintptr_t)pins[i], CHANGE);
+  }
+}
+
+/* ผูก interrupt แบบ CHANGE ที่ปลุก loop เท่านั้น (เรียกหลัง edgeCaptureBegin()) */
+static inline void edgeWakeOnChange(uint8_t pin) {
+  attachInterruptArg(pin, edgeWakeIsr, nullptr, CHANGE);
+}
+
+/* ดึง event เก่าสุด คืน false ถ้าว่าง */
+static inline bool edgePop(EdgeEvent &out) {
+  bool ok = false;
+  portENTER_CRITICAL(&edgeMux);
+  if (edgeTail != edgeHead) {
+    out = edgeQueue[edgeTail & (EDGE_QUEUE_LEN - 1)];
+    edgeTail = edgeTail + 1;
+    ok = true;
+  }
+  portEXIT_CRITICAL(&edgeMux);
+  return ok;
+}
+
+/* คืน true ครั้งเดียวหลังเกิด overflow (ผู้เรียกต้อง resync ระดับขาเอง) */
+static inline bool edgeTakeOverflow() {
+  portENTER_CRITICAL(&edgeMux);
+  bool o = edgeOverflow;
+  edgeOverflow = false;
+  portEXIT_CRITICAL(&edgeMux);
+  return o;
+}
+
+/* รอจนมี event ใหม่ หรือครบ timeoutMs (แทน delay() ท้าย loop) */
+static inline void edgeWait(uint32_t timeoutMs) {
+  if (edgeHead != edgeTail) return;
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+/* ใส่ edge ลงคิวจาก task (ใช้ตอนตื่นจาก light sleep ที่ปิด interrupt ไว้) */
+static inline void edgeInject(uint8_t pin, uint8_t level, int64_t tUs) {
+  portENTER_CRITICAL(&edgeMux);
+  uint32_t head = edgeHead;
+  if (head - edgeTail < EDGE_QUEUE_LEN) {
+    EdgeEvent &e = edgeQueue[head & (EDGE_QUEUE_LEN - 1)];
+    e.tUs   = tUs;
+    e.pin   = pin;
+    e.level = level;
+    edgeHead = head + 1;
+  } else {
+    edgeOverflow = true;
+  }
+  portEXIT_CRITICAL(&edgeMux);
+}
+
+/*
+ * เตรียม light sleep: ปิด interrupt แบบ CHANGE แล้วตั้งปลุกแบบ level ที่ "ตรงข้าม"
+ * กับระดับที่ state machine รู้ (levels[i]) -> ขอบใดก็ตามระหว่างหลับปลุกได้ทันที
+ * และถ้าขาเปลี่ยนไปแล้วก่อนหลับ ก็ตื่นทันทีเช่นกัน (ไม่มีช่องโหว่ระหว่างตรวจกับหลับ)
+ * คืน false (และยกเลิกการตั้งค่า) ถ้ามี edge ค้างในคิว -> ผู้เรียกไม่ควรหลับ
+ */
+static inline bool edgeSleepArm(const uint8_t *pins, const uint8_t *levels, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    gpio_intr_disable((gpio_num_t)pins[i]);
+  }
+  if (edgeHead != edgeTail) {
+    for (size_t i = 0; i < count; i++) gpio_intr_enable((gpio_num_t)pins[i]);
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    gpio_wakeup_enable((gpio_num_t)pins[i], levels[i] ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  }
+  return true;
+}
+
+/*
+ * หลังตื่น: ขาที่ระดับต่างจากก่อนหลับ -> ใส่ edge สังเคราะห์ (เวลา = wakeUs)
+ * แล้วคืน interrupt แบบ CHANGE ให้ทุกขา (ลำดับนี้ทำให้ edge จริงหลังจากนี้มีเวลาใหม่กว่าเสมอ)
+ */
+static inline void edgeSleepDisarm(const uint8_t *pins, const uint8_t *levels, size_t count, int64_t wakeUs) {
+  for (size_t i = 0; i < count; i++) {
+    gpio_wakeup_disable((gpio_num_t)pins[i]);
+    uint8_t lvl = (uint8_t)edgeReadPinIsr(pins[i]);
+    if (lvl != levels[i]) edgeInject(pins[i], lvl, wakeUs);
+  }
+  for (size_t i = 0; i < count; i++) {
+    gpio_set_intr_type((gpio_num_t)pins[i], GPIO_INTR_ANYEDGE);
+    gpio_intr_enable((gpio_num_t)pins[i]);
+  }
+}
+
+#endif
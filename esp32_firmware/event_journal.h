@@ -0,0 +1,258 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "esp_attr.h"           // RTC_DATA_ATTR
+#include "journal_event.h"      // JournalEvent / JEV_* (ไม่พึ่ง Arduino.h)
+
+/* =========================================================
+ * Event journal (store-and-forward)
+ *
+ * เดิม: ถ้า Wi-Fi หลุด sendStatusImmediately() จะ "skip send" แล้วข้อมูลหายไปเลย
+ * ตอนนี้: ทุกเหตุการณ์ (เริ่ม/จบ session, รีเซ็ต) ถูกจดลง ring buffer ขนาดคงที่
+ * - ring อยู่ใน RTC RAM (อยู่รอดตอน light sleep)
+ * - ถ้า ring ใกล้เต็ม (ออฟไลน์นาน) net task ย้ายก้อนเก่าสุดไปต่อท้ายใน NVS
+ *   ก้อนละ 1 key ("journal"/"s0".."s7" วนใช้) + meta เล็ก ๆ ("smeta": ก้อนแรก/ถัดไป/offset)
+ *   ส่งสำเร็จแล้วแค่เลื่อน offset หรือลบ key ของก้อนนั้น (ไม่เขียนทั้งก้อนใหญ่ใหม่)
+ * - เมื่อต่อเน็ตได้ net task จะดึงออกเป็นชุด (batch) แล้วส่งครั้งเดียว
+ *   ลำดับการดึง: spill ใน NVS ก่อน (เก่ากว่า) แล้วค่อย ring ใน RTC
+ * - ลบออกจาก journal ก็ต่อเมื่อ backend ตอบ ok แล้วเท่านั้น (at-least-once)
+ * - seq/tsMs นับใหม่เมื่อไฟดับ (RTC RAM หาย) -> ทุก event มี boot id (ตัวนับการบูตใน NVS)
+ *   backend กันซ้ำด้วย (device_id, boot_id, seq) และคำนวณอายุเฉพาะ event ของบูตปัจจุบัน
+ *   seq สูงสุดที่เคยออกถูกเก็บใน NVS คู่กับ spill -> บูตใหม่ seq เดินต่อ ไม่ย้อนกลับไปซ้ำกับใน spill
+ *
+ * loop() เป็นผู้เขียน (ต่อท้าย ring เท่านั้น), net task เป็นผู้อ่าน/ย้ายลง NVS (เลื่อน head เท่านั้น)
+ * - ring ป้องกันด้วย critical section สั้น ๆ (แค่คัดลอก/เลื่อน index) -> loop ไม่เคยรอ
+ * - loop ไม่แตะ NVS เลย; net task คัดลอกออกมาก่อนแล้วค่อยเขียนแฟลชนอก critical section
+ * - ring เต็มจริง (net task ตามไม่ทัน) -> loop ทิ้ง event ใหม่แล้วนับไว้ (seq ยังเดิน backend เห็นช่องว่าง)
+ * ========================================================= */
+
+#define JOURNAL_SPILL_AT    (JOURNAL_RTC_LEN - JOURNAL_SPILL_CHUNK)  // ring ถึงเท่านี้ -> net task ย้ายก้อนเก่าสุด
+#define JOURNAL_SPILL_SLOTS (JOURNAL_SPILL_MAX / JOURNAL_SPILL_CHUNK)  // จำนวน key ที่วนใช้ (ไม่เกิน 10)
+#define JOURNAL_MAGIC       0x4A524E4C  // "JRNL"
+
+static_assert(JOURNAL_SPILL_SLOTS <= 10, "spill key is 's' + one digit");
+
+typedef struct {
+  uint32_t magic;
+  uint32_t nextSeq;
+  uint16_t bootId;      // ตัวนับการบูตจาก NVS ("journal"/"boot") เพิ่มทุกครั้งที่ RTC RAM หาย
+  uint16_t head;        // index ของ event เก่าสุด
+  uint16_t count;       // จำนวน event ใน ring
+  uint32_t dropped;     // จำนวน event ที่ต้องทิ้ง (ring เต็ม หรือ NVS เต็มด้วย)
+  JournalEvent ev[JOURNAL_RTC_LEN];
+} JournalRtc;
+
+/* ตำแหน่ง spill ใน NVS: ก้อน index head..tail-1 อยู่ใน key "s<index % SLOTS>" */
+typedef struct {
+  uint32_t head;        // ก้อนเก่าสุด
+  uint32_t tail;        // ก้อนถัดไปที่จะเขียน
+  uint16_t off;         // event ในก้อน head ที่ส่งสำเร็จแล้ว
+  uint16_t reserved;
+  uint32_t seqHw;       // nextSeq ตอนเขียน spill ล่าสุด (>= seq ทุกตัวใน NVS)
+} JournalSpillMeta;
+
+RTC_DATA_ATTR JournalRtc journalRTC = {};
+static portMUX_TYPE journalMux = portMUX_INITIALIZER_UNLOCKED;   // ring ใน RTC (loop <-> net task)
+static Preferences journalPrefs;                                 // NVS: setup() และ net task เท่านั้น
+static JournalSpillMeta journalSpill = {};
+static uint16_t journalSpillCount = 0;                   // จำนวน event ที่ยังค้างใน NVS
+static JournalEvent journalChunkBuf[JOURNAL_SPILL_CHUNK]; // บัฟเฟอร์ 1 ก้อน (net task เท่านั้น)
+static bool journalPeekedSpill = false;                  // batch ล่าสุดมาจาก NVS หรือ ring
+
+/* ===== NVS spill (net task เท่านั้น; ทุกฟังก์ชันในส่วนนี้เรียกขณะเปิด journalPrefs) ===== */
+static inline void journalSpillKey(char out[4], uint32_t chunk) {
+  out[0] = 's';
+  out[1] = (char)('0' + chunk % JOURNAL_SPILL_SLOTS);
+  out[2] = '\0';
+}
+
+static inline uint16_t journalSpillChunkLen(uint32_t chunk) {
+  char key[4];
+  journalSpillKey(key, chunk);
+  size_t n = journalPrefs.getBytesLength(key) / sizeof(JournalEvent);
+  return (uint16_t)min(n, (size_t)JOURNAL_SPILL_CHUNK);
+}
+
+static inline void journalSpillStoreMeta() {
+  journalPrefs.putBytes("smeta", &journalSpill, sizeof(journalSpill));
+}
+
+/* ลบก้อนเก่าสุดออกจาก NVS คืนจำนวน event ที่ยังไม่ได้ส่งในก้อนนั้น (ยังไม่เขียน meta) */
+static inline uint16_t journalSpillPopChunk() {
+  char key[4];
+  journalSpillKey(key, journalSpill.head);
+  uint16_t len = journalSpillChunkLen(journalSpill.head);
+  uint16_t left = len > journalSpill.off ? len - journalSpill.off : 0;
+  journalPrefs.remove(key);
+  journalSpill.head++;
+  journalSpill.off = 0;
+  journalSpillCount = journalSpillCount > left ? journalSpillCount - left : 0;
+  return left;
+}
+
+/* เรียกครั้งเดียวใน setup() ก่อนเริ่มจด event และก่อนเริ่ม net task */
+static inline void journalInit() {
+  journalPrefs.begin("journal", false);
+  if (journalPrefs.getBytesLength("smeta") == sizeof(journalSpill)) {
+    journalPrefs.getBytes("smeta", &journalSpill, sizeof(journalSpill));
+  }
+
+  if (journalRTC.magic != JOURNAL_MAGIC) {
+    // RTC RAM หาย (ไฟดับ/brown-out/แฟลชใหม่) -> บูตใหม่: boot id ใหม่, seq ต่อจาก high-water ใน NVS
+    memset(&journalRTC, 0, sizeof(journalRTC));
+    journalRTC.magic = JOURNAL_MAGIC;
+    uint16_t boot = (uint16_t)(journalPrefs.getUShort("boot", 0) + 1);
+    journalPrefs.putUShort("boot", boot);
+    journalRTC.bootId  = boot;
+    journalRTC.nextSeq = journalSpill.seqHw;
+  }
+
+  journalSpillCount = 0;
+  for (uint32_t c = journalSpill.head; c != journalSpill.tail; c++) {
+    uint16_t len = journalSpillChunkLen(c);
+    uint16_t skip = c == journalSpill.head ? journalSpill.off : 0;
+    journalSpillCount += len > skip ? len - skip : 0;
+  }
+  journalPrefs.end();
+  Serial.printf("[JOURNAL] boot=%u seq=%lu rtc=%u nvs=%u pending\n", journalRTC.bootId,
+                (unsigned long)journalRTC.nextSeq, journalRTC.count, journalSpillCount);
+}
+
+/* จด event ใหม่ (เรียกจาก loop) — แค่เขียน ring ใน RTC, ไม่รอใครและไม่แตะแฟลช */
+static inline void journalAppend(uint8_t kind, uint8_t room, uint32_t tsMs, uint32_t durMs) {
+  portENTER_CRITICAL(&journalMux);
+  uint32_t seq = journalRTC.nextSeq++;
+  bool full = journalRTC.count >= JOURNAL_RTC_LEN;
+  if (full) {
+    journalRTC.dropped++;
+  } else {
+    JournalEvent &e = journalRTC.ev[(journalRTC.head + journalRTC.count) % JOURNAL_RTC_LEN];
+    e.seq      = seq;
+    e.tsMs     = tsMs;
+    e.durMs    = durMs;
+    e.room     = room;
+    e.kind     = kind;
+    e.boot     = journalRTC.bootId;
+    journalRTC.count++;
+  }
+  portEXIT_CRITICAL(&journalMux);
+  if (full) Serial.printf("[JOURNAL] ring full, dropped seq=%lu\n", (unsigned long)seq);
+}
+
+static inline uint16_t journalBootId() {
+  return journalRTC.bootId;
+}
+
+static inline uint32_t journalPending() {
+  return (uint32_t)journalRTC.count + journalSpillCount;
+}
+
+/*
+ * ring ใกล้เต็ม (ออฟไลน์) -> ย้ายก้อนเก่าสุดลง NVS เป็น 1 key (net task เรียกทุกครั้งที่ตื่น)
+ * คัดลอกออกจาก ring ใน critical section แล้วเขียนแฟลชนอก critical section
+ * ตัดออกจาก ring หลังเขียนสำเร็จเท่านั้น (ไฟดับกลางทาง -> ส่งซ้ำได้ ซึ่ง backend กันไว้แล้ว)
+ * ระหว่างเขียน loop ต่อท้าย ring ได้ตามปกติ (head เลื่อนโดย net task เท่านั้น)
+ */
+static inline void journalSpillIfNeeded() {
+  while (journalRTC.count >= JOURNAL_SPILL_AT) {
+    JournalEvent *buf = journalChunkBuf;
+    portENTER_CRITICAL(&journalMux);
+    uint16_t head = journalRTC.head;
+    for (uint16_t i = 0; i < JOURNAL_SPILL_CHUNK; i++) {
+      buf[i] = journalRTC.ev[(head + i) % JOURNAL_RTC_LEN];
+    }
+    uint32_t seqHw = journalRTC.nextSeq;
+    portEXIT_CRITICAL(&journalMux);
+
+    journalPrefs.begin("journal", false);
+    uint16_t lost = 0;
+    if (journalSpill.tail - journalSpill.head >= JOURNAL_SPILL_SLOTS) {
+      lost = journalSpillPopChunk();           // NVS ก็เต็ม -> ทิ้งก้อนเก่าสุด
+    }
+    char key[4];
+    journalSpillKey(key, journalSpill.tail);
+    size_t put = journalPrefs.putBytes(key, buf, JOURNAL_SPILL_CHUNK * sizeof(JournalEvent));
+    if (put == JOURNAL_SPILL_CHUNK * sizeof(JournalEvent)) {
+      journalSpill.tail++;
+      journalSpill.seqHw = seqHw;
+    }
+    journalSpillStoreMeta();
+    journalPrefs.end();
+
+    portENTER_CRITICAL(&journalMux);
+    journalRTC.dropped += lost;
+    if (put == JOURNAL_SPILL_CHUNK * sizeof(JournalEvent)) {
+      journalRTC.head   = (head + JOURNAL_SPILL_CHUNK) % JOURNAL_RTC_LEN;
+      journalRTC.count -= JOURNAL_SPILL_CHUNK;
+    }
+    portEXIT_CRITICAL(&journalMux);
+
+    if (put != JOURNAL_SPILL_CHUNK * sizeof(JournalEvent)) {
+      Serial.println("[JOURNAL] NVS spill FAIL (kept in RTC)");
+      return;
+    }
+    journalSpillCount += JOURNAL_SPILL_CHUNK;
+    Serial.printf("[JOURNAL] spilled %u event(s) to NVS (nvs=%u, dropped=%u)\n",
+                  JOURNAL_SPILL_CHUNK, journalSpillCount, lost);
+  }
+}
+
+/* คัดลอก event เก่าสุดไม่เกิน maxCount ตัวออกมา (ยังไม่ลบ) คืนจำนวนที่ได้ — net task เท่านั้น */
+static inline uint16_t journalPeekBatch(JournalEvent *out, uint16_t maxCount) {
+  journalPeekedSpill = false;
+  if (journalSpillCount > 0) {
+    journalPrefs.begin("journal", false);
+    uint16_t n = 0;
+    while (n == 0 && journalSpill.head != journalSpill.tail) {
+      char key[4];
+      journalSpillKey(key, journalSpill.head);
+      uint16_t len = journalSpillChunkLen(journalSpill.head);
+      if (len > journalSpill.off) {
+        journalPrefs.getBytes(key, journalChunkBuf, len * sizeof(JournalEvent));
+        n = min((uint16_t)(len - journalSpill.off), maxCount);
+        memcpy(out, journalChunkBuf + journalSpill.off, n * sizeof(JournalEvent));
+      } else {
+        journalSpillPopChunk();                // ก้อนว่าง/เสีย -> ข้าม
+        journalSpillStoreMeta();
+      }
+    }
+    journalPrefs.end();
+    if (n > 0) {
+      journalPeekedSpill = true;
+      return n;
+    }
+    journalSpillCount = 0;
+  }
+
+  portENTER_CRITICAL(&journalMux);
+  uint16_t n = min(journalRTC.count, maxCount);
+  for (uint16_t i = 0; i < n; i++) {
+    out[i] = journalRTC.ev[(journalRTC.head + i) % JOURNAL_RTC_LEN];
+  }
+  portEXIT_CRITICAL(&journalMux);
+  return n;
+}
+
+/* ลบ n event ที่เพิ่ง peek ไป (เรียกเมื่อ backend ยืนยันแล้วเท่านั้น) — net task เท่านั้น */
+static inline void journalCommit(uint16_t n) {
+  if (journalPeekedSpill) {
+    // NVS: เลื่อน offset ในก้อน head (ส่งหมดก้อน -> ลบ key) แล้วเขียนแค่ meta
+    journalPrefs.begin("journal", false);
+    journalSpill.off += n;
+    journalSpillCount = journalSpillCount > n ? journalSpillCount - n : 0;
+    if (journalSpill.off >= journalSpillChunkLen(journalSpill.head)) journalSpillPopChunk();
+    journalSpillStoreMeta();
+    journalPrefs.end();
+  } else {
+    portENTER_CRITICAL(&journalMux);
+    n = min(n, journalRTC.count);
+    journalRTC.head  = (journalRTC.head + n) % JOURNAL_RTC_LEN;
+    journalRTC.count -= n;
+    portEXIT_CRITICAL(&journalMux);
+  }
+  journalPeekedSpill = false;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef HTTP_CONN_H
+#define HTTP_CONN_H
+
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "esp_task_wdt.h"
+
+/* =========================================================
+ * ตัวจัดการการเชื่อมต่อ HTTP แบบใช้ซ้ำ (keep-alive) สำหรับ backend และ LINE
+ *
+ * เดิม: ทุก POST สร้าง HTTPClient ใหม่ และ LINE ยัง new WiFiClientSecure
+ *       + TLS handshake เต็มทุกข้อความแล้ว delete -> ช้าและ heap กระตุก
+ * ตอนนี้:
+ * - 1 ปลายทาง (host) = 1 HttpEndpoint ที่ถือ socket + HTTPClient ไว้ตลอด (static, ไม่ new/delete)
+ *   HTTP/1.1 keep-alive: ถ้า server ไม่ปิด socket รอบถัดไปส่งต่อได้ทันที ไม่ต้อง connect/handshake ใหม่
+ * - ถ้า socket ที่ใช้ซ้ำตายไปแล้ว (server ปิดไปตอน idle) -> ปิดแล้วต่อใหม่และลองอีก 1 ครั้ง
+ *   - error ตอนส่งเอง (connect/ส่ง header/ส่ง body ไม่ผ่าน) -> server ยังไม่ได้ request ลองใหม่ได้เสมอ
+ *   - socket หลุดหลังส่ง body แล้ว (CONNECTION_LOST/NOT_CONNECTED) -> server อาจประมวลผลไปแล้ว
+ *     ลองใหม่เฉพาะ request ที่ส่งซ้ำได้ (idempotent: สถานะ/batch ที่ backend กันซ้ำด้วย seq,
+ *     push LINE ที่มี X-Line-Retry-Key -> LINE กันซ้ำเองแล้วตอบ 409)
+ * - เก็บ latency ต่อ request (ล่าสุด/เฉลี่ย/สูงสุด) + จำนวนครั้งที่ต้องเปิด socket ใหม่
+ * - HTTP_KEEPALIVE=0 -> ปิด socket ทุกครั้งแบบเดิม (ใช้เทียบ latency กับ server ทดสอบในเครื่อง)
+ *
+ * เรียกจาก net task เท่านั้น (ไม่มี lock)
+ * ========================================================= */
+
+#ifndef HTTP_KEEPALIVE
+#define HTTP_KEEPALIVE 1
+#endif
+
+#define HTTP_TIMEOUT_MS 5000
+
+struct HttpEndpoint {
+  const char *name;
+  WiFiClient *client;       // socket ถาวรของปลายทางนี้ (WiFiClient หรือ WiFiClientSecure)
+  HTTPClient  http;
+
+  // สถิติ
+  uint32_t requests;
+  uint32_t failures;        // code <= 0 หลังลองครบแล้ว
+  uint32_t newConns;        // ต้องเปิด socket ใหม่ (รวม TLS handshake ถ้าเป็น https)
+  uint32_t retries;         // socket เก่าตาย -> ต่อใหม่แล้วลองซ้ำ
+  uint32_t lastMs;
+  uint32_t maxMs;
+  uint64_t sumMs;
+};
+
+static inline void httpEndpointInit(HttpEndpoint &ep, const char *name, WiFiClient *client) {
+  ep.name   = name;
+  ep.client = client;
+  ep.http.setReuse(HTTP_KEEPALIVE != 0);
+  ep.http.setTimeout(HTTP_TIMEOUT_MS);
+  ep.requests = ep.failures = ep.newConns = ep.retries = 0;
+  ep.lastMs = ep.maxMs = 0;
+  ep.sumMs = 0;
+}
+
+/* error ที่เกิดก่อน server ได้รับ request ครบ -> ลองใหม่บน socket ใหม่ได้โดยไม่ซ้ำ */
+static inline bool httpErrorBeforeDelivery(int code) {
+  return code == HTTPC_ERROR_CONNECTION_REFUSED ||
+         code == HTTPC_ERROR_SEND_HEADER_FAILED ||
+         code == HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+}
+
+/* socket หลุดหลังส่ง request ไปแล้ว (รอ response) -> ไม่รู้ว่า server ได้รับหรือยัง */
+static inline bool httpErrorAfterSend(int code) {
+  return code == HTTPC_ERROR_NOT_CONNECTED ||
+         code == HTTPC_ERROR_CONNECTION_LOST;
+}
+
+/*
+ * POST body ไปที่ url ผ่าน socket ของ ep
+ * - authHeader: ค่า header Authorization (nullptr = ไม่ใส่)
+ * - extraName/extraValue: header เพิ่มอีก 1 ตัว เช่น X-Line-Retry-Key (nullptr = ไม่ใส่)
+ *   ใส่ค่าเดิมทุกครั้งที่ลองใหม่ภายใน และผู้เรียกส่งค่าเดิมมาอีกเมื่อส่งซ้ำทีหลัง
+ * - resp: รับ body ตอบกลับ (อ่านจนหมดเสมอเพื่อให้ socket ใช้ต่อได้)
+ * - idempotent: true = ส่งซ้ำได้ถ้า socket เก่าหลุดหลังส่งไปแล้ว (server ต้องกันซ้ำเอง)
+ * คืน HTTP code (<= 0 = ส่งไม่สำเร็จ)
+ */
+static inline int httpPost(HttpEndpoint &ep, const char *url,
+                           const uint8_t *body, size_t len,
+                           const char *authHeader, String &resp, bool idempotent,
+                           const char *extraName = nullptr, const char *extraValue = nullptr) {
+  uint32_t t0 = millis();
+  int code = 0;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = ep.client->connected();
+    if (!reused) ep.newConns++;
+
+    if (!ep.http.begin(*ep.client, url)) {
+      code = HTTPC_ERROR_CONNECTION_REFUSED;
+      break;
+    }
+    ep.http.addHeader("Content-Type", "application/json");
+    if (authHeader) ep.http.addHeader("Authorization", authHeader);
+    if (extraName && extraValue) ep.http.addHeader(extraName, extraValue);
+
+    code = ep.http.POST((uint8_t *)body, len);
+    esp_task_wdt_reset();   // ✅ กัน watchdog ตายขณะเน็ตอืด
+
+    if (code > 0) {
+      resp = ep.http.getString();
+      ep.http.end();        // keep-alive: socket ยังเปิดค้างไว้ใช้รอบหน้า
+      if (!HTTP_KEEPALIVE) ep.client->stop();
+      break;
+    }
+
+    ep.http.end();
+    ep.client->stop();      // socket เสีย -> ทิ้ง
+    if (!reused) break;
+    if (!httpErrorBeforeDelivery(code) && !(idempotent && httpErrorAfterSend(code))) break;
+    ep.retries++;           // socket ที่ใช้ซ้ำถูก server ปิดไปแล้ว -> ต่อใหม่อีกครั้ง
+  }
+
+  uint32_t dt = millis() - t0;
+  ep.requests++;
+  if (code <= 0) ep.failures++;
+  ep.lastMs = dt;
+  ep.sumMs += dt;
+  if (dt > ep.maxMs) ep.maxMs = dt;
+  return code;
+}
+
+static inline uint32_t httpAvgMs(const HttpEndpoint &ep) {
+  return ep.requests ? (uint32_t)(ep.sumMs / ep.requests) : 0;
+}
+
+static inline void httpPrintStats(const HttpEndpoint &ep) {
+  Serial.printf("[HTTP] %s: req=%lu fail=%lu newConn=%lu retry=%lu last=%lums avg=%lums max=%lums\n",
+                ep.name, (unsigned long)ep.requests, (unsigned long)ep.failures,
+                (unsigned long)ep.newConns, (unsigned long)ep.retries,
+                (unsigned long)ep.lastMs, (unsigned long)httpAvgMs(ep), (unsigned long)ep.maxMs);
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef JOURNAL_EVENT_H
+#define JOURNAL_EVENT_H
+
+#include <stdint.h>
+
+/* =========================================================
+ * ชนิดของ event ใน journal (event_journal.h) แยกออกมาให้ไม่พึ่ง Arduino.h
+ * -> payload batch (status_sync.h) และตัวยิงโหลดบน PC ใช้ struct เดียวกับบอร์ด
+ * ========================================================= */
+
+enum JournalKind : uint8_t {
+  JEV_START = 1,   // เริ่ม session (ห้อง room)
+  JEV_END   = 2,   // จบ session (durMs = ระยะเวลา)
+  JEV_RESET = 3,   // แม่บ้านรีเซ็ตตัวนับ (room = JOURNAL_ALL_ROOMS)
+};
+
+#define JOURNAL_ALL_ROOMS 0xFF
+#define JOURNAL_BATCH_MAX 32      // จำนวน event สูงสุดต่อ 1 POST
+
+/* ความจุ journal (ตัวยิงโหลดบน PC จำกัดคิวของแผงเสมือนเท่ากับบอร์ด) */
+#define JOURNAL_RTC_LEN     64    // ความจุใน RTC RAM (64 x 16B = 1KB)
+#define JOURNAL_SPILL_CHUNK 32    // ย้ายลง NVS ทีละเท่านี้ (1 key ต่อก้อน)
+#define JOURNAL_SPILL_MAX   256   // ความจุสูงสุดใน NVS (เกินนี้ทิ้งก้อนเก่าสุด)
+
+struct JournalEvent {
+  uint32_t seq;    // เลขลำดับเพิ่มขึ้นเรื่อย ๆ (ช่วยฝั่ง backend เรียง/ตรวจช่องว่าง)
+  uint32_t tsMs;   // millis() ตอนเกิดเหตุ
+  uint32_t durMs;  // เฉพาะ JEV_END
+  uint8_t  room;   // 0-based
+  uint8_t  kind;   // JournalKind
+  uint16_t boot;   // boot id ตอนจด (tsMs ใช้เทียบกันได้เฉพาะใน boot เดียวกัน)
+};
+
+#endif
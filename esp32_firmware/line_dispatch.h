@@ -0,0 +1,348 @@
+#ifndef LINE_DISPATCH_H
+#define LINE_DISPATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "status_json.h"        // JsonOut (payload ของ push)
+
+/* =========================================================
+ * ตัวจัดคิวแจ้งเตือน LINE: รวมหลายข้อความเป็น push เดียว + จำกัดอัตรา
+ *
+ * เดิม: notifyXxx() แต่ละตัว POST /v2/bot/message/push ทันที 1 ข้อความ/ครั้ง
+ *       -> หลายห้องถึงเกณฑ์พร้อมกัน = หลาย request ติดกัน เปลือง quota และโดน 429 ง่าย
+ * ตอนนี้:
+ * - ข้อความเข้าคิว (ขนาดคงที่, ไม่ malloc) พร้อมลำดับความสำคัญ
+ *   ทำความสะอาด > รีเซ็ต > heartbeat
+ * - รอ LINE_COALESCE_MS นับจากข้อความเก่าสุด ให้ข้อความอื่นมารวม แล้วส่งสูงสุด
+ *   LINE_BATCH_MAX (=5 ตามที่ API รับได้) ข้อความใน push เดียว เรียงตามความสำคัญ
+ *   (คิวเต็ม 5 แล้วไม่ต้องรอหน้าต่าง)
+ * - รวมของซ้ำ: heartbeat ค้างได้ตัวเดียว (ตัวใหม่แทนตัวเก่า), ห้องเดียวกันแจ้งซ้ำ -> แทนข้อความเดิม,
+ *   รีเซ็ต -> ทิ้งแจ้งเตือนทำความสะอาดที่ยังไม่ได้ส่ง (ล้างแล้ว ไม่ต้องเตือน)
+ * - heartbeat ที่ข้อความเหมือนครั้งล่าสุดที่ส่งสำเร็จ ข้ามได้จนกว่าจะครบ LINE_HEARTBEAT_REPEAT_MS
+ * - push ห่างกันอย่างน้อย LINE_MIN_INTERVAL_MS
+ * - 429 / 5xx / ส่งไม่ได้ -> เก็บข้อความไว้ แล้วถอยเวลาแบบทวีคูณ (LINE_BACKOFF_MIN_MS .. MAX)
+ *   4xx อื่น (payload/token ผิด) -> ทิ้งชุดนั้น เพราะส่งซ้ำก็ไม่ผ่าน
+ * - ทุกชุดมี X-Line-Retry-Key (UUID) ของตัวเอง: ส่งซ้ำ = ชุดเดิม key เดิม
+ *   ถ้าครั้งก่อน LINE รับไปแล้วแต่คำตอบหาย -> LINE ตอบ 409 แทนการส่งข้อความซ้ำให้ผู้ใช้
+ *   ข้อความในชุดที่ค้างส่งจึงถูกตรึงไว้ (ไม่ถูกแทน/ลบ) จนกว่าชุดนั้นจะจบ
+ *
+ * ลอจิกล้วน ไม่พึ่ง Arduino.h (เวลาเป็น ms จากผู้เรียก) — บนบอร์ดใช้จาก net task เท่านั้น
+ * ========================================================= */
+
+#define LINE_BATCH_MAX            5       // LINE push รับได้สูงสุด 5 ข้อความต่อครั้ง
+#define LINE_PENDING_MAX          8
+#ifndef LINE_TEXT_MAX
+#define LINE_TEXT_MAX             160     // byte (UTF-8) ต่อข้อความ รวม '\0' (send_to_line.h ขยายตาม ROOM_COUNT)
+#endif
+#define LINE_RETRY_KEY_LEN        37      // UUID "xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx" + '\0'
+#define LINE_COALESCE_MS          1500    // รอข้อความอื่นมารวม push
+#define LINE_MIN_INTERVAL_MS      1000    // push ห่างกันอย่างน้อยเท่านี้
+#define LINE_BACKOFF_MIN_MS       5000
+#define LINE_BACKOFF_MAX_MS       (5UL * 60UL * 1000UL)
+#define LINE_HEARTBEAT_REPEAT_MS  (6UL * 60UL * 60UL * 1000UL)   // heartbeat เหมือนเดิม ส่งซ้ำไม่ถี่กว่านี้
+#define LINE_NO_WAIT              0xFFFFFFFFu                     // คิวว่าง: ไม่มีอะไรต้องรอ
+
+enum LineMsgKind : uint8_t {
+  LINE_MSG_HEARTBEAT = 0,    // ค่าน้อย = สำคัญน้อย
+  LINE_MSG_RESET,
+  LINE_MSG_CLEANING,
+};
+
+struct LineMsg {
+  uint8_t  kind;             // LineMsgKind (ใช้เป็นลำดับความสำคัญด้วย)
+  uint16_t room;             // เฉพาะ LINE_MSG_CLEANING
+  uint32_t seq;              // ลำดับเข้าคิว (ความสำคัญเท่ากัน -> เก่าก่อน)
+  uint32_t queuedMs;
+  bool     inFlight;         // อยู่ในชุดที่ส่งไปแล้วแต่ยังไม่จบ (ห้ามแก้ text ไม่งั้น retry key ไม่ตรงชุด)
+  char     text[LINE_TEXT_MAX];
+};
+
+struct LineDispatchStats {
+  uint32_t queued;
+  uint32_t merged;           // แทนที่/รวมกับข้อความที่ค้างอยู่
+  uint32_t beatsSkipped;     // heartbeat เหมือนเดิม ไม่ส่ง
+  uint32_t dropped;          // คิวเต็ม หรือ LINE ปฏิเสธ (4xx)
+  uint32_t pushes;           // request ที่ส่งสำเร็จ
+  uint32_t msgsSent;
+  uint32_t rateLimited;      // ได้ 429
+  uint32_t failures;         // ส่งไม่ได้ / 5xx
+};
+
+struct LineDispatcher {
+  LineMsg  pending[LINE_PENDING_MAX];
+  uint8_t  count;
+  uint32_t seq;
+
+  bool     pushedOnce;
+  uint32_t lastPushMs;       // push ล่าสุด (ทั้งสำเร็จและไม่สำเร็จ)
+  uint32_t backoffMs;        // 0 = ไม่ได้ถอย
+  uint32_t retryAtMs;
+
+  uint8_t  inFlightN;                      // > 0 = ชุดล่าสุดยังต้องส่งซ้ำ (ด้วย retryKey เดิม)
+  uint32_t inFlightSeq[LINE_BATCH_MAX];    // ข้อความของชุดนั้นตามลำดับใน payload
+  char     retryKey[LINE_RETRY_KEY_LEN];
+
+  bool     beatSentOnce;
+  uint32_t lastBeatHash;     // heartbeat ล่าสุดที่ส่งสำเร็จ
+  uint32_t lastBeatSentMs;
+
+  LineDispatchStats st;
+};
+
+static inline void lineDispatchInit(LineDispatcher &d) {
+  memset(&d, 0, sizeof(d));
+}
+
+/* FNV-1a ของข้อความ (ใช้เทียบ heartbeat ซ้ำ) */
+static inline uint32_t lineTextHash(const char *s) {
+  uint32_t h = 2166136261u;
+  for (; *s; s++) { h ^= (uint8_t)*s; h *= 16777619u; }
+  return h;
+}
+
+/* เวลา a ถึงแล้วหรือยังเมื่อเทียบกับ now (ปลอดภัยตอน millis() วนรอบ) */
+static inline bool lineTimeReached(uint32_t nowMs, uint32_t atMs) {
+  return (int32_t)(nowMs - atMs) >= 0;
+}
+
+static inline void lineCopyText(char *dst, const char *src) {
+  size_t n = strlen(src);
+  if (n >= LINE_TEXT_MAX) {
+    n = LINE_TEXT_MAX - 1;
+    while (n > 0 && ((uint8_t)src[n] & 0xC0) == 0x80) n--;   // ไม่ตัดกลางตัวอักษร UTF-8
+  }
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+static inline void lineRemoveAt(LineDispatcher &d, uint8_t i) {
+  for (uint8_t k = i; k + 1 < d.count; k++) d.pending[k] = d.pending[k + 1];
+  d.count--;
+}
+
+static inline int lineFindPending(const LineDispatcher &d, uint8_t kind, uint16_t room) {
+  for (uint8_t i = 0; i < d.count; i++) {
+    if (d.pending[i].kind != kind || d.pending[i].inFlight) continue;
+    if (kind == LINE_MSG_CLEANING && d.pending[i].room != room) continue;
+    return i;
+  }
+  return -1;
+}
+
+/* มีข้อความรีเซ็ตเข้าคิวหลัง seq นี้ไหม */
+static inline bool lineResetQueuedAfter(const LineDispatcher &d, uint32_t seq) {
+  for (uint8_t i = 0; i < d.count; i++) {
+    if (d.pending[i].kind == LINE_MSG_RESET && (int32_t)(d.pending[i].seq - seq) > 0) return true;
+  }
+  return false;
+}
+
+/*
+ * ใส่ข้อความเข้าคิว
+ * คืน true ถ้าจะถูกส่ง (เข้าคิวใหม่หรือแทนตัวที่ค้าง), false ถ้าถูกข้าม/ทิ้ง
+ */
+static inline bool lineDispatchAdd(LineDispatcher &d, uint8_t kind, uint16_t room,
+                                   const char *text, uint32_t nowMs) {
+  if (kind == LINE_MSG_HEARTBEAT && d.beatSentOnce &&
+      lineTextHash(text) == d.lastBeatHash &&
+      nowMs - d.lastBeatSentMs < LINE_HEARTBEAT_REPEAT_MS &&
+      lineFindPending(d, LINE_MSG_HEARTBEAT, 0) < 0) {
+    d.st.beatsSkipped++;
+    return false;
+  }
+
+  // ตรงกับข้อความในชุดที่ค้างส่งทุกตัวอักษร -> ชุดนั้นจะส่งให้อยู่แล้ว
+  // ยกเว้นมีรีเซ็ตเข้าคิวหลังตัวนั้น: ผู้ใช้จะเห็นรีเซ็ตหลังข้อความเดิม แจ้งเตือนรอบใหม่ต้องตามมาอีกครั้ง
+  for (uint8_t i = 0; i < d.count; i++) {
+    const LineMsg &p = d.pending[i];
+    if (p.inFlight && p.kind == kind && (kind != LINE_MSG_CLEANING || p.room == room) &&
+        strncmp(p.text, text, LINE_TEXT_MAX - 1) == 0 && lineFindPending(d, kind, room) < 0 &&
+        !lineResetQueuedAfter(d, p.seq)) {
+      d.st.merged++;
+      return true;
+    }
+  }
+
+  if (kind == LINE_MSG_RESET) {
+    // ล้างแล้ว -> แจ้งเตือนทำความสะอาดที่ยังค้างไม่มีความหมาย
+    for (int i = d.count - 1; i >= 0; i--) {
+      if (d.pending[i].kind == LINE_MSG_CLEANING && !d.pending[i].inFlight) {
+        lineRemoveAt(d, (uint8_t)i);
+        d.st.merged++;
+      }
+    }
+  }
+
+  // heartbeat / ห้องเดียวกัน / รีเซ็ตซ้ำ -> แทนข้อความเดิม (คงลำดับและเวลาเข้าคิวเดิม)
+  int same = lineFindPending(d, kind, room);
+  if (same >= 0) {
+    lineCopyText(d.pending[same].text, text);
+    d.st.merged++;
+    return true;
+  }
+
+  if (d.count >= LINE_PENDING_MAX) {
+    // คิวเต็ม: ทิ้งตัวที่สำคัญน้อยสุด (เก่าสุดในกลุ่มนั้น, ไม่นับชุดที่ค้างส่ง) ถ้าไม่สำคัญกว่าตัวใหม่
+    int victim = -1;
+    for (uint8_t i = 0; i < d.count; i++) {
+      if (d.pending[i].inFlight) continue;
+      if (victim < 0 || d.pending[i].kind < d.pending[victim].kind) victim = i;
+    }
+    d.st.dropped++;
+    if (victim < 0 || d.pending[victim].kind > kind) return false;
+    lineRemoveAt(d, (uint8_t)victim);
+  }
+
+  LineMsg &m = d.pending[d.count++];
+  m.kind     = kind;
+  m.room     = room;
+  m.seq      = d.seq++;
+  m.queuedMs = nowMs;
+  m.inFlight = false;
+  lineCopyText(m.text, text);
+  d.st.queued++;
+  return true;
+}
+
+/* ต้องรออีกกี่ ms ถึงส่ง push ถัดไปได้ (0 = ส่งได้เลย, LINE_NO_WAIT = คิวว่าง) */
+static inline uint32_t lineDispatchWaitMs(const LineDispatcher &d, uint32_t nowMs) {
+  if (d.count == 0) return LINE_NO_WAIT;
+
+  uint32_t oldest = d.pending[0].queuedMs;   // เข้าคิวตามลำดับ -> ตัวแรกเก่าสุด
+  uint32_t readyAt = (d.count >= LINE_BATCH_MAX) ? nowMs : oldest + LINE_COALESCE_MS;
+  if (d.pushedOnce) {
+    uint32_t gapAt = d.lastPushMs + LINE_MIN_INTERVAL_MS;
+    if (!lineTimeReached(readyAt, gapAt)) readyAt = gapAt;
+  }
+  if (d.backoffMs && !lineTimeReached(readyAt, d.retryAtMs)) readyAt = d.retryAtMs;
+
+  return lineTimeReached(nowMs, readyAt) ? 0 : readyAt - nowMs;
+}
+
+/* กำลังถอยหลังโดน 429/ส่งไม่ได้ (ระหว่างนี้ไม่ต้องกันเครื่องหลับเพื่อรอส่ง) */
+static inline bool lineDispatchBackingOff(const LineDispatcher &d, uint32_t nowMs) {
+  return d.count > 0 && d.backoffMs && !lineTimeReached(nowMs, d.retryAtMs);
+}
+
+/* rnd 16 byte -> UUID v4 ตัวพิมพ์เล็ก (รูปแบบที่ X-Line-Retry-Key รับ) */
+static inline void lineRetryKeyFormat(char out[LINE_RETRY_KEY_LEN], const uint8_t rnd[16]) {
+  static const char hex[] = "0123456789abcdef";
+  uint8_t b[16];
+  memcpy(b, rnd, sizeof(b));
+  b[6] = (uint8_t)((b[6] & 0x0F) | 0x40);   // version 4
+  b[8] = (uint8_t)((b[8] & 0x3F) | 0x80);   // variant 10xx
+  size_t o = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) out[o++] = '-';
+    out[o++] = hex[b[i] >> 4];
+    out[o++] = hex[b[i] & 0x0F];
+  }
+  out[o] = '\0';
+}
+
+/*
+ * เลือกข้อความของ push ถัดไป — คืนจำนวน (<= LINE_BATCH_MAX)
+ * - ชุดก่อนยังค้าง (ได้ retryable) -> ชุดเดิมลำดับเดิม, d.retryKey เดิม
+ * - ไม่มีชุดค้าง -> สำคัญก่อน เท่ากันเก่าก่อน, ตรึงข้อความไว้ แล้วออก d.retryKey ใหม่จาก rnd
+ */
+static inline uint8_t lineDispatchBatch(LineDispatcher &d, const LineMsg *out[LINE_BATCH_MAX],
+                                        const uint8_t rnd[16]) {
+  uint8_t n = 0;
+  if (d.inFlightN) {
+    for (uint8_t i = 0; i < d.inFlightN; i++) {
+      for (uint8_t k = 0; k < d.count; k++) {
+        if (d.pending[k].seq == d.inFlightSeq[i]) { out[n++] = &d.pending[k]; break; }
+      }
+    }
+    return n;
+  }
+
+  bool used[LINE_PENDING_MAX] = {};
+  while (n < LINE_BATCH_MAX && n < d.count) {
+    int best = -1;
+    for (uint8_t i = 0; i < d.count; i++) {
+      if (used[i]) continue;
+      if (best < 0 || d.pending[i].kind > d.pending[best].kind) best = i;   // เท่ากัน -> ตัวแรก (เก่ากว่า)
+    }
+    used[best] = true;
+    d.pending[best].inFlight = true;
+    d.inFlightSeq[n] = d.pending[best].seq;
+    out[n++] = &d.pending[best];
+  }
+  d.inFlightN = n;
+  lineRetryKeyFormat(d.retryKey, rnd);
+  return n;
+}
+
+/* {"to":"...","messages":[{"type":"text","text":"..."},...]} */
+static inline bool lineDispatchBuildJson(JsonOut &out, const char *to,
+                                         const LineMsg *const batch[], uint8_t n) {
+  out.ch('{');
+  out.key("to"); out.str(to); out.ch(',');
+  out.key("messages");
+  out.ch('[');
+  for (uint8_t i = 0; i < n; i++) {
+    if (i) out.ch(',');
+    out.raw("{\"type\":\"text\",\"text\":");
+    out.str(batch[i]->text);
+    out.ch('}');
+  }
+  out.raw("]}");
+  return !out.overflow;
+}
+
+/* code นี้ควรส่งชุดเดิมซ้ำทีหลังไหม (ส่งไม่ถึง / โดนจำกัดอัตรา / server ล่ม) — ส่งซ้ำด้วย retry key เดิม */
+static inline bool lineCodeRetryable(int code) {
+  return code <= 0 || code == 429 || code >= 500;
+}
+
+/*
+ * บันทึกผล push ของชุดที่ได้จาก lineDispatchBatch()
+ * - 2xx / 409 (retry key นี้ LINE รับไปแล้วรอบก่อน): เอาออกจากคิว, เลิกถอย
+ * - retryable: เก็บไว้ทั้งชุด (ตรึงไว้กับ retry key เดิม), ถอยเวลาเป็น 2 เท่า (เริ่ม LINE_BACKOFF_MIN_MS)
+ * - 4xx อื่น: ทิ้งชุดนั้น
+ */
+static inline void lineDispatchResult(LineDispatcher &d, const LineMsg *const batch[], uint8_t n,
+                                      int code, uint32_t nowMs) {
+  d.pushedOnce = true;
+  d.lastPushMs = nowMs;
+
+  if (lineCodeRetryable(code)) {
+    if (code == 429) d.st.rateLimited++;
+    else             d.st.failures++;
+    d.backoffMs = d.backoffMs ? d.backoffMs * 2 : LINE_BACKOFF_MIN_MS;
+    if (d.backoffMs > LINE_BACKOFF_MAX_MS) d.backoffMs = LINE_BACKOFF_MAX_MS;
+    d.retryAtMs = nowMs + d.backoffMs;
+    return;
+  }
+
+  d.inFlightN = 0;
+  d.retryKey[0] = '\0';
+  bool ok = (code >= 200 && code < 300) || code == 409;
+  if (ok) {
+    d.backoffMs = 0;
+    d.st.pushes++;
+    d.st.msgsSent += n;
+  } else {
+    d.st.dropped += n;
+  }
+
+  // batch ชี้เข้า pending -> จำ seq ก่อน เพราะการลบทำให้ตำแหน่งเลื่อน
+  uint32_t seqs[LINE_BATCH_MAX];
+  for (uint8_t i = 0; i < n; i++) {
+    seqs[i] = batch[i]->seq;
+    if (ok && batch[i]->kind == LINE_MSG_HEARTBEAT) {
+      d.beatSentOnce   = true;
+      d.lastBeatHash   = lineTextHash(batch[i]->text);
+      d.lastBeatSentMs = nowMs;
+    }
+  }
+  for (uint8_t i = 0; i < n; i++) {
+    for (uint8_t k = 0; k < d.count; k++) {
+      if (d.pending[k].seq == seqs[i]) { lineRemoveAt(d, k); break; }
+    }
+  }
+}
+
+#endif
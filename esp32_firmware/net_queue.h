@@ -0,0 +1,90 @@
+#ifndef NET_QUEUE_H
+#define NET_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+/* =========================================================
+ * คิวงานเครือข่าย loop() -> net task (ส่วน pure logic ของ net_task.h)
+ *
+ * - ring buffer ขนาดคงที่ แบบ lock-free: ผู้ผลิต 1 (loop) / ผู้บริโภค 1 (net task)
+ * - คิวเต็ม -> ทิ้งงานใหม่แล้วนับไว้ (loop ห้ามรอ net task เด็ดขาด)
+ * - งาน "ส่งสถานะ" ไม่ต่อคิว ใช้ธงเดียว (snapshot ล่าสุดครอบคลุมทุกอัปเดตที่ค้าง)
+ * - ไม่พึ่ง Arduino.h/FreeRTOS เพื่อให้คอมไพล์บนเครื่อง PC ได้
+ *   การปลุก net task (xTaskNotifyGive) อยู่ใน net_task.h
+ * ========================================================= */
+
+/* ชนิดงานในคิว (เฉพาะ LINE; สถานะ backend ใช้ธง statusPending) */
+enum NetEventKind : uint8_t {
+  NET_EV_LINE_CLEANING = 0,  // ห้อง room ถึงเกณฑ์ทำความสะอาด (v[0] = uses)
+  NET_EV_LINE_RESET,         // รีเซ็ตตัวนับแล้ว
+  NET_EV_LINE_HEARTBEAT,     // สรุป heartbeat (flag = cleaningRequired; uses จาก snapshot ที่ loop เผยแพร่)
+};
+
+struct NetEvent {
+  uint8_t  kind;
+  uint8_t  flag;
+  uint16_t room;
+  uint32_t v[1];
+};
+
+#define NET_QUEUE_LEN 16                 // ต้องเป็นกำลังสองของ 2 (ใช้ mask แทน modulo)
+
+struct NetQueue {
+  NetEvent ev[NET_QUEUE_LEN];
+  std::atomic<uint32_t> head{0};         // เขียนโดยผู้ผลิตเท่านั้น
+  std::atomic<uint32_t> tail{0};         // เขียนโดยผู้บริโภคเท่านั้น
+  std::atomic<bool>     statusPending{false};
+  std::atomic<uint32_t> dropped{0};      // จำนวนงานที่ทิ้งเพราะคิวเต็ม (ไว้ดู log)
+};
+
+/* ผู้ผลิต: ใส่งานลงคิว คืน false ถ้าคิวเต็ม (ไม่รอ) */
+static inline bool netQueuePush(NetQueue &q, const NetEvent &e) {
+  uint32_t head = q.head.load(std::memory_order_relaxed);
+  uint32_t tail = q.tail.load(std::memory_order_acquire);
+  if (head - tail >= NET_QUEUE_LEN) {
+    q.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  q.ev[head & (NET_QUEUE_LEN - 1)] = e;
+  q.head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+/* ผู้บริโภค: หยิบงานถัดไป คืน false ถ้าคิวว่าง */
+static inline bool netQueuePop(NetQueue &q, NetEvent &out) {
+  uint32_t tail = q.tail.load(std::memory_order_relaxed);
+  uint32_t head = q.head.load(std::memory_order_acquire);
+  if (tail == head) return false;
+  out = q.ev[tail & (NET_QUEUE_LEN - 1)];
+  q.tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+static inline bool netQueueEmpty(const NetQueue &q) {
+  return q.head.load(std::memory_order_acquire) == q.tail.load(std::memory_order_acquire);
+}
+
+/* ตัวสร้างงานสำเร็จรูป (ใช้ทั้งบนบอร์ดและใน tools) */
+static inline NetEvent netEventCleaning(int roomIndex, unsigned long useCount) {
+  NetEvent e = {};
+  e.kind = NET_EV_LINE_CLEANING;
+  e.room = (uint16_t)roomIndex;
+  e.v[0] = (uint32_t)useCount;
+  return e;
+}
+
+static inline NetEvent netEventReset() {
+  NetEvent e = {};
+  e.kind = NET_EV_LINE_RESET;
+  return e;
+}
+
+static inline NetEvent netEventHeartbeat(bool cleaning) {
+  NetEvent e = {};
+  e.kind = NET_EV_LINE_HEARTBEAT;
+  e.flag = cleaning ? 1 : 0;
+  return e;
+}
+
+#endif
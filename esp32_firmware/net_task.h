@@ -0,0 +1,195 @@
+#ifndef NET_TASK_H
+#define NET_TASK_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_task_wdt.h"
+#include "send_to_backend.h"  // sendStatusImmediately(), sendJournalBatch(), wifiEnsure()
+#include "send_to_line.h"     // notifyXxx() -> คิว lineDispatch, linePushPending() ส่งเป็นชุด
+#include "net_queue.h"        // ring buffer lock-free loop -> net task (pure logic, คอมไพล์บน PC ได้)
+
+/* =========================================================
+ * Task เครือข่ายแยกจาก loop()
+ *
+ * ปัญหาเดิม: updateRoom() เรียก sendStatusImmediately()/notifyXxx() ตรง ๆ
+ * ซึ่งอาจค้างใน wifiEnsure() ได้ถึง 30s + เวลา HTTP/TLS ระหว่างนั้นไม่มีใครอ่าน PIR/ประตู
+ *
+ * แนวทาง:
+ * - loop() แค่ "ฝากงาน" ลงคิวแล้วกลับไปอ่านเซนเซอร์ต่อทันที (ไม่ block)
+ * - คิวเป็น ring buffer ขนาดคงที่ แบบ lock-free (ผู้ผลิต 1 = loop, ผู้บริโภค 1 = net task) ใน net_queue.h
+ * - งาน "ส่งสถานะ" ไม่ต้องต่อคิว ใช้ธงเดียวพอ (ส่ง snapshot ล่าสุดครั้งเดียวก็ครอบคลุมทุกอัปเดตที่ค้าง)
+ * - net task รันบน core 0 (loop() ของ Arduino อยู่ core 1) และ feed watchdog ของตัวเอง
+ * - งาน LINE ไม่ push ทันที: เข้าคิว lineDispatch (line_dispatch.h) แล้วส่งรวมเป็นชุด
+ *   ตามหน้าต่างรวมข้อความ/ระยะห่างขั้นต่ำ/backoff — task ตื่นตาม deadline ของคิวนั้น
+ * ========================================================= */
+
+#define NET_TASK_STACK 8192              // HTTP + TLS ใช้ stack ค่อนข้างมาก
+#define NET_TASK_PRIO  1
+#define NET_TASK_CORE  0
+#define NET_WDT_POLL_MS 1000             // ตื่นมา feed watchdog อย่างน้อยทุก 1s แม้ไม่มีงาน
+#define NET_RETRY_MIN_MS 10000UL         // ส่ง journal ไม่สำเร็จ -> ลองใหม่หลังจากนี้ แล้วเพิ่มเป็นเท่าตัว
+#define NET_RETRY_MAX_MS 300000UL        // เพดาน backoff (เน็ตล่มนาน ๆ ลองแค่ทุก 5 นาที)
+
+static NetQueue netQ;                           // ring + ธงสถานะ (net_queue.h)
+static std::atomic<bool>     netInFlight{false};// true = net task กำลังทำงาน (ห้ามเข้าหลับกลางคัน)
+static std::atomic<bool>     netLineDue{false}; // true = มีข้อความ LINE รอส่งเร็ว ๆ นี้ (ไม่ใช่ช่วง backoff)
+static TaskHandle_t netTaskHandle = nullptr;
+
+/* backoff ของการส่ง journal ซ้ำ (net task เท่านั้น) — เป็นแค่ตัวจับเวลา ไม่นับเป็น "งานค้าง" ใน netBusy() */
+static bool     netRetryWait = false;              // true = รอถึง netRetryAtMs ก่อนลองใหม่
+static uint32_t netRetryAtMs = 0;
+static uint32_t netRetryDelayMs = NET_RETRY_MIN_MS;
+
+/* ปลุก net task (ไม่ block; ถ้า task ยังไม่เริ่ม งานจะถูกหยิบตอนเริ่ม) */
+static inline void netKick() {
+  if (netTaskHandle) xTaskNotifyGive(netTaskHandle);
+}
+
+/* ผู้ผลิต: ใส่งานลงคิวแล้วปลุก net task คืน false ถ้าคิวเต็ม (ไม่รอ) */
+static inline bool netPush(const NetEvent &ev) {
+  if (!netQueuePush(netQ, ev)) return false;
+  netKick();
+  return true;
+}
+
+/* ===== API ฝั่ง loop(): เรียกแทน sendStatusImmediately()/notifyXxx() ===== */
+/* เผยแพร่ snapshot ปัจจุบัน (statusPublish) ก่อนตั้งธง -> net task ไม่แตะ panel เอง */
+static inline void netRequestStatus() {
+  statusPublish();
+  netQ.statusPending.store(true, std::memory_order_release);
+  netKick();
+}
+
+static inline void netNotifyCleaningRequired(int roomIndex, unsigned long useCount) {
+  netPush(netEventCleaning(roomIndex, useCount));
+}
+
+static inline void netNotifyCountersReset() {
+  netPush(netEventReset());
+}
+
+static inline void netNotifyHeartbeatSummary(bool cleaning) {
+  statusPublish();              // uses ในข้อความมาจาก snapshot นี้
+  netPush(netEventHeartbeat(cleaning));
+}
+
+/* ยังมีงานค้าง/กำลังส่งอยู่ไหม (ใช้ตัดสินใจก่อนเข้า light sleep)
+ * journal ที่รอ backoff ไม่นับ — net task ลองใหม่เองเมื่อถึงเวลา ระหว่างนั้นหลับได้ */
+static inline bool netBusy() {
+  return netInFlight.load(std::memory_order_acquire) ||
+         netQ.statusPending.load(std::memory_order_acquire) ||
+         netLineDue.load(std::memory_order_acquire) ||
+         !netQueueEmpty(netQ);
+}
+
+/* ===== ฝั่ง net task ===== */
+/* แปลง event เป็นข้อความในคิว LINE (ยังไม่ส่ง — linePushPending() ส่งเมื่อถึงเวลา) */
+static inline void netHandleEvent(const NetEvent &ev) {
+  switch (ev.kind) {
+    case NET_EV_LINE_CLEANING:  notifyCleaningRequired(ev.room, ev.v[0]); break;
+    case NET_EV_LINE_RESET:     notifyCountersReset(); break;
+    case NET_EV_LINE_HEARTBEAT: {
+      StatusShared st;          // uses จาก snapshot ที่ loop เผยแพร่ (ไม่อ่าน panel ข้าม core)
+      statusTake(st);
+      uint32_t uses[ROOM_COUNT];
+      for (size_t i = 0; i < ROOM_COUNT; i++) uses[i] = st.rooms[i].uses;
+      notifyHeartbeatSummary(ev.flag != 0, uses, ROOM_COUNT);
+      break;
+    }
+    default: break;
+  }
+}
+
+/* ส่ง journal ที่ค้างเป็นชุด ๆ จนหมดหรือจนส่งไม่สำเร็จ (ค้างไว้รอรอบหน้า) */
+static inline void netFlushJournal() {
+  wifiEnsure();
+  bool sent = false;
+  while (journalPending() > 0) {
+    if (!sendJournalBatch()) break;
+    sent = true;
+    esp_task_wdt_reset();
+  }
+  // backend ตอบ need_full กับ status ใน batch -> ส่งสถานะเต็มตามไป
+  if (sent && !statusAck.have) sendStatusImmediately();
+}
+
+/* ทำงานที่ค้างทั้งหมดจนหมด (ส่งสถานะก่อน แล้วค่อยไล่คิว LINE) */
+static inline void netDrain() {
+  netInFlight.store(true, std::memory_order_release);
+  for (;;) {
+    bool didWork = false;
+
+    if (netQ.statusPending.exchange(false, std::memory_order_acq_rel)) {
+      // มี event ค้างใน journal -> ส่งแบบ batch (พ่วงสถานะล่าสุดไปด้วย) แทน POST สถานะเดี่ยว
+      if (journalPending() > 0) netFlushJournal();
+      else                      sendStatusImmediately();
+      didWork = true;
+    }
+
+    NetEvent ev;
+    if (netQueuePop(netQ, ev)) {
+      netHandleEvent(ev);
+      didWork = true;
+      continue;                 // เก็บ event ที่ค้างเข้าคิว LINE ให้หมดก่อน จะได้รวมเป็น push เดียว
+    }
+
+    if (lineDispatchWaitMs(lineDispatch, millis()) == 0) {
+      wifiEnsure();             // LINE ต้องมีเน็ตก่อน (เดิม main เรียก wifiEnsure() ก่อน notify ทุกครั้ง)
+      if (linePushPending(millis())) didWork = true;
+    }
+
+    esp_task_wdt_reset();
+    if (!didWork) break;
+  }
+  uint32_t nowMs = millis();
+  netLineDue.store(lineDispatch.count > 0 && !lineDispatchBackingOff(lineDispatch, nowMs),
+                   std::memory_order_release);
+  netInFlight.store(false, std::memory_order_release);
+
+  uint32_t dropped = netQ.dropped.exchange(0, std::memory_order_relaxed);
+  if (dropped) Serial.printf("[NET] queue full, dropped %lu event(s)\n", (unsigned long)dropped);
+}
+
+static void netTaskMain(void *) {
+  // ให้ watchdog เฝ้า task นี้ด้วย (ถ้า HTTP/TLS ค้างจริงจะรีบูตเหมือน loop)
+  bool wdtAdded = (esp_task_wdt_add(NULL) == ESP_OK);
+  Serial.printf("[NET] task started on core %d (wdt=%s)\n", xPortGetCoreID(), wdtAdded ? "on" : "off");
+
+  for (;;) {
+    // ตื่นเมื่อมีงาน, เมื่อคิว LINE ถึงเวลาส่ง หรืออย่างน้อยทุก NET_WDT_POLL_MS
+    uint32_t waitMs = lineDispatchWaitMs(lineDispatch, millis());
+    if (waitMs > NET_WDT_POLL_MS) waitMs = NET_WDT_POLL_MS;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    perfResetNetApply();        // "perf reset" จาก loop: ล้าง http/line/wifi ที่นี่ (ผู้เขียนเดียว)
+
+    // ring ของ journal ใกล้เต็ม (ออฟไลน์) -> ย้ายก้อนเก่าลง NVS ที่นี่ (loop ไม่แตะแฟลช)
+    journalSpillIfNeeded();
+
+    // ยังมี event ค้างจากช่วงเน็ตหลุด -> ลองส่งใหม่ตาม backoff (ข้ามถ้า Wi-Fi ยังคูลดาวน์)
+    uint32_t nowMs = millis();
+    bool retry = journalPending() > 0 && !wifiCoolingDown() &&
+                 (!netRetryWait || (int32_t)(nowMs - netRetryAtMs) >= 0);
+    if (retry) netQ.statusPending.store(true, std::memory_order_release);
+    netDrain();
+
+    if (journalPending() == 0) {
+      netRetryWait = false;
+      netRetryDelayMs = NET_RETRY_MIN_MS;
+    } else if (retry) {
+      netRetryWait = true;
+      netRetryAtMs = millis() + netRetryDelayMs;
+      Serial.printf("[NET] journal %lu pending, retry in %lu s\n",
+                    (unsigned long)journalPending(), (unsigned long)(netRetryDelayMs / 1000));
+      netRetryDelayMs = netRetryDelayMs * 2 > NET_RETRY_MAX_MS ? NET_RETRY_MAX_MS : netRetryDelayMs * 2;
+    }
+  }
+}
+
+/* เรียกจาก setup() หลัง init watchdog แล้ว */
+static inline void netTaskStart() {
+  if (netTaskHandle) return;
+  xTaskCreatePinnedToCore(netTaskMain, "net", NET_TASK_STACK, nullptr,
+                          NET_TASK_PRIO, &netTaskHandle, NET_TASK_CORE);
+}
+
+#endif
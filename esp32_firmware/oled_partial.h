@@ -0,0 +1,141 @@
+#ifndef OLED_PARTIAL_H
+#define OLED_PARTIAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* =========================================================
+ * ส่งเฉพาะส่วนที่เปลี่ยนของ framebuffer SSD1306 (แทน display() ทั้งจอ 1KB)
+ *
+ * - SSD1306 128x64 แบ่งเป็น 8 page (page ละ 8 แถว) x 128 คอลัมน์ = 1 byte ต่อคอลัมน์ต่อ page
+ * - เก็บสำเนาสิ่งที่อยู่บนจอจริง (shadow) แล้วเทียบกับ framebuffer ทีละ page
+ *   -> หา "ช่วงคอลัมน์ที่เปลี่ยน" แล้วตั้งหน้าต่าง COLUMNADDR/PAGEADDR ส่งเฉพาะช่วงนั้น
+ * - ช่วงที่ห่างกันน้อยกว่าค่าใช้จ่ายของการเปิดหน้าต่างใหม่ถูกรวมเป็นช่วงเดียว
+ * - นับจำนวน byte ที่วิ่งบนสาย I2C (รวม address/control/command) เพื่อวัดผล
+ * - Bus เป็น template: บนบอร์ดใช้ Wire, บน PC ใช้ mock (tools/oled_bench)
+ *     void window(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1);
+ *     void data(const uint8_t *p, size_t n);                   // n <= OLED_I2C_CHUNK
+ * - ไม่พึ่ง Arduino.h
+ * ========================================================= */
+
+#define OLED_WIDTH        128
+#define OLED_PAGES        8
+#define OLED_FB_BYTES     (OLED_WIDTH * OLED_PAGES)
+#define OLED_I2C_CHUNK    127   // data ต่อ transaction (บัฟเฟอร์ Wire ของ ESP32 = 128 รวม control byte)
+
+/* byte บนสายต่อ transaction: address + control (0x00 คำสั่ง / 0x40 ข้อมูล) */
+#define OLED_I2C_TX_OVERHEAD 2
+/* ตั้งหน้าต่าง: COLUMNADDR c0 c1 PAGEADDR p0 p1 = 6 byte คำสั่ง */
+#define OLED_WINDOW_CMD_BYTES 6
+
+/* byte บนสายทั้งหมดของการเขียน 1 หน้าต่างขนาด n byte */
+static inline uint32_t oledI2cBytes(size_t n) {
+  uint32_t chunks = (uint32_t)((n + OLED_I2C_CHUNK - 1) / OLED_I2C_CHUNK);
+  return OLED_I2C_TX_OVERHEAD + OLED_WINDOW_CMD_BYTES +
+         chunks * OLED_I2C_TX_OVERHEAD + (uint32_t)n;
+}
+
+/* ช่องว่างระหว่างสองช่วงที่สั้นกว่านี้ -> ส่งรวมถูกกว่าเปิดหน้าต่างใหม่ */
+#define OLED_RUN_MERGE_GAP (2 * OLED_I2C_TX_OVERHEAD + OLED_WINDOW_CMD_BYTES)
+
+struct OledFlushStats {
+  uint32_t flushes;   // จำนวนครั้งที่เรียก flush
+  uint32_t windows;   // จำนวนหน้าต่างที่ส่ง
+  uint32_t bytes;     // byte บนสาย I2C สะสม
+};
+
+struct OledShadow {
+  uint8_t fb[OLED_FB_BYTES];   // สิ่งที่อยู่บนจอจริงตอนนี้
+  bool    valid;               // false = ไม่รู้ว่าบนจอมีอะไร -> ส่งทั้งจอครั้งถัดไป
+};
+
+/* ช่วงคอลัมน์ที่ต้องส่งของแต่ละ page (เกิน OLED_MAX_RUNS -> รวมส่วนที่เหลือเป็นช่วงเดียว) */
+#define OLED_MAX_RUNS 16
+
+struct OledRun {
+  uint8_t c0, c1;
+  bool    sent;
+};
+
+/*
+ * ส่งหน้าต่าง page p0..p1 x คอลัมน์ c0..c1 (โหมด horizontal addressing:
+ * ข้อมูลไล่คอลัมน์แล้วขึ้น page ถัดไปเอง) อัดข้อมูลเต็ม OLED_I2C_CHUNK ต่อ transaction
+ */
+template <class Bus>
+static inline void oledSendWindow(Bus &bus, const uint8_t *fb, uint8_t p0, uint8_t p1,
+                                  uint8_t c0, uint8_t c1, OledFlushStats &st) {
+  uint8_t stage[OLED_I2C_CHUNK];
+  size_t  fill = 0, total = 0;
+  bus.window(p0, p1, c0, c1);
+  for (uint8_t p = p0; p <= p1; p++) {
+    const uint8_t *row = fb + (size_t)p * OLED_WIDTH;
+    for (uint16_t c = c0; c <= c1; c++) {
+      stage[fill++] = row[c];
+      if (fill == OLED_I2C_CHUNK) { bus.data(stage, fill); total += fill; fill = 0; }
+    }
+  }
+  if (fill) { bus.data(stage, fill); total += fill; }
+  st.windows++;
+  st.bytes += oledI2cBytes(total);
+}
+
+/*
+ * ส่งเฉพาะส่วนที่ต่างจาก shadow แล้วอัปเดต shadow
+ * - หา "ช่วงคอลัมน์ที่เปลี่ยน" ของทุก page
+ * - ช่วงเดียวกันบน page ติดกัน (เช่น เส้นขอบแนวตั้ง, ตัวอักษรขนาด 2) ส่งเป็นหน้าต่างเดียว
+ * คืนจำนวน byte บนสายของรอบนี้ (0 = ไม่มีอะไรเปลี่ยน)
+ */
+template <class Bus>
+static inline uint32_t oledFlushChanged(const uint8_t *fb, OledShadow &sh,
+                                        Bus &bus, OledFlushStats &st) {
+  OledRun runs[OLED_PAGES][OLED_MAX_RUNS];
+  uint8_t nRuns[OLED_PAGES];
+  uint32_t before = st.bytes;
+  st.flushes++;
+
+  for (uint8_t page = 0; page < OLED_PAGES; page++) {
+    const uint8_t *cur  = fb + (size_t)page * OLED_WIDTH;
+    const uint8_t *seen = sh.fb + (size_t)page * OLED_WIDTH;
+    uint8_t n = 0;
+    int runStart = -1, runEnd = -1;
+    for (int c = 0; c < OLED_WIDTH; c++) {
+      if (sh.valid && cur[c] == seen[c]) continue;
+      if (runStart >= 0 && c - runEnd - 1 > OLED_RUN_MERGE_GAP && n < OLED_MAX_RUNS - 1) {
+        runs[page][n++] = {(uint8_t)runStart, (uint8_t)runEnd, false};
+        runStart = -1;
+      }
+      if (runStart < 0) runStart = c;
+      runEnd = c;
+    }
+    if (runStart >= 0) runs[page][n++] = {(uint8_t)runStart, (uint8_t)runEnd, false};
+    nRuns[page] = n;
+  }
+
+  for (uint8_t page = 0; page < OLED_PAGES; page++) {
+    for (uint8_t r = 0; r < nRuns[page]; r++) {
+      OledRun &run = runs[page][r];
+      if (run.sent) continue;
+      run.sent = true;
+
+      // ต่อลง page ถัดไปตราบที่มีช่วงคอลัมน์เดียวกันเป๊ะ
+      uint8_t last = page;
+      while (last + 1 < OLED_PAGES) {
+        bool found = false;
+        for (uint8_t k = 0; k < nRuns[last + 1]; k++) {
+          OledRun &nx = runs[last + 1][k];
+          if (!nx.sent && nx.c0 == run.c0 && nx.c1 == run.c1) { nx.sent = true; found = true; break; }
+        }
+        if (!found) break;
+        last++;
+      }
+      oledSendWindow(bus, fb, page, last, run.c0, run.c1, st);
+    }
+  }
+
+  memcpy(sh.fb, fb, OLED_FB_BYTES);
+  sh.valid = true;
+  return st.bytes - before;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef OLED_VIEW_H
+#define OLED_VIEW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "room_controller.h"
+
+/* =========================================================
+ * สิ่งที่จอ OLED ต้องแสดง (model) + ฟังก์ชันวาดลง framebuffer
+ *
+ * - loop() สร้าง model จากสถานะห้องทุกรอบ แล้วเทียบกับ model ที่แสดงอยู่
+ *   ถ้าเหมือนกัน -> ไม่ต้องวาดและไม่ต้องส่งอะไรไปจอเลย
+ * - ถ้าต่าง -> วาดใหม่ลง framebuffer แล้วให้ oled_partial.h ส่งเฉพาะส่วนที่เปลี่ยน
+ *   (เช่น ข้อความสถานะห้องเดียว, ตัวเลข U=, หรือกรอบกระพริบของหน้าทำความสะอาด)
+ * - Gfx เป็น template: บนบอร์ดคือ Adafruit_SSD1306, บน PC คือ mock (tools/oled_bench)
+ * - ไม่พึ่ง Arduino.h
+ * ========================================================= */
+
+#define OLED_VIEW_WIDTH  128
+#define OLED_VIEW_HEIGHT 64
+#define OLED_VIEW_WHITE 1          // = SSD1306_WHITE
+#define OLED_BLINK_MS 500          // กรอบหน้าทำความสะอาดกระพริบทุก 0.5s
+
+enum OledViewMode : uint8_t {
+  OLED_MODE_MAIN     = 0,   // สถานะทุกห้อง + U=
+  OLED_MODE_CLEANING = 1,   // "CLEANING!" + กรอบกระพริบ
+};
+
+template <size_t N>
+struct OledModel {
+  uint8_t  mode;
+  uint8_t  blink;           // ใช้เฉพาะโหมด CLEANING (โหมดอื่นเป็น 0 เสมอ)
+  char     state[N];        // 'V' ว่าง, 'O' ใช้งาน, 'C' ต้องทำความสะอาด
+  uint32_t uses[N];
+};
+
+template <size_t N, class PinMap>
+static inline void oledBuildModel(OledModel<N> &m, const RoomController<N, PinMap> &p,
+                                  bool cleaningRequired, uint32_t nowMs) {
+  memset(&m, 0, sizeof(m));   // ล้าง padding ด้วย เพื่อเทียบด้วย memcmp ได้
+  if (cleaningRequired) {
+    m.mode  = OLED_MODE_CLEANING;
+    m.blink = (uint8_t)((nowMs / OLED_BLINK_MS) % 2);
+    return;
+  }
+  m.mode = OLED_MODE_MAIN;
+  for (size_t i = 0; i < N; i++) {
+    m.state[i] = p.needCleaning[i] ? 'C' : p.lightOn[i] ? 'O' : 'V';
+    m.uses[i]  = p.uses[i];
+  }
+}
+
+template <size_t N>
+static inline bool oledModelEqual(const OledModel<N> &a, const OledModel<N> &b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+template <class Gfx>
+static inline void oledDrawCentered(Gfx &g, int size, const char *line, int y) {
+  g.setTextSize(size);
+  g.setTextColor(OLED_VIEW_WHITE);
+  int16_t x1, y1;
+  uint16_t w, h;
+  g.getTextBounds(line, 0, 0, &x1, &y1, &w, &h);
+  int16_t cx = (OLED_VIEW_WIDTH - w) / 2;
+  g.setCursor(cx, y);
+  g.println(line);
+}
+
+/* ====== เลย์เอาต์หน้าหลักตามจำนวนห้อง ======
+ * - ไม่เกิน 3 ห้อง: แถวละ 16px แบบเดิม "R1: Occupied   U=3"
+ * - ไม่เกิน 6 ห้อง: แถวละ 8px คอลัมน์เดียว
+ * - มากกว่านั้น: แบ่งหลายคอลัมน์ (แถวละ 8px สูงสุด 6 แถว) แบบย่อ "R12:O 3"
+ */
+template <size_t N>
+struct OledMainLayout {
+  static constexpr int kTopY    = 14;
+  static constexpr int kMaxRows = (OLED_VIEW_HEIGHT - kTopY) / 8;   // 6 แถว
+  static constexpr int kCols    = (int)((N + kMaxRows - 1) / kMaxRows);
+  static constexpr int kRows    = (int)((N + kCols - 1) / kCols);
+  static constexpr int kPitch   = (N <= 3) ? 16 : 8;
+  static constexpr int kColW    = OLED_VIEW_WIDTH / kCols;
+};
+
+template <class Gfx, size_t N>
+static inline void oledRenderMain(Gfx &g, const OledModel<N> &m) {
+  typedef OledMainLayout<N> L;
+  // แสดงสถานะรวมของแต่ละห้อง + จำนวนรอบใช้งาน U
+  g.clearDisplay();
+  g.setTextSize(1);
+  g.setTextColor(OLED_VIEW_WHITE);
+  g.setCursor(0, 0);
+  g.println("Smart Restroom");
+  for (size_t i = 0; i < N; i++) {
+    int x = (int)(i / L::kRows) * L::kColW;
+    int y = L::kTopY + (int)(i % L::kRows) * L::kPitch;
+    g.setCursor(x, y);
+    if (L::kCols == 1) {
+      g.print("R"); g.print((unsigned long)(i + 1)); g.print(": ");
+      if (m.state[i] == 'C')      g.print("Clean");
+      else if (m.state[i] == 'O') g.print("Occupied");
+      else                        g.print("Vacant");
+      g.setCursor(90, y);
+      g.print("U="); g.print((unsigned long)m.uses[i]);
+    } else {
+      g.print("R"); g.print((unsigned long)(i + 1)); g.print(":");
+      g.print(m.state[i]); g.print(" ");
+      g.print((unsigned long)m.uses[i]);
+    }
+  }
+}
+
+template <class Gfx>
+static inline void oledRenderCleaning(Gfx &g, bool blink) {
+  // โหมดแจ้ง "กำลังทำความสะอาด" พร้อมกรอบกระพริบ
+  g.clearDisplay();
+  oledDrawCentered(g, 2, "CLEANING!", 8);
+  if (blink) {
+    g.drawRoundRect(2, 2, OLED_VIEW_WIDTH - 4, OLED_VIEW_HEIGHT - 4, 6, OLED_VIEW_WHITE);
+  }
+  oledDrawCentered(g, 1, "Please wait...", 44);
+}
+
+template <class Gfx, size_t N>
+static inline void oledRender(Gfx &g, const OledModel<N> &m) {
+  if (m.mode == OLED_MODE_CLEANING) oledRenderCleaning(g, m.blink != 0);
+  else                              oledRenderMain(g, m);
+}
+
+#endif
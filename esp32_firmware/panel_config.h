@@ -0,0 +1,66 @@
+#ifndef PANEL_CONFIG_H
+#define PANEL_CONFIG_H
+
+#include "room_controller.h"
+
+/* =========================================================
+ * การต่อขาของแผงนี้ (ห้องละ PIR + รีดสวิตช์ประตู + LED)
+ * แผงใหญ่ 8-12 ห้อง: เพิ่มขาในทั้ง 3 ตารางให้ยาวเท่ากัน แล้วคอมไพล์ใหม่
+ * (ROOM_COUNT, ขนาด payload, persist, wake mask และหน้าจอปรับตามเอง)
+ *
+ * PIR ต้องเป็น RTC GPIO (ใช้ปลุกจาก light sleep) — ตรวจตอนคอมไพล์ใน RoomController
+ *
+ * ---- Reed switches (ประตู) ----
+ * ใช้ GPIO 32, 33, 35 (input-only, ไม่มี internal pull-up/down)
+ * แนะนำ: ต่อ pull-up ภายนอก แล้วให้ reed ต่อกราวด์
+ * => เมื่อ "ประตูปิด" (reed ปิดวงจร) digitalRead() จะ LOW (เพราะดึงลงกราวด์)
+ * ========================================================= */
+struct PanelPins {
+  static constexpr uint8_t pir[]  = {27, 26, 25};
+  static constexpr uint8_t door[] = {32, 33, 35};
+  static constexpr uint8_t led[]  = {18, 17, 16};
+  static constexpr bool reedActiveLow = true;   // true = logic LOW แปลว่า "ประตูปิด"
+};
+
+#define RESET_BTN 34   // ⚠️ GPIO34 เป็น input-only และไม่มี internal pull-up/down -> ต้องมี pull-down ภายนอกจริง
+
+#define ROOM_COUNT (sizeof(PanelPins::pir) / sizeof(PanelPins::pir[0]))
+
+/* ====== ค่าพารามิเตอร์ระบบ (ใช้ร่วมกับตัวจำลอง tools/room_sim) ====== */
+const unsigned long DEBOUNCE_MS = 30;              // หน่วงกันเด้งปุ่มสำหรับ double-click reset
+const unsigned long BOOT_GRACE_MS    = 5000;       // กันกดปุ่มตอนบูต 5s แรก
+const unsigned long DOUBLE_WINDOW_MS = 800;        // ต้องกดครั้งที่ 2 ภายใน 0.8s
+const unsigned long DOOR_DEBOUNCE_MS = 20;         // รีดสวิตช์ต้องนิ่งเท่านี้ก่อนยอมรับว่าประตูเปลี่ยนสถานะ
+const unsigned long HOLD_ON_MS  = 10UL * 1000UL;   // เวลาคอยดับไฟเมื่อไม่มี motion ต่อเนื่อง (10s)
+const unsigned int  USES_THRESHOLD_PER_ROOM = 5;   // เกณฑ์จำนวนรอบการใช้งานต่อห้องก่อนแจ้ง "ต้องทำความสะอาด"
+const unsigned long TOTAL_MS_THRESHOLD_PER_ROOM =
+  2UL * 60UL * 1000UL;                             // เกณฑ์เวลาสะสม >= 2 นาที ต่อห้องก่อนแจ้ง "ต้องทำความสะอาด"
+
+/* ====== โหมดประหยัดพลังงาน (Light Sleep) ====== */
+static const unsigned long SLEEP_IDLE_MS = 2UL * 60UL * 1000UL;  // ถ้าห้องว่างทุกห้องนานเกิน 2 นาที -> เข้าหลับ
+static const uint64_t LIGHT_SLEEP_INTERVAL_US =
+  5ULL * 60ULL * 1000000ULL; // ปลุกตัวเองอัตโนมัติทุก ~5 นาที (heartbeat)
+const unsigned long AWAKE_HOLDOFF_MS = 1500;       // ตื่นมาแล้วอย่างน้อย 1.5s ก่อนค่อยหลับใหม่
+
+/* ====== Timer ของ loop() (scheduler หา deadline ใกล้สุดแล้วหลับรอ) ====== */
+const unsigned long HEARTBEAT_MS     = 10UL * 1000UL;  // ส่งสถานะซ้ำทุก 10s ช่วงที่ยัง active
+const unsigned long BUZZER_TOGGLE_MS = 3000UL;         // กระพริบเสียงเข้า/ออกทุก 3 วินาทีตอนแจ้งเตือน
+const unsigned long WDT_FEED_MS      = 2000UL;         // ตื่นมา feed watchdog อย่างน้อยทุก 2s (timeout 10s, เผื่อ 5 เท่า)
+const unsigned long BUTTON_POLL_MS   = 20;             // poll ปุ่มระหว่างกด (กดครั้งแรกปลุก loop ด้วย interrupt)
+const unsigned long TICK_SLEEP_MIN_MS = 30;            // รอสั้นกว่านี้ไม่คุ้มเข้า light sleep
+
+/* ต่อ AP อยู่ปกติไม่ tick sleep (รอใน edgeWait + modem sleep); 1 = ทดลองหลับได้แบบคุมระยะ beacon
+ * ยังไม่ได้วัดกระแส/การหลุด AP บนบอร์ดจริง -> ปิดไว้ก่อน */
+#ifndef TICK_SLEEP_ASSOCIATED
+#define TICK_SLEEP_ASSOCIATED 0
+#endif
+#if TICK_SLEEP_ASSOCIATED
+const unsigned long BEACON_BUDGET_MS = 3000;           // หลับได้นานสุดเท่านี้นับจากได้ beacon ล่าสุด (STA ตัดเองที่ ~6s)
+const unsigned long BEACON_LISTEN_MS = 110;            // แล้วตื่นค้างเท่านี้ให้ได้ beacon (interval 102.4ms)
+#endif
+
+typedef RoomController<ROOM_COUNT, PanelPins> Panel;
+
+extern Panel panel;   // instance เดียว สร้างในไฟล์หลัก (SmartRestroom.ino)
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef PANEL_POLICY_H
+#define PANEL_POLICY_H
+
+#include <stdint.h>
+
+/* =========================================================
+ * นโยบายของแผงที่ไม่ผูกกับฮาร์ดแวร์ (ปุ่มรีเซ็ต + เงื่อนไขเข้า light sleep + deadline ของ loop)
+ *
+ * - แยกออกจาก SmartRestroom.ino ให้เป็นฟังก์ชันบริสุทธิ์ (รับเวลา/ระดับขาเป็นพารามิเตอร์)
+ *   -> ไฟล์หลักเรียกด้วย millis()/digitalRead(), ตัวจำลองบน PC (tools/room_sim)
+ *      เรียกด้วยนาฬิกาเสมือน ได้ผลตรงกันทุกบิต
+ * - ไม่พึ่ง Arduino.h
+ * ========================================================= */
+
+/* ====== ปุ่มรีเซ็ตแบบ "กด 2 ครั้งติดกัน" เพื่อกันกดพลาด ====== */
+struct DoublePressDetector {
+  uint32_t debounceMs;     // หน่วงกันเด้ง
+  uint32_t windowMs;       // ต้องกดครั้งที่ 2 ภายในเวลานี้
+  uint32_t bootGraceMs;    // ไม่รับกดช่วงแรกหลังบูต
+
+  uint32_t bootAtMs     = 0;
+  bool     lastStable   = false;   // ระดับที่ยืนยันแล้ว (เริ่มที่ LOW)
+  uint32_t lastChange   = 0;
+  uint32_t firstClickAt = 0;
+  bool     armed        = false;
+
+  DoublePressDetector(uint32_t debounce, uint32_t window, uint32_t bootGrace)
+    : debounceMs(debounce), windowMs(window), bootGraceMs(bootGrace) {}
+
+  /* ป้อนระดับขาปัจจุบัน คืน true ครั้งเดียวเมื่อ double click สำเร็จ */
+  bool feed(bool levelHigh, uint32_t nowMs) {
+    if (nowMs - bootAtMs < bootGraceMs) return false; // ยังไม่รับกดช่วงบูต
+
+    // ตรวจจับขอบสัญญาณแบบหน่วงกันเด้ง
+    if (levelHigh != lastStable && nowMs - lastChange >= debounceMs) {
+      lastChange = nowMs;
+      lastStable = levelHigh;
+
+      if (lastStable) { // นับเฉพาะตอนปล่อยเป็น HIGH (หรือเลือกตอนกดก็ได้ตามวงจร)
+        if (!armed) {
+          // ครั้งที่ 1 -> ติดธงรอครั้งที่ 2
+          armed = true;
+          firstClickAt = nowMs;
+        } else if (nowMs - firstClickAt <= windowMs) {
+          // ครั้งที่ 2 มาทันเวลา -> นับว่า double click สำเร็จ
+          armed = false;
+          return true;
+        } else {
+          // คลิกช้าไป -> เลื่อนหน้าต่างใหม่
+          firstClickAt = nowMs;
+        }
+      }
+    }
+
+    // ถ้ารอครั้งที่สองนานเกินหน้าต่าง -> ยกเลิก
+    if (armed && (nowMs - firstClickAt > windowMs)) {
+      armed = false;
+    }
+    return false;
+  }
+
+  /* กำลังกดอยู่/รอคลิกที่ 2 -> poll ถี่เพื่อ debounce/จับเวลาช่วงคลิก (กดครั้งแรกปลุก loop ด้วย interrupt) */
+  bool busy(bool levelHigh) const { return armed || lastStable || levelHigh; }
+};
+
+/* ====== เงื่อนไขเข้าหลับ (Light Sleep) เมื่อระบบว่าง ====== */
+struct SleepGateInputs {
+  uint32_t nowMs;
+  uint32_t lastWakeMs;       // เวลาตื่นล่าสุด
+  uint32_t lastMotionMs;     // motion ล่าสุดของทุกห้อง
+  bool     anyOccupied;      // มีห้องใช้งานอยู่
+  bool     cleaningRequired; // มีห้องต้องทำความสะอาด
+  bool     netBusy;          // net task ยังส่งไม่เสร็จ
+  bool     anyDoorClosed;    // มีประตูปิดอยู่ (อาจมีคนนิ่ง ๆ อยู่ข้างใน)
+};
+
+/*
+ * เข้าหลับได้เมื่อ:
+ * - ตื่นมานานพอ (awakeHoldoffMs)
+ * - ทุกห้องว่าง ไม่มีธง cleaningRequired และไม่มีงานเครือข่ายค้าง
+ * - ไม่มีประตูบานไหนปิดอยู่
+ * - ไม่มี motion รวมกันนานเกิน idleMs
+ */
+static inline bool lightSleepAllowed(const SleepGateInputs &in,
+                                     uint32_t awakeHoldoffMs,
+                                     uint32_t idleMs) {
+  if (in.nowMs - in.lastWakeMs < awakeHoldoffMs) return false;
+  if (in.anyOccupied)      return false;
+  if (in.cleaningRequired) return false;
+  if (in.netBusy)          return false;
+  if (in.anyDoorClosed)    return false;
+  return in.nowMs - in.lastMotionMs >= idleMs;
+}
+
+/* heartbeat ปกติของ loop() ทุก HEARTBEAT_MS: ส่งสถานะเฉพาะช่วงที่ยัง active
+ * (ว่างนานเกิน idleMs = ใกล้หลับ หรือติดธง cleaning = มี buzzer/LINE เตือนอยู่แล้ว -> ไม่ส่ง) */
+static inline bool heartbeatSendsStatus(uint32_t nowMs, uint32_t lastMotionMs,
+                                        bool cleaningRequired, uint32_t idleMs) {
+  return nowMs - lastMotionMs < idleMs && !cleaningRequired;
+}
+
+/* ====== Tickless: deadline ถัดไปของทุก timer ใน loop() ======
+ * แทนการ poll ทุก 20ms: หาว่างานถัดไปครบกำหนดเมื่อไร (timeout ห้อง, กรอบกระพริบ,
+ * heartbeat, buzzer, feed watchdog, ปุ่มที่กำลังกด) แล้วรอ/หลับจนถึงตอนนั้น
+ * ระหว่างนั้นถ้าขา PIR/ประตู/ปุ่มเปลี่ยนก็ตื่นก่อนได้
+ */
+#define SCHED_NEVER 0xFFFFFFFFu
+
+enum SchedReason : uint8_t {
+  SCHED_ROOM = 0,    // timeout HOLD_ON / ยืนยันประตู
+  SCHED_BLINK,       // กรอบกระพริบหน้าทำความสะอาด
+  SCHED_HEARTBEAT,
+  SCHED_BUZZER,
+  SCHED_WDT,
+  SCHED_BUTTON,      // ปุ่มกำลังกด -> poll ถี่
+  SCHED_REASONS
+};
+
+struct SchedPeriods {
+  uint32_t heartbeatMs;
+  uint32_t buzzerToggleMs;
+  uint32_t wdtFeedMs;
+  uint32_t buttonPollMs;
+};
+
+struct SchedInputs {
+  uint32_t nowMs;
+  uint32_t roomWaitMs;          // จาก RoomController::nextDeadlineUs() (SCHED_NEVER = ไม่มี)
+  uint32_t blinkMs;             // คาบกระพริบของจอ (0 = ไม่มีอะไรกระพริบ)
+  uint32_t lastBeatMs;
+  bool     buzzerActive;        // cleaningRequired
+  uint32_t lastBuzzerToggleMs;
+  uint32_t lastFeedMs;
+  bool     buttonBusy;          // DoublePressDetector::busy()
+};
+
+struct SchedNext {
+  uint32_t waitMs;              // รอได้นานสุดเท่านี้ (0 = มีงานครบกำหนดแล้ว)
+  uint8_t  reason;              // SchedReason ของ deadline ที่ใกล้สุด
+};
+
+/* เหลืออีกกี่ ms จะครบ period นับจาก lastMs (0 = เลยกำหนดแล้ว) */
+static inline uint32_t schedDueIn(uint32_t nowMs, uint32_t lastMs, uint32_t periodMs) {
+  uint32_t elapsed = nowMs - lastMs;
+  return elapsed >= periodMs ? 0 : periodMs - elapsed;
+}
+
+static inline void schedTake(SchedNext &n, uint32_t waitMs, uint8_t reason) {
+  if (waitMs < n.waitMs) { n.waitMs = waitMs; n.reason = reason; }
+}
+
+static inline SchedNext schedNextDeadline(const SchedInputs &in, const SchedPeriods &p) {
+  SchedNext n = {SCHED_NEVER, SCHED_WDT};
+  schedTake(n, in.roomWaitMs, SCHED_ROOM);
+  if (in.blinkMs)      schedTake(n, in.blinkMs - in.nowMs % in.blinkMs, SCHED_BLINK);
+  schedTake(n, schedDueIn(in.nowMs, in.lastBeatMs, p.heartbeatMs), SCHED_HEARTBEAT);
+  if (in.buzzerActive) schedTake(n, schedDueIn(in.nowMs, in.lastBuzzerToggleMs, p.buzzerToggleMs), SCHED_BUZZER);
+  schedTake(n, schedDueIn(in.nowMs, in.lastFeedMs, p.wdtFeedMs), SCHED_WDT);
+  if (in.buttonBusy)   schedTake(n, p.buttonPollMs, SCHED_BUTTON);
+  return n;
+}
+
+struct TickPlan {
+  uint32_t waitMs;        // รอ/หลับนานสุดเท่านี้
+  bool     sleep;         // true = light sleep, false = edgeWait() (CPU พักใน idle)
+};
+
+/*
+ * หลับสั้น ๆ ระหว่าง deadline ได้ไหม (ไม่คุ้มถ้ารอไม่นาน, ห้ามหลับตอน Wi-Fi/HTTP กำลังทำงาน)
+ * ขณะ STA ต่อ AP อยู่ก็ห้าม: light sleep ถี่ ๆ ทำให้พลาด beacon/DTIM (AP ตัดการเชื่อมต่อ -> ต่อใหม่
+ * ซึ่งกินไฟกว่า) ช่วงนั้นรอด้วย edgeWait() แล้วให้ modem sleep (WiFi.setSleep(true)) ประหยัดแทน
+ */
+static inline bool tickSleepAllowed(const SchedNext &n, bool netBusy, bool wifiAssociated, uint32_t minSleepMs) {
+  return !netBusy && !wifiAssociated && n.waitMs >= minSleepMs;
+}
+
+#if TICK_SLEEP_ASSOCIATED
+/*
+ * (ทดลอง, เปิดด้วย -DTICK_SLEEP_ASSOCIATED=1 — ยังไม่ได้วัดบนบอร์ดจริง)
+ * ต่อ AP อยู่ก็หลับระหว่าง deadline ได้ แต่ light sleep ปิดวิทยุ: STA ที่ไม่ได้ beacon นานเกิน
+ * beacon timeout จะตัดการเชื่อมต่อเอง -> หลับได้ไม่เกิน budgetMs นับจาก beacon ล่าสุด
+ * แล้วต้องตื่นค้างอย่างน้อย listenMs (>= 1 beacon interval) ก่อนหลับต่อ
+ */
+struct BeaconWindow {
+  uint32_t heardMs;       // ตื่นค้างครบ listenMs ล่าสุด (ถือว่าได้ beacon แล้ว)
+  uint32_t awakeFromMs;   // ตื่นต่อเนื่องมาตั้งแต่เมื่อไร
+};
+
+/* เรียกก่อนตัดสินใจหลับ: ตื่นค้างมานานพอ -> นับว่าได้ beacon ตอนนี้ */
+static inline void beaconNoteAwake(BeaconWindow &b, uint32_t nowMs, uint32_t listenMs) {
+  if (nowMs - b.awakeFromMs >= listenMs) b.heardMs = nowMs;
+}
+
+/* เรียกหลังตื่นจาก light sleep ทุกแบบ */
+static inline void beaconNoteWake(BeaconWindow &b, uint32_t nowMs) {
+  b.awakeFromMs = nowMs;
+}
+
+/* เหมือน tickSleepAllowed แต่ต่อ AP อยู่หลับได้ถึงแค่ครบ budget, ครบแล้วรอด้วย edgeWait() จนตื่นค้างครบ listenMs */
+static inline TickPlan tickSleepPlan(const SchedNext &n, bool netBusy, bool wifiAssociated,
+                                     const BeaconWindow &b, uint32_t nowMs,
+                                     uint32_t budgetMs, uint32_t listenMs, uint32_t minSleepMs) {
+  TickPlan p = {n.waitMs, false};
+  if (netBusy || n.waitMs < minSleepMs) return p;
+  if (wifiAssociated) {
+    uint32_t since = nowMs - b.heardMs;
+    uint32_t left  = since >= budgetMs ? 0 : budgetMs - since;
+    if (left < minSleepMs) {
+      uint32_t awake  = nowMs - b.awakeFromMs;
+      uint32_t listen = awake >= listenMs ? 0 : listenMs - awake;
+      if (listen > 0 && listen < p.waitMs) p.waitMs = listen;
+      return p;
+    }
+    if (left < p.waitMs) p.waitMs = left;
+  }
+  p.sleep = true;
+  return p;
+}
+#endif
+
+/* สถิติการหลับ (ใช้ประเมินพลังงานที่ประหยัดได้บนแผงที่ใช้แบตสำรอง) */
+struct SleepStats {
+  uint32_t sleeps;                      // จำนวนครั้งที่เข้า light sleep
+  uint32_t wakeGpio;                    // ตื่นเพราะขาเปลี่ยน
+  uint32_t wakeTimer;                   // ตื่นเพราะครบ deadline
+  uint32_t byReason[SCHED_REASONS];     // deadline ที่ตั้ง timer ไว้ (เฉพาะตื่นด้วย timer)
+  uint64_t sleptUs;                     // เวลาหลับสะสม
+};
+
+static inline void sleepStatsAdd(SleepStats &st, uint64_t sleptUs, bool byGpio, uint8_t reason) {
+  st.sleeps++;
+  st.sleptUs += sleptUs;
+  if (byGpio) st.wakeGpio++;
+  else {
+    st.wakeTimer++;
+    if (reason < SCHED_REASONS) st.byReason[reason]++;
+  }
+}
+
+/* สัดส่วนเวลาตื่น (ต่อพัน) ของช่วง uptimeUs */
+static inline uint32_t sleepStatsAwakePermille(const SleepStats &st, uint64_t uptimeUs) {
+  if (uptimeUs == 0 || st.sleptUs >= uptimeUs) return 0;
+  return (uint32_t)((uptimeUs - st.sleptUs) * 1000 / uptimeUs);
+}
+
+#endif
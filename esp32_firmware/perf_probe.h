@@ -0,0 +1,195 @@
+#ifndef PERF_PROBE_H
+#define PERF_PROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "status_json.h"        // JsonOut (บล็อก "perf" ใน payload สถานะ)
+
+/* =========================================================
+ * Probe วัดเวลาแต่ละขั้นของเฟิร์มแวร์ + histogram แบบ log2 (หน่วยความจำคงที่)
+ *
+ * - PerfScope p(PERF_DRAW);  -> จับเวลาตั้งแต่สร้างจนหลุด scope (esp_timer, ความละเอียด us)
+ * - แต่ละขั้นเก็บ histogram 24 ช่อง: ช่อง k = [2^k, 2^(k+1)) us (1us .. ~16s)
+ *   + จำนวนครั้ง, ผลรวม, ค่าสูงสุด -> ประมาณ p50/p99 ได้โดยไม่ต้องเก็บทุกตัวอย่าง
+ * - watchdog near-miss: ระยะห่างระหว่างการ feed ของ loop (ไม่นับเวลาที่ light sleep)
+ *   ที่เกิน PERF_WDT_NEAR_PCT% ของ timeout ถูกนับ + จำค่าสูงสุด
+ * - สรุปทาง Serial (คำสั่ง "perf") และเป็นบล็อก "perf" ใน payload สถานะเต็ม
+ *
+ * แต่ละขั้นมีผู้เขียนเพียง task เดียว (loop: sense/room/draw/nvs/loop, net task: http/line/wifi)
+ * จึงไม่ใช้ lock; ผู้อ่านอาจเห็นค่าที่อัปเดตไม่พร้อมกันเล็กน้อย ซึ่งยอมรับได้สำหรับสถิติ
+ * การล้างก็ต้องทำโดยผู้เขียนของขั้นนั้น: perfReset() (loop) ล้างขั้นของ loop แล้วตั้งธงให้
+ * net task ล้างขั้นของตัวเองใน perfResetNetApply()
+ * ไม่พึ่ง Arduino.h (บน PC กำหนด PERF_NOW_US() เองได้)
+ * ========================================================= */
+
+#ifndef PERF_NOW_US
+#include "esp_timer.h"
+#define PERF_NOW_US() esp_timer_get_time()
+#endif
+
+#define PERF_BUCKETS        24
+#define PERF_WDT_NEAR_PCT   50      // feed ห่างเกินครึ่งของ timeout = เกือบโดน watchdog
+#define PERF_JSON_MAX       600     // ขนาดบล็อก "perf" สูงสุดใน payload
+
+enum PerfStage : uint8_t {
+  PERF_LOOP = 0,   // loop() หนึ่งรอบ (ไม่รวมเวลารอ/หลับ)
+  PERF_SENSE,      // ดึง edge จาก ISR + ป้อน state machine
+  PERF_ROOM,       // tick ของห้อง (timeout/ยืนยันประตู)
+  PERF_DRAW,       // เทียบ model + วาด/ส่งจอ
+  PERF_HTTP,       // POST ไป backend (สถานะ/batch)
+  PERF_LINE,       // push ไป LINE
+  PERF_WIFI,       // wifiEnsure() ที่ต้องต่อจริง
+  PERF_NVS,        // เขียน persist ลงแฟลช
+  PERF_STAGES
+};
+
+static const char *const perfStageNames[PERF_STAGES] = {
+  "loop", "sense", "room", "draw", "http", "line", "wifi", "nvs",
+};
+
+struct PerfHist {
+  uint32_t bins[PERF_BUCKETS];
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t sumUs;
+};
+
+/* ตัวนับอื่นของเครื่องที่อยากเห็นคู่กับ histogram (loop คัดลอกมาใส่เป็นระยะ) */
+struct PerfCounters {
+  uint32_t flashWrites;     // persistLogFlashWrites()
+  uint32_t i2cBytes;        // oledStats.bytes
+  uint32_t awakePermille;   // sleepStatsAwakePermille()
+  uint32_t sleeps;
+};
+
+struct PerfState {
+  PerfHist     stage[PERF_STAGES];
+  uint32_t     wdtNearMiss;
+  uint32_t     wdtMaxGapMs;
+  int64_t      wdtLastFeedUs;
+  uint64_t     wdtSleptAtFeed;
+  PerfCounters counters;
+};
+
+static PerfState perf = {};
+
+static inline uint8_t perfBucket(uint32_t us) {
+  uint8_t k = (uint8_t)(31 - __builtin_clz(us | 1));
+  return k < PERF_BUCKETS ? k : PERF_BUCKETS - 1;
+}
+
+/* บันทึกลง PerfState ที่ระบุ (บน PC แต่ละแผงเสมือนมีของตัวเอง) */
+static inline void perfRecordIn(PerfState &st, uint8_t stage, uint32_t us) {
+  PerfHist &h = st.stage[stage];
+  h.bins[perfBucket(us)]++;
+  h.count++;
+  h.sumUs += us;
+  if (us > h.maxUs) h.maxUs = us;
+}
+
+static inline void perfRecord(uint8_t stage, uint32_t us) {
+  perfRecordIn(perf, stage, us);
+}
+
+/* ขอบบนของช่องที่มีตัวอย่างลำดับ p (0..1) -> ค่าประมาณแบบปัดขึ้น ไม่เกิน max */
+static inline uint32_t perfPercentileUs(const PerfHist &h, double p) {
+  if (h.count == 0) return 0;
+  uint32_t want = (uint32_t)(p * h.count + 0.999999);
+  if (want == 0) want = 1;
+  uint32_t acc = 0;
+  for (uint8_t k = 0; k < PERF_BUCKETS; k++) {
+    acc += h.bins[k];
+    if (acc >= want) {
+      if (k == PERF_BUCKETS - 1) return h.maxUs;   // ช่องสุดท้ายไม่มีขอบบน
+      uint32_t upper = ((uint32_t)2 << k) - 1;
+      return upper < h.maxUs ? upper : h.maxUs;
+    }
+  }
+  return h.maxUs;
+}
+
+struct PerfScope {
+  uint8_t stage;
+  int64_t t0;
+  explicit PerfScope(uint8_t s) : stage(s), t0(PERF_NOW_US()) {}
+  ~PerfScope() {
+    int64_t dt = PERF_NOW_US() - t0;
+    perfRecord(stage, dt < 0 ? 0 : dt > 0xFFFFFFFF ? 0xFFFFFFFFu : (uint32_t)dt);
+  }
+};
+
+/*
+ * loop() เรียกทุกครั้งที่ feed watchdog
+ * sleptUs = เวลาหลับสะสม (ระหว่าง light sleep watchdog ไม่เดิน จึงไม่นับ)
+ */
+static inline void perfWdtFeed(int64_t nowUs, uint64_t sleptUs, uint32_t timeoutMs) {
+  if (perf.wdtLastFeedUs) {
+    int64_t gapUs = (nowUs - perf.wdtLastFeedUs) - (int64_t)(sleptUs - perf.wdtSleptAtFeed);
+    uint32_t gapMs = gapUs > 0 ? (uint32_t)(gapUs / 1000) : 0;
+    if (gapMs > perf.wdtMaxGapMs) perf.wdtMaxGapMs = gapMs;
+    if (gapMs * 100 >= timeoutMs * PERF_WDT_NEAR_PCT) perf.wdtNearMiss++;
+  }
+  perf.wdtLastFeedUs  = nowUs;
+  perf.wdtSleptAtFeed = sleptUs;
+}
+
+/* ขั้นที่ net task เป็นผู้เขียน (ที่เหลือเป็นของ loop) */
+static inline bool perfStageIsNet(uint8_t s) {
+  return s == PERF_HTTP || s == PERF_LINE || s == PERF_WIFI;
+}
+
+static std::atomic<bool> perfNetResetPending{false};   // loop ขอ -> net task ล้างขั้นของตัวเอง
+
+/* เรียกจาก loop(): ล้างขั้นของ loop + watchdog ทันที ขั้นของ net task ฝากไว้ (ไม่เขียนข้าม core) */
+static inline void perfReset() {
+  for (uint8_t s = 0; s < PERF_STAGES; s++) {
+    if (!perfStageIsNet(s)) memset(&perf.stage[s], 0, sizeof(perf.stage[s]));
+  }
+  perf.wdtNearMiss = 0;
+  perf.wdtMaxGapMs = 0;
+  perfNetResetPending.store(true, std::memory_order_release);
+}
+
+/* เรียกจาก net task ทุกครั้งที่ตื่น: ล้างขั้นของตัวเองถ้า loop ขอไว้ */
+static inline void perfResetNetApply() {
+  if (!perfNetResetPending.exchange(false, std::memory_order_acq_rel)) return;
+  for (uint8_t s = 0; s < PERF_STAGES; s++) {
+    if (perfStageIsNet(s)) memset(&perf.stage[s], 0, sizeof(perf.stage[s]));
+  }
+}
+
+/*
+ * "perf":{"loop":[n,p50,p99,max],...,"wdt_near":k,"wdt_gap_ms":g,"flash_writes":..}
+ * (เวลาเป็น us; ขั้นที่ยังไม่มีตัวอย่างถูกข้าม)
+ */
+static inline void perfWriteStateJson(JsonOut &out, const PerfState &st) {
+  out.key("perf");
+  out.ch('{');
+  for (uint8_t s = 0; s < PERF_STAGES; s++) {
+    const PerfHist &h = st.stage[s];
+    if (h.count == 0) continue;
+    out.key(perfStageNames[s]);
+    out.ch('[');
+    out.u32(h.count);                     out.ch(',');
+    out.u32(perfPercentileUs(h, 0.50));   out.ch(',');
+    out.u32(perfPercentileUs(h, 0.99));   out.ch(',');
+    out.u32(h.maxUs);
+    out.ch(']');
+    out.ch(',');
+  }
+  out.key("wdt_near");     out.u32(st.wdtNearMiss);                out.ch(',');
+  out.key("wdt_gap_ms");   out.u32(st.wdtMaxGapMs);                out.ch(',');
+  out.key("flash_writes"); out.u32(st.counters.flashWrites);       out.ch(',');
+  out.key("i2c_bytes");    out.u32(st.counters.i2cBytes);          out.ch(',');
+  out.key("awake_pm");     out.u32(st.counters.awakePermille);
+  out.ch('}');
+}
+
+/* บล็อกของเครื่องนี้ — ใช้เป็น extra writer ของ writeStatusJson() */
+static inline void perfWriteJson(JsonOut &out) {
+  perfWriteStateJson(out, perf);
+}
+
+#endif
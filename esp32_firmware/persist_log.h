@@ -0,0 +1,170 @@
+#ifndef PERSIST_LOG_H
+#define PERSIST_LOG_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "esp_attr.h"           // RTC_DATA_ATTR
+#include "esp_rom_crc.h"        // esp_rom_crc32_le()
+#include "perf_probe.h"         // จับเวลาเขียนแฟลช
+
+/* =========================================================
+ * Persist log: บันทึกตัวนับลงแฟลชแบบ "ต่อท้าย" พร้อม CRC + เลขลำดับ
+ *
+ * เดิม nvsSave() เขียน blob ก้อนเดียวทับ key "counters" ทุกครั้งที่รีเซ็ต
+ * และทุกครั้งก่อนเข้า light sleep แม้ตัวนับไม่เปลี่ยน -> แฟลชสึกโดยไม่จำเป็น
+ *
+ * ตอนนี้:
+ * - record = {magic, seq, len, crc} + payload เขียนวนลง key "p0".."p7"
+ *   (slot = seq % PERSIST_LOG_SLOTS) -> ยังเหลือรุ่นก่อนหน้าไว้ถ้ารุ่นล่าสุดเสีย
+ * - CRC ครอบ seq + len + payload: record ที่เขียนไม่จบ/เสียจะถูกข้ามตอนกู้คืน
+ * - ถ้า payload เหมือนครั้งล่าสุด -> ไม่เขียนเลย (รอบ sleep ส่วนใหญ่ไม่มีอะไรเปลี่ยน)
+ * - สำเนาใน RTC RAM (มี CRC เหมือนกัน) อยู่รอดตอน sleep/รีบูตแบบไม่ดับไฟ
+ * - ตอนบูต: เลือก record ที่ valid และ seq ใหม่สุดจาก RTC + ทุก slot
+ *   แล้ว compact: ลบ slot ที่เสีย/ขนาดไม่ตรง
+ * - seq ไม่รีเซ็ตข้ามการรีบูต จึงเป็นตัวนับ "จำนวนครั้งที่เขียนแฟลช" ตลอดอายุบอร์ดด้วย
+ *
+ * ใช้จาก loop()/setup() เท่านั้น (ไม่ต้องมี mutex)
+ * ========================================================= */
+
+#define PERSIST_LOG_NS      "restroom"
+#define PERSIST_LOG_SLOTS   8
+#define PERSIST_LOG_MAX     320          // payload สูงสุด (Persist ของ 32 ห้อง = 292 bytes)
+#define PERSIST_LOG_MAGIC   0x504C4731   // "PLG1"
+
+struct PersistLogHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint16_t len;
+  uint16_t reserved;
+  uint32_t crc;
+};
+
+typedef struct {
+  PersistLogHeader hdr;
+  uint8_t data[PERSIST_LOG_MAX];
+} PersistLogRecord;
+
+RTC_DATA_ATTR PersistLogRecord persistLogRTC = {};
+static PersistLogRecord persistLogBuf;     // บัฟเฟอร์อ่าน/เขียน NVS
+static Preferences persistLogPrefs;
+static uint32_t persistLogSeq     = 0;     // seq ของ record ล่าสุด (= จำนวนครั้งที่เขียนแฟลชสะสม)
+static uint32_t persistLogSkipped = 0;     // จำนวนครั้งที่ข้ามเพราะไม่มีอะไรเปลี่ยน (ตั้งแต่บูต)
+static uint32_t persistLogWrites  = 0;     // จำนวนครั้งที่เขียนแฟลชจริง (ตั้งแต่บูต)
+static uint32_t persistLogLastCrc = 0;     // CRC ของ payload ล่าสุดที่อยู่บนแฟลช
+static bool     persistLogHaveLast = false;
+
+static inline void persistLogKey(char out[4], uint32_t slot) {
+  out[0] = 'p';
+  out[1] = (char)('0' + slot);
+  out[2] = '\0';
+}
+
+static inline uint32_t persistLogCrc(uint32_t seq, uint16_t len, const uint8_t *data) {
+  uint32_t c = esp_rom_crc32_le(0, (const uint8_t *)&seq, sizeof(seq));
+  c = esp_rom_crc32_le(c, (const uint8_t *)&len, sizeof(len));
+  return esp_rom_crc32_le(c, data, len);
+}
+
+static inline bool persistLogValid(const PersistLogRecord &r, size_t expectLen) {
+  return r.hdr.magic == PERSIST_LOG_MAGIC &&
+         r.hdr.len == expectLen && expectLen <= PERSIST_LOG_MAX &&
+         r.hdr.crc == persistLogCrc(r.hdr.seq, r.hdr.len, r.data);
+}
+
+/*
+ * กู้คืน record ใหม่สุดที่ valid ลง payload (ขนาด len)
+ * - เทียบสำเนาใน RTC กับทุก slot ใน NVS
+ * - slot ที่เสีย/ขนาดไม่ตรง (เช่น เปลี่ยนจำนวนห้อง) ถูกลบทิ้ง
+ * คืน false ถ้าไม่มี record ที่ใช้ได้เลย
+ */
+static inline bool persistLogRecover(void *payload, size_t len) {
+  bool found = false;
+  uint32_t bestSeq = 0;
+
+  if (persistLogValid(persistLogRTC, len)) {
+    memcpy(payload, persistLogRTC.data, len);
+    bestSeq = persistLogRTC.hdr.seq;
+    found = true;
+  }
+
+  persistLogPrefs.begin(PERSIST_LOG_NS, false);
+  uint8_t removed = 0;
+  for (uint32_t s = 0; s < PERSIST_LOG_SLOTS; s++) {
+    char key[4];
+    persistLogKey(key, s);
+    size_t sz = persistLogPrefs.getBytesLength(key);
+    if (sz == 0) continue;
+
+    bool ok = sz == sizeof(PersistLogHeader) + len &&
+              persistLogPrefs.getBytes(key, &persistLogBuf, sz) == sz &&
+              persistLogValid(persistLogBuf, len) &&
+              persistLogBuf.hdr.seq % PERSIST_LOG_SLOTS == s;
+    if (!ok) {
+      persistLogPrefs.remove(key);   // compact: record เสีย -> ลบทิ้ง
+      removed++;
+      continue;
+    }
+    if (!found || persistLogBuf.hdr.seq > bestSeq) {
+      memcpy(payload, persistLogBuf.data, len);
+      bestSeq = persistLogBuf.hdr.seq;
+      found = true;
+    }
+  }
+  persistLogPrefs.end();
+
+  if (found) {
+    persistLogSeq      = bestSeq;
+    persistLogLastCrc  = esp_rom_crc32_le(0, (const uint8_t *)payload, len);
+    persistLogHaveLast = true;
+  }
+  Serial.printf("[PERSIST] recover %s seq=%lu (removed %u bad slot)\n",
+                found ? "OK" : "none", (unsigned long)bestSeq, (unsigned)removed);
+  return found;
+}
+
+/*
+ * ต่อท้าย record ใหม่ (ถ้า payload ต่างจากครั้งล่าสุด)
+ * คืน true ถ้าเขียนแฟลชจริง, false ถ้าข้าม (ไม่เปลี่ยน) หรือเขียนไม่สำเร็จ
+ */
+static inline bool persistLogAppend(const void *payload, size_t len) {
+  if (len > PERSIST_LOG_MAX) return false;
+
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)payload, len);
+  if (persistLogHaveLast && crc == persistLogLastCrc) {
+    persistLogSkipped++;
+    return false;
+  }
+
+  PerfScope probe(PERF_NVS);   // วัดเฉพาะครั้งที่เขียนจริง
+  PersistLogRecord &r = persistLogBuf;
+  r.hdr.magic    = PERSIST_LOG_MAGIC;
+  r.hdr.seq      = persistLogSeq + 1;
+  r.hdr.len      = (uint16_t)len;
+  r.hdr.reserved = 0;
+  memcpy(r.data, payload, len);
+  r.hdr.crc = persistLogCrc(r.hdr.seq, r.hdr.len, r.data);
+
+  // RTC ก่อน (ถูกและเร็ว) แล้วค่อยแฟลช
+  memcpy(&persistLogRTC, &r, sizeof(PersistLogHeader) + len);
+
+  char key[4];
+  persistLogKey(key, r.hdr.seq % PERSIST_LOG_SLOTS);
+  persistLogPrefs.begin(PERSIST_LOG_NS, false);
+  size_t put = persistLogPrefs.putBytes(key, &r, sizeof(PersistLogHeader) + len);
+  persistLogPrefs.end();
+  if (put != sizeof(PersistLogHeader) + len) {
+    Serial.println("[PERSIST] NVS write FAIL");
+    return false;
+  }
+
+  persistLogSeq      = r.hdr.seq;
+  persistLogLastCrc  = crc;
+  persistLogHaveLast = true;
+  persistLogWrites++;
+  return true;
+}
+
+/* จำนวนครั้งที่เขียนแฟลชสะสมตลอดอายุบอร์ด (ใช้ประเมินอายุแฟลชในสนาม) */
+static inline uint32_t persistLogFlashWrites() { return persistLogSeq; }
+
+#endif
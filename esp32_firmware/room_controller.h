@@ -0,0 +1,305 @@
+#ifndef ROOM_CONTROLLER_H
+#define ROOM_CONTROLLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* =========================================================
+ * RoomController<N, PinMap>: state machine ของห้องน้ำ N ห้องบนแผงเดียว
+ *
+ * - PinMap เป็น struct ที่มีตารางขาแบบ constexpr:
+ *     static constexpr uint8_t pir[N], door[N], led[N];
+ *     static constexpr bool    reedActiveLow;
+ *   -> ตาราง "ขา -> ห้อง", wake mask ของ light sleep และขนาดข้อมูล persist
+ *      ถูกคำนวณตอนคอมไพล์สำหรับ N ใด ๆ (ไม่มี 3 ฝังในโค้ดอีกต่อไป)
+ * - state เก็บแบบ struct-of-arrays (แต่ละ field เป็น array ยาว N)
+ *   การไล่ scan ทุกห้อง (เช่น anyOccupied) จึงวิ่งบน array ต่อเนื่อง
+ * - ไม่เรียก Arduino/ESP-IDF ตรง ๆ: ผลข้างเคียง (LED, journal, ส่งเน็ต, log)
+ *   ส่งออกผ่าน Sink ที่ผู้เรียกเตรียมให้
+ *     void onSessionStart(size_t room, int64_t tUs);
+ *     void onSessionEnd(size_t room, int64_t endUs, uint32_t durMs,
+ *                       bool byTimeout, bool becameDirty);
+ *
+ * กติกา (เหมือนเดิม):
+ * - เริ่ม "ใช้งาน" เมื่อ PIR มี motion + ประตูปิดและยังไม่อยู่ในสถานะใช้งาน
+ * - จบ "ใช้งาน" เมื่อประตูเปิด หรือไม่มี motion เกิน holdOnMs
+ * - ต้องทำความสะอาดเมื่อ uses >= usesThreshold หรือเวลาสะสม >= totalMsThreshold
+ * ========================================================= */
+
+#define ROOM_NO_DEADLINE INT64_MAX
+
+struct RoomConfig {
+  uint32_t holdOnMs;          // เวลาคอยดับไฟเมื่อไม่มี motion ต่อเนื่อง
+  uint32_t usesThreshold;     // เกณฑ์จำนวนรอบต่อห้องก่อน "ต้องทำความสะอาด"
+  uint32_t totalMsThreshold;  // เกณฑ์เวลาสะสมต่อห้องก่อน "ต้องทำความสะอาด"
+  uint32_t doorDebounceMs;    // รีดสวิตช์ต้องนิ่งเท่านี้ก่อนยอมรับว่าประตูเปลี่ยนสถานะ
+};
+
+/* ESP32: เฉพาะ RTC GPIO เท่านั้นที่ใช้ปลุกจาก light sleep แบบ EXT1 ได้ */
+static constexpr bool isRtcGpio(uint8_t g) {
+  return g == 0 || g == 2 || g == 4 || (g >= 12 && g <= 15) ||
+         (g >= 25 && g <= 27) || (g >= 32 && g <= 39);
+}
+
+/* ตาราง "ขา -> ห้อง" (-1 = ไม่ใช่ขาของห้องใด) */
+#define ROOM_MAX_GPIO 40
+
+struct RoomPinLut {
+  int8_t pir[ROOM_MAX_GPIO];
+  int8_t door[ROOM_MAX_GPIO];
+};
+
+template <size_t N, class PinMap>
+constexpr RoomPinLut makeRoomPinLut() {
+  RoomPinLut t{};
+  for (uint8_t g = 0; g < ROOM_MAX_GPIO; g++) { t.pir[g] = -1; t.door[g] = -1; }
+  for (size_t i = 0; i < N; i++) {
+    t.pir[PinMap::pir[i]]   = (int8_t)i;
+    t.door[PinMap::door[i]] = (int8_t)i;
+  }
+  return t;
+}
+
+template <size_t N, class PinMap>
+constexpr bool roomPirPinsAreRtc() {
+  for (size_t i = 0; i < N; i++) if (!isRtcGpio(PinMap::pir[i])) return false;
+  return true;
+}
+
+template <size_t N, class PinMap>
+class RoomController {
+ public:
+  static constexpr size_t kRooms = N;
+
+  static_assert(N > 0 && N <= 32, "RoomController supports 1..32 rooms");
+  static_assert(sizeof(PinMap::pir)  == N, "PinMap::pir must have N entries");
+  static_assert(sizeof(PinMap::door) == N, "PinMap::door must have N entries");
+  static_assert(sizeof(PinMap::led)  == N, "PinMap::led must have N entries");
+
+  /* ---- state แบบ struct-of-arrays ---- */
+  bool     lightOn[N];            // ตอนนี้ห้องกำลังถูกใช้งานอยู่หรือไม่ (true=มีคน)
+  bool     pirHigh[N];            // ระดับ PIR ล่าสุด (อัปเดตจาก edge)
+  bool     doorClosed[N];         // true = ประตูปิด (รีดปิดวงจร) ที่ยืนยันแล้ว
+  bool     needCleaning[N];       // ธงว่าห้องนี้ถึงเกณฑ์ต้องทำความสะอาดแล้วหรือยัง
+  bool     doorPending[N];        // ประตูเปลี่ยนสถานะแล้วแต่ยังไม่นิ่งพอ (debounce)
+  bool     doorPendingClosed[N];  // สถานะที่รอยืนยัน
+  int64_t  doorPendingUs[N];      // เวลาขอบแรกของการเปลี่ยน (ใช้เป็นเวลาจริงของเหตุการณ์)
+  int64_t  lastMotionUs[N];       // เวลาเกิด motion ครั้งล่าสุด (us)
+  int64_t  sessionStartUs[N];     // เวลาเริ่มรอบการใช้งานครั้งนี้ (us)
+  uint32_t uses[N];               // จำนวนรอบการใช้งาน (นับเพิ่มตอนจบ session)
+  uint32_t totalMs[N];            // เวลาการใช้งานสะสม (ms)
+
+  RoomConfig cfg;
+
+  explicit RoomController(const RoomConfig &c) : cfg(c) { clearAll(); }
+
+  void clearAll() {
+    memset(lightOn, 0, sizeof(lightOn));
+    memset(pirHigh, 0, sizeof(pirHigh));
+    memset(doorClosed, 0, sizeof(doorClosed));
+    memset(needCleaning, 0, sizeof(needCleaning));
+    memset(doorPending, 0, sizeof(doorPending));
+    memset(doorPendingClosed, 0, sizeof(doorPendingClosed));
+    memset(doorPendingUs, 0, sizeof(doorPendingUs));
+    memset(lastMotionUs, 0, sizeof(lastMotionUs));
+    memset(sessionStartUs, 0, sizeof(sessionStartUs));
+    memset(uses, 0, sizeof(uses));
+    memset(totalMs, 0, sizeof(totalMs));
+  }
+
+  /* ---- ค่าที่คำนวณตอนคอมไพล์จาก PinMap ---- */
+  static constexpr RoomPinLut kLut = makeRoomPinLut<N, PinMap>();
+  static_assert(roomPirPinsAreRtc<N, PinMap>(), "every PIR pin must be an RTC GPIO (EXT1 light-sleep wake)");
+
+  static constexpr int roomOfPir(uint8_t pin)  { return pin < ROOM_MAX_GPIO ? kLut.pir[pin]  : -1; }
+  static constexpr int roomOfDoor(uint8_t pin) { return pin < ROOM_MAX_GPIO ? kLut.door[pin] : -1; }
+
+  /* mask ของ PIR ทุกห้องสำหรับ esp_sleep_enable_ext1_wakeup() */
+  static constexpr uint64_t pirWakeMask() {
+    uint64_t m = 0;
+    for (size_t i = 0; i < N; i++) m |= (1ULL << PinMap::pir[i]);
+    return m;
+  }
+
+  /* ขาที่ต้องผูก interrupt (PIR ทั้งหมดตามด้วยประตูทั้งหมด) */
+  static constexpr size_t kEdgePinCount = 2 * N;
+  static void edgePins(uint8_t out[kEdgePinCount]) {
+    for (size_t i = 0; i < N; i++) {
+      out[i]     = PinMap::pir[i];
+      out[N + i] = PinMap::door[i];
+    }
+  }
+
+  static constexpr bool doorLevelIsClosed(bool levelHigh) {
+    return PinMap::reedActiveLow ? !levelHigh : levelHigh;
+  }
+
+  /* ---- สรุปรวมทุกห้อง ---- */
+  bool anyOccupied() const     { for (size_t i = 0; i < N; i++) if (lightOn[i])      return true; return false; }
+  bool anyDoorClosed() const   { for (size_t i = 0; i < N; i++) if (doorClosed[i])   return true; return false; }
+  bool anyNeedCleaning() const { for (size_t i = 0; i < N; i++) if (needCleaning[i]) return true; return false; }
+
+  int64_t lastAnyMotionUs() const {
+    int64_t t = 0;
+    for (size_t i = 0; i < N; i++) if (lastMotionUs[i] > t) t = lastMotionUs[i];
+    return t;
+  }
+
+  /* เวลาเร็วสุดที่ tick() จะเปลี่ยนสถานะเองโดยไม่มี edge ใหม่
+   * (timeout holdOnMs ของห้องที่ PIR ลงแล้ว หรือประตูที่รอนิ่งครบ doorDebounceMs)
+   * ROOM_NO_DEADLINE = ไม่มี -> รอ edge อย่างเดียวก็พอ */
+  int64_t nextDeadlineUs() const {
+    const int64_t holdUs = (int64_t)cfg.holdOnMs * 1000;
+    const int64_t debUs  = (int64_t)cfg.doorDebounceMs * 1000;
+    int64_t t = ROOM_NO_DEADLINE;
+    for (size_t i = 0; i < N; i++) {
+      if (doorPending[i] && doorPendingUs[i] + debUs < t) t = doorPendingUs[i] + debUs;
+      // update() จบ session เมื่อเกิน holdUs (ไม่ใช่เท่ากับ) -> +1us
+      if (lightOn[i] && !pirHigh[i] && lastMotionUs[i] + holdUs + 1 < t) t = lastMotionUs[i] + holdUs + 1;
+    }
+    return t;
+  }
+
+  /* ระดับขาประตูล่าสุดที่ state machine รับรู้ (รวมที่ยังรอ debounce) */
+  bool doorLevelHigh(size_t i) const {
+    bool closed = doorPending[i] ? doorPendingClosed[i] : doorClosed[i];
+    return PinMap::reedActiveLow ? !closed : closed;
+  }
+
+  /* ---- state machine ----
+   * ถูกเรียกทุกครั้งที่มี edge ของห้องนี้ (nowUs = เวลาของ edge) และทุกรอบ loop (nowUs = ตอนนี้)
+   * ตรวจ "จบ" ก่อน "เริ่ม" เพื่อให้ edge ที่มาช้ากว่า holdOnMs ปิดรอบเก่าให้ถูกเวลาก่อนเปิดรอบใหม่
+   */
+  template <class Sink>
+  void update(size_t i, int64_t nowUs, Sink &sink) {
+    const int64_t holdUs = (int64_t)cfg.holdOnMs * 1000;
+
+    /* --- จบ session --- */
+    bool timeout           = lightOn[i] && !pirHigh[i] && (nowUs - lastMotionUs[i] > holdUs);
+    bool doorOpenedWhileOn = lightOn[i] && !doorClosed[i];
+
+    if (timeout || doorOpenedWhileOn) {
+      lightOn[i] = false;
+
+      // เวลาจบจริง: timeout = motion สุดท้าย + holdOnMs, ประตูเปิด = เวลาของ edge
+      int64_t endUs = timeout ? lastMotionUs[i] + holdUs : nowUs;
+      int64_t durUs = endUs - sessionStartUs[i];
+      if (durUs < 0) durUs = 0;
+      uint32_t dur = (uint32_t)((durUs + 500) / 1000);  // ปัดเป็น ms
+
+      uses[i]++;
+      totalMs[i] += dur;
+
+      bool becameDirty = false;
+      if (!needCleaning[i] &&
+          (uses[i] >= cfg.usesThreshold || totalMs[i] >= cfg.totalMsThreshold)) {
+        needCleaning[i] = true;
+        becameDirty = true;
+      }
+      sink.onSessionEnd(i, endUs, dur, timeout, becameDirty);
+    }
+
+    /* --- เริ่ม session --- */
+    if (pirHigh[i]) {
+      if (!lightOn[i] && doorClosed[i]) {
+        lightOn[i]        = true;
+        sessionStartUs[i] = nowUs;
+        sink.onSessionStart(i, nowUs);
+      }
+      // บันทึกเวลามี motion ล่าสุด (ใช้ตัดสินใจ timeout)
+      if (nowUs > lastMotionUs[i]) lastMotionUs[i] = nowUs;
+    }
+  }
+
+  /* ยืนยันสถานะประตูที่นิ่งครบ doorDebounceMs แล้ว (ถึงเวลา nowUs) */
+  template <class Sink>
+  void settleDoors(int64_t nowUs, Sink &sink) {
+    const int64_t debUs = (int64_t)cfg.doorDebounceMs * 1000;
+    for (size_t i = 0; i < N; i++) {
+      if (doorPending[i] && nowUs - doorPendingUs[i] >= debUs) {
+        doorPending[i] = false;
+        doorClosed[i]  = doorPendingClosed[i];
+        update(i, doorPendingUs[i], sink);  // ใช้เวลาขอบแรก = เวลาที่ประตูเปลี่ยนจริง
+      }
+    }
+  }
+
+  /* ป้อน edge หนึ่งรายการ (ประตูที่นิ่งแล้วก่อน edge นี้ถูกยืนยันก่อน) */
+  template <class Sink>
+  void applyEdge(uint8_t pin, bool levelHigh, int64_t tUs, Sink &sink) {
+    settleDoors(tUs, sink);
+
+    int i = roomOfPir(pin);
+    if (i >= 0) {
+      bool wasHigh = pirHigh[i];
+      pirHigh[i] = levelHigh;
+      // motion ต่อเนื่องมาจนถึงขอบขาลง -> นับเป็น motion ล่าสุด
+      if (wasHigh && !levelHigh && tUs > lastMotionUs[i]) lastMotionUs[i] = tUs;
+      update((size_t)i, tUs, sink);
+      return;
+    }
+
+    i = roomOfDoor(pin);
+    if (i >= 0) {
+      bool closed = doorLevelIsClosed(levelHigh);
+      if (closed == doorClosed[i]) {
+        doorPending[i] = false;              // เด้งกลับสถานะเดิม -> ยกเลิก
+      } else if (!doorPending[i] || doorPendingClosed[i] != closed) {
+        doorPending[i]       = true;         // เริ่มนับเวลานิ่งจากขอบแรก
+        doorPendingClosed[i] = closed;
+        doorPendingUs[i]     = tUs;
+      }
+    }
+  }
+
+  /* ตั้งระดับขาใหม่จากการอ่านจริง (ตอนบูต, หลังตื่นจาก sleep, หรือ edge queue ล้น) */
+  void resync(size_t i, bool pirLevelHigh, bool doorLevelHigh, int64_t nowUs) {
+    if (pirHigh[i] && !pirLevelHigh && nowUs > lastMotionUs[i]) lastMotionUs[i] = nowUs;
+    pirHigh[i]     = pirLevelHigh;
+    doorPending[i] = false;
+    doorClosed[i]  = doorLevelIsClosed(doorLevelHigh);
+  }
+
+  /* งานประจำรอบ: ยืนยันประตู + ตรวจ timeout/ต่อเวลา motion ของทุกห้อง */
+  template <class Sink>
+  void tick(int64_t nowUs, Sink &sink) {
+    settleDoors(nowUs, sink);
+    for (size_t i = 0; i < N; i++) update(i, nowUs, sink);
+  }
+
+  /* ล้างตัวนับทุกห้อง (แม่บ้านกดรีเซ็ตหลังทำความสะอาด) */
+  void resetCounters() {
+    memset(uses, 0, sizeof(uses));
+    memset(totalMs, 0, sizeof(totalMs));
+    memset(needCleaning, 0, sizeof(needCleaning));
+  }
+
+  /* ---- Persist: ขนาด blob ขึ้นกับ N (NVS ตรวจขนาดตอนโหลดอยู่แล้ว) ---- */
+  struct Persist {
+    uint32_t magic;
+    uint32_t uses[N];
+    uint32_t totalMs[N];
+    uint8_t  needCleaning[N];
+  };
+
+  void savePersist(Persist &out, uint32_t magic) const {
+    memset(&out, 0, sizeof(out));
+    out.magic = magic;
+    for (size_t i = 0; i < N; i++) {
+      out.uses[i]         = uses[i];
+      out.totalMs[i]      = totalMs[i];
+      out.needCleaning[i] = needCleaning[i] ? 1 : 0;
+    }
+  }
+
+  void loadPersist(const Persist &in) {
+    for (size_t i = 0; i < N; i++) {
+      uses[i]         = in.uses[i];
+      totalMs[i]      = in.totalMs[i];
+      needCleaning[i] = (in.needCleaning[i] != 0);
+    }
+  }
+};
+
+#endif
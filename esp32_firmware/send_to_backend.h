@@ -6,39 +6,31 @@
 #include <esp_wifi.h>
 #include "esp_task_wdt.h"   // ✅ ใช้รีเฟรช watchdog ระหว่างขั้นตอนที่อาจหน่วง (เช่น รอ Wi-Fi/HTTP)
 #include "credentials.h"    // ✅ เก็บค่าคงที่ เช่น DEVICE_ID, API_URL, WIFI_SSID, WIFI_PASS
-
-/* =========================================================
- * โครงสร้างและตัวแปรที่แชร์กับ main (สถานะจริงของห้อง)
- * ========================================================= */
-struct Room {
-  int pirPin;                 // ขา PIR ของห้องนี้ (เพื่อ debug/อ้างอิง)
-  int ledPin;                 // ขา LED ของห้องนี้ (เพื่อ debug/อ้างอิง)
-  bool occupied;              // true = ห้องกำลังใช้งาน (ใช้แสดง state ให้ backend)
-  bool prevOccupied;          // สำรองสถานะก่อนหน้า (เผื่อ logic ภายนอกอยากเช็คการเปลี่ยนแปลง)
-  unsigned long lastMotionMS; // เวลา ms ของ motion ล่าสุด (ช่วยคิด timeout ฝั่ง main)
-  unsigned long sessionStartMS; // เวลา ms ที่เริ่มรอบการใช้งานล่าสุด
-  unsigned long useCount;     // จำนวนรอบการใช้งานสะสม (นับตอนจบ session)
-  unsigned long totalUseMS;   // เวลาการใช้งานสะสมทั้งหมด (ms)
-};
+#include "event_journal.h"  // ✅ journal เหตุการณ์ (เก็บไว้ส่งย้อนหลังเมื่อเน็ตกลับมา)
+#include "status_json.h"    // ✅ ตัวสร้าง JSON ลงบัฟเฟอร์ static (ไม่จอง heap)
+#include "status_sync.h"    // ✅ snapshot/ack/delta/batch payload (ใช้ร่วมกับ tools/fleet_loadgen)
+#include "panel_config.h"   // ✅ panel + ROOM_COUNT (สถานะห้องทั้งหมด)
+#include "http_conn.h"      // ✅ socket keep-alive ใช้ซ้ำข้าม POST + สถิติ latency
+#include "wifi_fast.h"      // ✅ ต่อ AP เดิมจาก BSSID/channel ใน RTC (ไม่ต้องสแกน)
+#include "perf_probe.h"     // ✅ จับเวลา HTTP/Wi-Fi + บล็อก "perf" ใน payload เต็ม
+
+/* ปลายทางแบบ batch (ส่ง event หลายรายการ + สถานะล่าสุดใน POST เดียว) */
+#ifndef API_BATCH_URL
+#define API_BATCH_URL API_URL "/batch"
+#endif
 
 /* ===== ตัวแปรจากไฟล์หลัก (main) ที่เราต้องอ่านเพื่อนำไปส่งขึ้น backend ===== */
+// สถานะจริงของทุกห้อง (ไฟ/ประตู/uses/totalMs) อยู่ใน panel (panel_config.h)
+// ทั้งหมดนี้ loop() (core 1) เป็นผู้แก้ -> อ่านได้จาก loop เท่านั้น net task ใช้สำเนาจาก statusPublish()
 extern bool cleaningRequired;          // ธงรวม: มีอย่างน้อยหนึ่งห้องที่ต้องทำความสะอาด
 extern unsigned long lastCleanTimestamp; // เวลาที่รีเซ็ตเคาน์เตอร์ล่าสุด (ms since boot)
-extern Room rooms[3];                  // สถานะห้องแบบละเอียด
-
-/* Snapshot สำหรับรายงานขึ้น backend (สรุปเฉพาะที่ต้องโชว์/เก็บ) */
-extern uint32_t reportUses[3];         // จำนวนรอบใช้งานของแต่ละห้อง (ที่สรุปแล้ว)
-extern uint32_t reportTotalMs[3];      // เวลาสะสมของแต่ละห้อง (ms)
 extern bool persistLoaded;             // true = main โหลดข้อมูลสะสมจาก NVS/RTC สำเร็จแล้ว
 
-/* ✅ สถานะประตูจาก main (รีดสวิตช์) — ช่วยอธิบายสถานะใช้งานร่วมกับ PIR */
-extern bool doorClosed[3];             // true = ประตูปิด
-
 /* ให้ main รับรู้ผลการส่งครั้งล่าสุด: true = OK, false = ล้มเหลว/ยังไม่ส่ง */
 extern bool backend_ok;
 
 /* =========================================================
- * ส่วนดูแล Wi-Fi: บังคับรีเซ็ตวิทยุ + ป้องกันสแปมการเชื่อมต่อ
+ * ส่วนดูแล Wi-Fi: ต่อเร็วจาก cache + ทางเต็มพร้อมคูลดาวน์เมื่อล้มเหลว
  * ========================================================= */
 
 /* helper: แปลงสถานะ Wi-Fi เป็นคำอ่าน (ใช้กับ log) */
@@ -58,121 +50,180 @@ static inline const char* wlStatusName(wl_status_t s){
 /*
  * wifiEnsure()
  * - เรียกแบบ "idempotent" (เรียกซ้ำได้โดยไม่ก่อสภาวะค้าง) เพื่อให้แน่ใจว่าเราต่อ Wi-Fi อยู่
- * - มีคูลดาวน์ 10s กันการวนเรียกถี่ ๆ
- * - ทำ hard reset radio: disconnect -> WIFI_OFF -> WIFI_STA
- * - ตั้ง timeout 30s พร้อมปริ้นท์จุดทุก 500ms (และรีเฟรช watchdog เพื่อกันค้าง)
+ * - ทางเร็วก่อน: ต่อ AP เดิมจาก BSSID/channel ใน RTC (wifi_fast.h) ไม่ต้องสแกน — ปกติ < 1s
+ * - ทางเต็ม (ไม่มี cache หรือทางเร็วล้มเหลว): สแกน + DHCP, timeout 30s, poll ทีละ 50ms
+ *   (รีเฟรช watchdog ระหว่างรอ) ต่อได้แล้วจำ AP ไว้ให้รอบหน้า
+ * - คูลดาวน์ 10s หลังทางเต็มล้มเหลวเท่านั้น (กันวนสแกนถี่ ๆ) และแจ้ง log เมื่อข้าม
+ *   net task ถาม wifiCoolingDown() ก่อนตั้งรอบส่ง journal ซ้ำ (ไม่ปลุกตัวเองมาแค่เพื่อข้าม)
+ * - พิมพ์เวลาที่ใช้ต่อทุกครั้ง
  */
+#define WIFI_COOLDOWN_MS 10000UL             // ระยะห่างขั้นต่ำก่อนลองทางเต็มใหม่
+static bool          wifiCooling = false;    // ทางเต็มล้มเหลวล่าสุด -> รอคูลดาวน์ (net task เท่านั้น)
+static unsigned long wifiLastFailMs = 0;     // เวลาที่ทางเต็มล้มเหลวล่าสุด
+
+/* ยังอยู่ในช่วงคูลดาวน์หลังทางเต็มล้มเหลว (และยังไม่มีเน็ต) */
+static inline bool wifiCoolingDown() {
+  return wifiCooling && WiFi.status() != WL_CONNECTED &&
+         millis() - wifiLastFailMs < WIFI_COOLDOWN_MS;
+}
+
 static inline void wifiEnsure() {
   static bool inProgress = false;         // กัน reentry ขณะกำลังเชื่อมต่อ
-  static unsigned long lastTryMs = 0;     // บันทึกครั้งล่าสุดที่เริ่ม connect
-  const unsigned long COOLDOWN_MS = 10000;  // ระยะห่างขั้นต่ำระหว่างการลองใหม่
+  static bool skipLogged = false;         // log การข้ามครั้งเดียวต่อรอบคูลดาวน์
 
   // เงื่อนไขหยุดเร็ว (fast-exit) เพื่อลดงานไม่จำเป็น
   if (WiFi.status() == WL_CONNECTED) return;
   if (inProgress) return;
-  if (millis() - lastTryMs < COOLDOWN_MS) return;
 
   inProgress = true;
-  lastTryMs = millis();
-
-  Serial.println("\n[WiFi] Ensure: start");
+  PerfScope probe(PERF_WIFI);   // วัดเฉพาะครั้งที่ต้องต่อจริง
 
-  // ปิดการ reconnect อัตโนมัติชั่วคราว + ไม่แตะค่าใน NVS
-  WiFi.setAutoReconnect(false);
+  // ไม่แตะค่าใน NVS + modem sleep: วิทยุพักระหว่าง beacon ช่วงไม่ได้ส่ง (ต่อ AP อยู่ loop รอใน edgeWait ไม่ tick sleep)
   WiFi.persistent(false);
+  WiFi.setSleep(true);
+
+  // 1) ทางเร็ว: AP เดิม (ไม่ติดคูลดาวน์)
+  if (wifiFastConnect()) {
+    WiFi.setAutoReconnect(true);
+    wifiCooling = false;
+    inProgress = false;
+    return;
+  }
 
+  // 2) ทางเต็ม
+  if (wifiCooling && millis() - wifiLastFailMs < WIFI_COOLDOWN_MS) {
+    if (!skipLogged) {
+      Serial.printf("[WiFi] cooldown after failure, skip connect (%lu ms left)\n",
+                    (unsigned long)(WIFI_COOLDOWN_MS - (millis() - wifiLastFailMs)));
+      skipLogged = true;
+    }
+    inProgress = false;
+    return;
+  }
+
+  Serial.println("\n[WiFi] Ensure: full connect");
+
+  // ปิดการ reconnect อัตโนมัติชั่วคราว (กันชนกับการ begin ของเราเอง)
+  WiFi.setAutoReconnect(false);
   WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASS);
-  WiFi.setSleep(false);
+  wifiUseDhcp();   // ทางเต็มขอ lease ใหม่เสมอ (ไม่ใช้ static ที่ทางเร็วอาจตั้งค้างไว้)
 
   Serial.printf("[WiFi] Connecting to SSID='%s' ...\n", WIFI_SSID);
+  unsigned long t0 = millis();
   WiFi.begin(WIFI_SSID, WIFI_PASS);
 
   // วนรอด้วย timeout = 30s พร้อมรีเฟรช watchdog (กันบอร์ดรีเซ็ตเพราะรอนาน)
   const unsigned long TIMEOUT_MS = 30000UL;
-  unsigned long t0 = millis();
+  const unsigned long POLL_MS = 50;
+  unsigned long lastDot = t0;
   while (WiFi.status() != WL_CONNECTED && millis() - t0 < TIMEOUT_MS) {
-    delay(500);
-    Serial.print(".");
+    delay(POLL_MS);
+    if (millis() - lastDot >= 500) { Serial.print("."); lastDot = millis(); }
 
     // ✅ รีเฟรช watchdog ระหว่างรอ Wi-Fi (ขั้นตอนที่มีโอกาสนาน)
     esp_task_wdt_reset();
   }
 
+  uint32_t dt = millis() - t0;
+  wifiStats.lastMs = dt;
   wl_status_t st = WiFi.status();
-  Serial.printf("\n[WiFi] status=%d (%s)\n", st, wlStatusName(st));
+  Serial.printf("\n[WiFi] status=%d (%s) after %lu ms\n", st, wlStatusName(st), (unsigned long)dt);
   if (st == WL_CONNECTED) {
-    Serial.printf("[WiFi] Connected, IP=%s  RSSI=%d dBm\n",
-                  WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    Serial.printf("[WiFi] Connected, IP=%s  RSSI=%d dBm  ch=%ld\n",
+                  WiFi.localIP().toString().c_str(), WiFi.RSSI(), (long)WiFi.channel());
     WiFi.setAutoReconnect(true); // เปิด auto-reconnect เมื่อเชื่อมสำเร็จ
+    wifiFastRemember(true);      // จำ AP + lease ไว้ให้รอบหน้าต่อเร็ว
+    wifiStats.fullOk++;
+    if (dt > wifiStats.fullMaxMs) wifiStats.fullMaxMs = dt;
+    wifiCooling = false;
   } else {
     Serial.println("[WiFi] Failed. (เช็ค SSID/PASS, ใช้ 2.4GHz/WPA2, ปิด MAC filter)");
+    wifiStats.fullFail++;
+    wifiCooling = true;
+    skipLogged = false;
+    wifiLastFailMs = millis();
   }
 
   inProgress = false;
 }
 
 /* =========================================================
- * Helper แปลงสถานะห้อง -> string สำหรับ JSON
+ * สำเนาสถานะที่ loop() เผยแพร่ให้ net task
+ * - panel/cleaningRequired/lastCleanTimestamp ถูกแก้โดย loop() บน core 1
+ *   net task (core 0) อ่านตรง ๆ ไม่ได้ (อาจได้ uses ใหม่คู่กับ totalMs เก่ากลาง session จบ)
+ * - loop() เรียก statusPublish() ทุกครั้งที่ขอส่ง (netRequestStatus / heartbeat LINE)
+ *   คัดลอกลง statusShared ใน critical section สั้น ๆ (ไม่กี่สิบ byte, ไม่มี I/O)
+ * - net task คัดลอกออกด้วย statusTake() แล้วใช้สำเนานั้นตลอดการส่งรอบนั้น
  * ========================================================= */
-static inline const char* roomStateWord(bool occupied, bool cleaning) {
-  // ถ้ามีธง cleaningRequired รวม ให้ state ทุกห้องเป็น "cleaning"
-  if (cleaning) return "cleaning";
-  // ไม่เช่นนั้นแสดง occupied/vacant ตามจริงของห้อง
-  return occupied ? "occupied" : "vacant";
+struct StatusShared {
+  RoomReport    rooms[ROOM_COUNT];
+  bool          cleaningRequired;
+  bool          persistLoaded;
+  unsigned long lastCleanTimestamp;
+};
+
+static portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+static StatusShared statusShared = {};   // เขียนโดย statusPublish (loop), อ่านโดย statusTake (net task)
+
+/* ฝั่ง loop(): สร้าง snapshot จาก panel แล้วเผยแพร่ */
+static inline void statusPublish() {
+  StatusShared s;
+  statusSnapshot(panel, cleaningRequired, s.rooms);   // อ่าน panel ตรง ๆ -> loop() เท่านั้น
+  s.cleaningRequired   = cleaningRequired;
+  s.persistLoaded      = persistLoaded;
+  s.lastCleanTimestamp = lastCleanTimestamp;
+  portENTER_CRITICAL(&statusMux);
+  statusShared = s;
+  portEXIT_CRITICAL(&statusMux);
+}
+
+/* ฝั่ง net task: คัดลอก snapshot ล่าสุดที่ loop เผยแพร่ */
+static inline void statusTake(StatusShared &out) {
+  portENTER_CRITICAL(&statusMux);
+  out = statusShared;
+  portEXIT_CRITICAL(&statusMux);
 }
 
 /* =========================================================
- * สร้าง JSON payload ที่จะยิงไป backend
- * โครง:
- * {
- *   "device_id": "...",
- *   "last_clean_ts_ms": <ms>,
- *   "cleaning_required": true/false,
- *   "rooms": [
- *      {"room_id":1,"state":"occupied|vacant|cleaning","use_count":N,"total_use_ms":M,"door_closed":true/false},
- *      ...
- *   ],
- *   "ts_ms": <เวลาสร้าง payload>
- * }
+ * Delta: snapshot ล่าสุดที่ backend ยืนยันแล้ว (กติกาอยู่ใน status_sync.h) — net task เท่านั้น
  * ========================================================= */
-static inline String buildStatusJson() {
-  unsigned long now = millis();
-
-  String j = "{";
-  j += "\"device_id\":\"" + String(DEVICE_ID) + "\",";                 // ระบุแผง/ดีไวซ์
-  j += "\"last_clean_ts_ms\":" + String(lastCleanTimestamp) + ",";      // ช่วย frontend คำนวณตั้งแต่รีเซ็ต
-  j += "\"cleaning_required\":" + String(cleaningRequired ? "true" : "false") + ",";
-
-  j += "\"rooms\":[";
-  for (int i = 0; i < 3; i++) {
-    j += "{";
-    j += "\"room_id\":" + String(i+1) + ",";                            // ใช้ 1..3 เพื่อแสดงผล
-    j += "\"state\":\""; j += roomStateWord(rooms[i].occupied, cleaningRequired); j += "\","; // สถานะสรุป
-    j += "\"use_count\":" + String(reportUses[i]) + ",";                 // ใช้ snapshot เพื่อความสม่ำเสมอ
-    j += "\"total_use_ms\":" + String(reportTotalMs[i]) + ",";           // เวลาสะสม (ms)
-    j += "\"door_closed\":" + String(doorClosed[i] ? "true" : "false");  // สถานะประตูจากรีดสวิตช์
-    j += "}";
-    if (i < 2) j += ",";                                                // คั่นรายการ (ยกเว้นตัวสุดท้าย)
-  }
-  j += "],";
+#ifndef STATUS_DEBUG_PAYLOAD
+#define STATUS_DEBUG_PAYLOAD  0      // 1 = พิมพ์ payload ทุกครั้งที่ส่ง (ดีบักเท่านั้น)
+#endif
 
-  j += "\"ts_ms\":" + String(now);                                      // เวลาสร้าง payload
-  j += "}";
-  return j;
+static StatusAck statusAck = {};
+
+/* payload สถานะของเครื่องนี้จาก snapshot ที่ loop เผยแพร่ (เต็มแนบ perf, delta เทียบ statusAck) */
+static inline StatusDoc statusDocOf(const StatusShared &st, bool delta) {
+  return statusDoc(DEVICE_ID, st.lastCleanTimestamp, st.cleaningRequired, st.rooms,
+                   statusAck, delta, millis(), perfWriteJson);
+}
+
+/* socket ถาวรไป backend (API_URL และ API_BATCH_URL อยู่ host เดียวกัน) — net task เท่านั้น */
+static inline HttpEndpoint &backendEndpoint() {
+  static WiFiClient   sock;
+  static HttpEndpoint ep;
+  static bool         inited = false;
+  if (!inited) {
+    httpEndpointInit(ep, "backend", &sock);
+    inited = true;
+  }
+  return ep;
 }
 
 /* =========================================================
- * ส่ง HTTP POST ทันที (เรียกจาก main เมื่อมีอัปเดตสำคัญ)
+ * ส่ง HTTP POST ทันที (เรียกจาก net task เมื่อมีอัปเดตสำคัญ)
  * ลอจิก:
  * 1) เคลียร์ backend_ok = false (จนกว่าจะยืนยันได้ว่าสำเร็จ)
  * 2) wifiEnsure() ให้แน่ใจว่ามีเน็ต (รีเฟรช WDT ระหว่างรอ)
- * 3) ถ้า persistLoaded ยัง false -> ข้าม (กันส่งข้อมูลไม่ครบ)
- * 4) สร้าง payload และยิงไป API_URL
- * 5) ถ้าได้ code 200 และ body มี "ok": true -> ตั้ง backend_ok = true
- * 6) รีเฟรช WDT หลัง HTTP เผื่อช้า
+ * 3) ถ้า snapshot ยังไม่มีข้อมูลสะสมจาก persist -> ข้าม (กันส่งข้อมูลไม่ครบ)
+ * 4) สร้าง payload (เต็มหรือ delta) ลงบัฟเฟอร์ static และยิงไป API_URL
+ * 5) ถ้าได้ code 200 และ body มี "ok": true -> ตั้ง backend_ok = true + จำ snapshot เป็น ack
+ * 6) รีเฟรช WDT หลัง HTTP เผื่อช้า (ทำใน httpPost)
  * ========================================================= */
 static inline void sendStatusImmediately() {
+  static char buf[STATUS_JSON_BUF];   // ใช้จาก net task เท่านั้น
+
   backend_ok = false; // เริ่มต้นให้ถือว่ายังไม่สำเร็จ (fail-fast จนกว่าจะพิสูจน์ได้)
 
   wifiEnsure();                // พยายามต่อ Wi-Fi (มีคูลดาวน์ในตัว)
@@ -185,44 +236,103 @@ static inline void sendStatusImmediately() {
   }
 
   // รอจน main โหลด persist เสร็จ (กันส่งข้อมูลครึ่ง ๆ กลาง ๆ ไปโชว์)
-  if (!persistLoaded) {
+  StatusShared st;
+  statusTake(st);
+  if (!st.persistLoaded) {
     Serial.println("[WARN] Persist not loaded yet; skip send.");
     return;
   }
 
-  // สร้าง payload JSON
-  String payload = buildStatusJson();
+  // สร้าง payload JSON (delta ถ้ามี ack แล้วและยังไม่ถึงรอบส่งเต็ม)
+  bool delta = statusUseDelta(statusAck);
 
+  JsonOut out(buf, sizeof(buf));
+  if (!writeStatusDoc(out, statusDocOf(st, delta))) {
+    Serial.println("[ERR] status payload overflow; skip send.");
+    return;
+  }
+
+#if STATUS_DEBUG_PAYLOAD
   // พิมพ์ payload เพื่อ debug เวลาเกิดปัญหาหลังบ้าน/ฟรอนต์เอนด์
   Serial.println("[DEBUG] payload:");
-  Serial.println(payload);
-
-  HTTPClient http;
-  http.begin(API_URL);                         // ปลายทาง FastAPI /api/restroom/status
-  http.addHeader("Content-Type", "application/json");
-
-  // ยิง POST (อาจช้า → มีรีเฟรช watchdog หลังคำสั่งนี้)
-  int code = http.POST(payload);
-
-  // ✅ รีเฟรช watchdog หลัง HTTP (กันกรณีเน็ตหน่วงยาว)
-  esp_task_wdt_reset();
+  Serial.println(buf);
+#endif
+
+  // ยิง POST ผ่าน socket ถาวรของ backend (มีรีเฟรช watchdog ในตัว)
+  HttpEndpoint &ep = backendEndpoint();
+  String resp;
+  int code;
+  {
+    PerfScope probe(PERF_HTTP);
+    code = httpPost(ep, API_URL, (const uint8_t *)buf, out.len, nullptr, resp,
+                    true);   // snapshot/delta ส่งซ้ำได้ (merge ซ้ำได้ผลเดิม)
+  }
 
   // แสดงผลลัพธ์จากเซิร์ฟเวอร์
-  Serial.printf("[HTTP] POST %s -> code=%d\n", API_URL, code);
+  Serial.printf("[HTTP] POST %s (%s, %u bytes) -> code=%d (%lu ms)\n",
+                API_URL, delta ? "delta" : "full", (unsigned)out.len, code,
+                (unsigned long)ep.lastMs);
+  // สำเร็จ = code 200 และ body มี "ok": true -> ให้ main ทราบว่า “ส่งล่าสุด ok”
+  // อย่างอื่น (เช่น need_full หลัง backend รีสตาร์ต) -> รอบหน้าส่งเต็ม
+  backend_ok = statusAfterPost(statusAck, st.rooms, delta, code, resp.c_str());
   if (code > 0) {
-    String resp = http.getString();
-    Serial.println(resp);
-
-    // เงื่อนไขถือว่าสำเร็จ: code=200 และใน body มี "ok": true
-    if (code == 200 && resp.indexOf("\"ok\": true") >= 0) {
-      backend_ok = true;       // ให้ main ทราบว่า “ส่งล่าสุด ok”
-    }
+    if (!backend_ok) Serial.println(resp);
   } else {
-    // code <= 0 มักคือ error ภายใน หรือเชื่อมต่อปลายทางไม่ได้
+    // code <= 0 มักคือ error ภายใน หรือเชื่อมต่อปลายทางไม่ได้ (ลองต่อใหม่ไปแล้ว 1 ครั้ง)
     Serial.println("[HTTP] Failed to send data.");
   }
+}
+
+/* =========================================================
+ * Batch: ส่ง event ที่ค้างใน journal + สถานะล่าสุดใน POST เดียว (โครง payload: writeBatchJson())
+ * event ทุกตัวถูกจดลง journal แม้ออนไลน์ (backend ใช้เป็นประวัติการใช้งาน) จึงแทบทุกสถานะที่เกิดจาก event
+ * ไปทาง batch -> status ใน batch ต้องเป็น delta ได้ด้วย ไม่เช่นนั้นโหมด delta ได้ใช้แค่ตอน heartbeat
+ * ========================================================= */
+/*
+ * sendJournalBatch()
+ * - ส่ง event ที่ค้างไม่เกิน JOURNAL_BATCH_MAX รายการ (พ่วงสถานะล่าสุด)
+ * - ลบออกจาก journal เฉพาะเมื่อได้ 200 + ok เท่านั้น
+ * - ok แต่ need_full (backend ไม่มีฐานของ delta): event ถูกรับแล้ว แต่สถานะยังไม่ถือว่า ack
+ *   -> statusAck.have = false, ผู้เรียกส่งสถานะเต็มตามไป
+ * - คืน true ถ้าส่งสำเร็จ (ผู้เรียกวนต่อได้จน journal ว่าง)
+ */
+static inline bool sendJournalBatch() {
+  static JournalEvent batch[JOURNAL_BATCH_MAX];   // ใช้จาก net task เท่านั้น
+  static char buf[BATCH_JSON_BUF];
+
+  StatusShared st;
+  statusTake(st);
+  if (WiFi.status() != WL_CONNECTED || !st.persistLoaded) return false;
+
+  uint16_t n = journalPeekBatch(batch, JOURNAL_BATCH_MAX);
+  if (n == 0) return false;
+
+  bool delta = statusUseDelta(statusAck);
+  JsonOut out(buf, sizeof(buf));
+  if (!writeBatchJson(out, statusDocOf(st, delta), journalBootId(), batch, n)) {
+    Serial.println("[ERR] batch payload overflow; skip send.");
+    return false;
+  }
 
-  http.end();
+  // host เดียวกับ API_URL -> ใช้ socket เดียวกัน
+  HttpEndpoint &ep = backendEndpoint();
+  String resp;
+  int code;
+  {
+    PerfScope probe(PERF_HTTP);
+    code = httpPost(ep, API_BATCH_URL, (const uint8_t *)buf, out.len, nullptr, resp,
+                    true);   // backend กันซ้ำด้วย (device, boot, seq)
+  }
+  bool ok = statusAfterBatch(statusAck, st.rooms, delta, code, resp.c_str());
+
+  Serial.printf("[HTTP] POST batch (%u events, %s status, %u bytes) -> code=%d (%lu ms)%s\n",
+                n, delta ? "delta" : "full", (unsigned)out.len, code, (unsigned long)ep.lastMs,
+                ok ? "" : " (kept in journal)");
+  if (ok) {
+    journalCommit(n);
+    if (statusAck.have) backend_ok = true;   // status ที่พ่วงไปถูกรับ (ไม่ใช่ need_full) ถือว่าอัปเดตแล้ว
+  }
+  return ok;
 }
 
-#endif
\ No newline at end of file
+#endif
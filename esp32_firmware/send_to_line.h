@@ -4,6 +4,16 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>  // ✅ ใช้ TLS/HTTPS กับ LINE API
+#include "http_conn.h"         // ✅ socket TLS ถาวร (keep-alive) + สถิติ latency
+#include "perf_probe.h"        // ✅ จับเวลา push
+#include "panel_config.h"      // ✅ ROOM_COUNT -> ขนาดข้อความ heartbeat
+
+/* heartbeat สรุปทุกห้องในข้อความเดียว: หัว ~40 byte + "\nR<nn> uses=<uint32>" ไม่เกิน 21 byte ต่อห้อง
+ * แผงใหญ่ -> ช่องข้อความในคิวขยายตาม (3 ห้องยังใช้ 160 เท่าเดิม) */
+#define LINE_BEAT_TEXT_MAX  (40 + ROOM_COUNT * 21 + 1)
+#define LINE_TEXT_MAX       (LINE_BEAT_TEXT_MAX > 160 ? LINE_BEAT_TEXT_MAX : 160)
+#include "line_dispatch.h"     // ✅ คิวแจ้งเตือน: รวมสูงสุด 5 ข้อความ/push + จำกัดอัตรา + ถอยเมื่อ 429
+#include "esp_random.h"        // esp_fill_random() -> X-Line-Retry-Key ของแต่ละชุด
 
 /* ===== CONFIG =====
  * ⚠️ หมายเหตุด้านความปลอดภัย:
@@ -15,6 +25,12 @@ static const char* LINE_TOKEN =
 static const char* LINE_TO_ID =
   "Uba5eb45419be7c60b7897936b355e743"; // userId ผู้รับ (ต้องเคยทัก OA มาก่อน ถึง push ได้)
 
+// ปลายทาง push API (override ได้ เช่น -DLINE_PUSH_URL='"http://192.168.1.10:8080/push"'
+// เพื่อวัด latency กับ server ทดสอบในเครื่อง; ขึ้นต้น http:// -> ใช้ socket ธรรมดา)
+#ifndef LINE_PUSH_URL
+#define LINE_PUSH_URL "https://api.line.me/v2/bot/message/push"
+#endif
+
 /* -------------------------------------------------------
  * helper: แปลงสถานะ Wi-Fi (enum) → string เพื่อพิมพ์ log
  * ----------------------------------------------------- */
@@ -31,113 +47,142 @@ static inline const char* line_wlStatusName(wl_status_t s){
   }
 }
 
+/* socket ถาวรไป LINE: สร้างครั้งเดียว ไม่ new/delete ทุกข้อความ — net task เท่านั้น */
+static inline HttpEndpoint &lineEndpoint() {
+  static WiFiClientSecure tls;
+  static WiFiClient       plain;
+  static HttpEndpoint     ep;
+  static bool             inited = false;
+  if (!inited) {
+    tls.setInsecure();  // ⚠️ ข้ามการตรวจ cert (ปลอดภัยน้อยกว่า) — ใช้สำหรับทดสอบ/Dev
+    bool https = strncmp(LINE_PUSH_URL, "https://", 8) == 0;
+    httpEndpointInit(ep, "line", https ? (WiFiClient *)&tls : &plain);
+    inited = true;
+  }
+  return ep;
+}
+
+/* คิวแจ้งเตือน (net task เท่านั้น) */
+static LineDispatcher lineDispatch = {};
+
+#define LINE_JSON_BUF (64 + LINE_BATCH_MAX * (2 * LINE_TEXT_MAX + 32))   // escape อย่างมาก ~2 เท่า
+
 /* -------------------------------------------------------
- * sendLineMessage(message)
+ * sendLinePush(json, len, retryKey)
  *
  * หน้าที่:
  * - ส่ง “push message” (ข้อความเชิงรุก) ไปยังผู้ใช้ปลายทาง LINE OA
  * - เรียกใช้ LINE Messaging API: /v2/bot/message/push (HTTPS)
  *
  * เงื่อนไขสำคัญ:
- * - ต้องเชื่อม Wi-Fi แล้ว (มิฉะนั้น return ทันที)
+ * - ต้องเชื่อม Wi-Fi แล้ว (มิฉะนั้นคืน 0 ทันที)
  * - ผู้รับ (to) ต้อง “เคยคุยกับ OA” มาก่อนแล้วเท่านั้น (ข้อจำกัดของ LINE)
  * - ใช้ Bearer Token ใน header “Authorization”
+ * - retryKey (UUID ของชุด) ใส่ใน header “X-Line-Retry-Key” ทุกครั้งที่ส่งชุดนี้
+ *   ครั้งก่อน LINE รับไปแล้วแต่คำตอบหาย -> LINE ตอบ 409 ไม่ส่งข้อความซ้ำให้ผู้ใช้
+ * - POST ผ่าน socket TLS ถาวร (lineEndpoint): ถ้า LINE ยังไม่ปิด socket
+ *   ข้อความถัดไปไม่ต้อง TLS handshake ใหม่; socket ที่ใช้ซ้ำตาย -> ต่อใหม่แล้วลองอีกครั้ง
+ *   (รวมกรณีหลุดหลังส่งแล้ว เพราะ retry key ทำให้ push ส่งซ้ำได้)
  *
- * ขั้นตอน:
- * 1) ตรวจสถานะ Wi-Fi
- * 2) สร้าง WiFiClientSecure (TLS) แล้วตั้งค่า (ตอนนี้ setInsecure เพื่อข้ามตรวจ cert สำหรับทดสอบ)
- * 3) http.begin() ชี้ endpoint LINE push API
- * 4) ใส่ header: Content-Type และ Authorization
- * 5) escape ข้อความ (แทน " → \") กัน JSON พัง
- * 6) สร้าง payload JSON ตามรูปแบบของ LINE API
- * 7) http.POST(payload) แล้วพิมพ์ผลลัพธ์/response
- * 8) ปิดการเชื่อมต่อและคืนหน่วยความจำ
- *
+ * คืน HTTP code (<= 0 = ส่งไม่สำเร็จ)
  * ----------------------------------------------------- */
-static inline void sendLineMessage(const String &message) {
-  // 1) ต้องต่อเน็ตก่อน ไม่งั้นไม่ทำอะไร
+static inline int sendLinePush(const char *json, size_t len, const char *retryKey) {
   if (WiFi.status() != WL_CONNECTED) {
     Serial.printf("[LINE] ❌ WiFi not connected (status=%s)\n",
                   line_wlStatusName(WiFi.status()));
-    return;
+    return 0;
   }
 
-  // 2) เตรียม HTTPS client (TLS)
-  WiFiClientSecure *client = new WiFiClientSecure;
-  if (!client) {
-    Serial.println("[LINE] ❌ no mem for WiFiClientSecure");
-    return;
-  }
-  client->setInsecure();  // ⚠️ ข้ามการตรวจ cert (ปลอดภัยน้อยกว่า) — ใช้สำหรับทดสอบ/Dev
+  // header Authorization สร้างครั้งเดียว
+  static const String auth = String("Bearer ") + LINE_TOKEN;
 
-  HTTPClient http;
-
-  // 3) เปิดการเชื่อมต่อไปยัง LINE push endpoint
-  if (!http.begin(*client, "https://api.line.me/v2/bot/message/push")) {
-    Serial.println("[LINE] ❌ http.begin() failed");
-    delete client;
-    return;
+  HttpEndpoint &ep = lineEndpoint();
+  String resp;
+  int httpCode;
+  {
+    PerfScope probe(PERF_LINE);
+    httpCode = httpPost(ep, LINE_PUSH_URL, (const uint8_t *)json, len, auth.c_str(), resp, true,
+                        "X-Line-Retry-Key", retryKey);
   }
 
-  // 4) ใส่ header ตามที่ LINE กำหนด
-  http.addHeader("Content-Type", "application/json");
-  http.addHeader("Authorization", String("Bearer ") + LINE_TOKEN);
-
-  // 5) escape เครื่องหมาย " ภายในข้อความ กัน JSON แตก
-  String safeMsg = message;
-  safeMsg.replace("\"", "\\\"");
-
-  // 6) สร้าง payload ตามสเปค LINE (to=userId, messages=[{type:"text", text:"..."}])
-  String payload =
-    String("{\"to\":\"") + LINE_TO_ID + "\","
-    "\"messages\":[{\"type\":\"text\",\"text\":\"" + safeMsg + "\"}]}";
-
-  // 7) ส่ง HTTP POST แล้วพิมพ์ผลลัพธ์
-  int httpCode = http.POST(payload);
+  Serial.printf("[LINE] POST /push -> code=%d (%lu ms) key=%s\n", httpCode, (unsigned long)ep.lastMs, retryKey);
+  if (httpCode == 409) {
+    Serial.println("[LINE] retry key already accepted -> batch was delivered earlier");
+  } else if (httpCode <= 0) {
+    Serial.println("[LINE] HTTP POST failed (maybe TLS / cert / no internet?)");
+  } else if (httpCode < 200 || httpCode >= 300) {
+    Serial.printf("[LINE] resp: %s\n", resp.c_str());   // LINE บอกเหตุผลใน body (สำเร็จมักว่างเปล่า)
+  }
+  return httpCode;
+}
 
-  Serial.printf("[LINE] POST /push -> code=%d\n", httpCode);
-  if (httpCode > 0) {
-    String resp = http.getString();          // body จาก LINE (มักว่างเปล่าเมื่อสำเร็จ)
-    Serial.printf("[LINE] resp: %s\n", resp.c_str());
+/* -------------------------------------------------------
+ * linePushPending(nowMs)
+ * ส่ง push 1 ครั้งถ้าคิวถึงเวลา (พ้นหน้าต่างรวมข้อความ / ระยะห่างขั้นต่ำ / backoff)
+ * ผู้เรียกควร wifiEnsure() ก่อน; คืน true ถ้าได้ส่ง (สำเร็จหรือไม่ก็ตาม)
+ * ----------------------------------------------------- */
+static inline bool linePushPending(uint32_t nowMs) {
+  if (lineDispatchWaitMs(lineDispatch, nowMs) != 0) return false;
+
+  static char buf[LINE_JSON_BUF];
+  const LineMsg *batch[LINE_BATCH_MAX];
+  uint8_t rnd[16];
+  esp_fill_random(rnd, sizeof(rnd));   // ใช้เฉพาะชุดใหม่ (ชุดที่ส่งซ้ำใช้ retry key เดิม)
+  uint8_t n = lineDispatchBatch(lineDispatch, batch, rnd);
+
+  JsonOut out(buf, sizeof(buf));
+  int code;
+  if (lineDispatchBuildJson(out, LINE_TO_ID, batch, n)) {
+    code = sendLinePush(buf, out.len, lineDispatch.retryKey);
   } else {
-    Serial.println("[LINE] HTTP POST failed (maybe TLS / cert / no internet?)");
+    Serial.println("[LINE] payload overflow -> drop batch");
+    code = 400;                 // ส่งซ้ำก็ไม่พอดีบัฟเฟอร์ -> ทิ้งเหมือน LINE ปฏิเสธ
   }
 
-  // 8) ปิดการเชื่อมต่อและคืนหน่วยความจำ
-  http.end();
-  delete client;
+  lineDispatchResult(lineDispatch, batch, n, code, millis());
+  Serial.printf("[LINE] %u msg(s) in 1 push, %u still queued", (unsigned)n, (unsigned)lineDispatch.count);
+  if (lineDispatch.backoffMs) Serial.printf(", retry in %lu ms", (unsigned long)lineDispatch.backoffMs);
+  Serial.println();
+  return true;
+}
+
+static inline void lineDispatchPrintStats() {
+  const LineDispatchStats &st = lineDispatch.st;
+  Serial.printf("[LINE] queued=%lu merged=%lu beatSkip=%lu dropped=%lu pushes=%lu msgs=%lu 429=%lu fail=%lu pending=%u\n",
+                (unsigned long)st.queued, (unsigned long)st.merged, (unsigned long)st.beatsSkipped,
+                (unsigned long)st.dropped, (unsigned long)st.pushes, (unsigned long)st.msgsSent,
+                (unsigned long)st.rateLimited, (unsigned long)st.failures, (unsigned)lineDispatch.count);
 }
 
 /* -------------------------------------------------------
  * Helpers สำหรับข้อความสำเร็จรูปที่ใช้ในโปรเจกต์
- * (เรียกฟังก์ชันเดียวจบ ไม่ต้องต่อสตริงเองซ้ำ ๆ)
+ * (ใส่คิวแล้วกลับทันที — linePushPending() เป็นผู้ส่งจริง)
  * ----------------------------------------------------- */
 
 // แจ้งว่าห้องหมายเลข X ถึงเกณฑ์ต้องทำความสะอาด พร้อมจำนวนรอบที่ใช้ไป
 static inline void notifyCleaningRequired(int roomIndex, unsigned long useCount) {
-  String m = "🚨 Room " + String(roomIndex+1) +
-             " needs cleaning (" + String(useCount) + " uses)";
-  sendLineMessage(m);
+  char m[LINE_TEXT_MAX];
+  snprintf(m, sizeof(m), "🚨 Room %d needs cleaning (%lu uses)", roomIndex + 1, useCount);
+  lineDispatchAdd(lineDispatch, LINE_MSG_CLEANING, (uint16_t)roomIndex, m, millis());
 }
 
 // แจ้งเมื่อกดรีเซ็ตตัวนับ (ถือว่าแม่บ้านทำความสะอาดแล้ว)
 static inline void notifyCountersReset() {
-  sendLineMessage("✅ Counters have been reset. All rooms marked clean.");
+  lineDispatchAdd(lineDispatch, LINE_MSG_RESET, 0,
+                  "✅ Counters have been reset. All rooms marked clean.", millis());
 }
 
 // ส่งสรุปสถานะคร่าว ๆ แบบ heartbeat (ให้รู้ว่ายังมีชีวิต + รวมจำนวนรอบต่อห้อง)
-// *ถ้าเด้งบ่อยไปสามารถย้ายไปเรียกเป็นระยะเวลานานขึ้นหรือปิดได้
+// heartbeat ที่ค้างอยู่ถูกแทนด้วยตัวล่าสุด และถ้าเหมือนครั้งที่ส่งไปแล้วจะไม่ส่งซ้ำถี่ ๆ
 static inline void notifyHeartbeatSummary(bool cleaningRequired,
-                                          unsigned long totalUse0,
-                                          unsigned long totalUse1,
-                                          unsigned long totalUse2) {
-  String m = "💡 Heartbeat\n";
-  m += "CleaningRequired=";
-  m += (cleaningRequired ? "YES" : "NO");
-  m += "\nR1 uses=" + String(totalUse0);
-  m += "\nR2 uses=" + String(totalUse1);
-  m += "\nR3 uses=" + String(totalUse2);
-  sendLineMessage(m);
+                                          const uint32_t *uses,
+                                          size_t roomCount) {
+  static char m[LINE_TEXT_MAX];   // net task เท่านั้น (แผงใหญ่ไม่ต้องกิน stack)
+  int n = snprintf(m, sizeof(m), "💡 Heartbeat\nCleaningRequired=%s", cleaningRequired ? "YES" : "NO");
+  for (size_t i = 0; i < roomCount && n > 0 && (size_t)n < sizeof(m); i++) {
+    n += snprintf(m + n, sizeof(m) - n, "\nR%u uses=%lu", (unsigned)(i + 1), (unsigned long)uses[i]);
+  }
+  lineDispatchAdd(lineDispatch, LINE_MSG_HEARTBEAT, 0, m, millis());
 }
 
-#endif
\ No newline at end of file
+#endif
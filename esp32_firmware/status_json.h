@@ -0,0 +1,149 @@
+#ifndef STATUS_JSON_H
+#define STATUS_JSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* =========================================================
+ * ตัวสร้าง JSON แบบไม่จองหน่วยความจำ (zero-allocation)
+ *
+ * เดิม buildStatusJson() ต่อ String ด้วย += หลายสิบครั้งต่อการส่ง 1 ครั้ง
+ * -> heap ถูกจอง/คืนถี่ ๆ จนแตกเป็นชิ้น (fragment) บนเครื่องที่รันยาว ๆ
+ * ตอนนี้: เขียนลงบัฟเฟอร์ที่ผู้เรียกเตรียมไว้ (static) ตรง ๆ ไม่มี malloc เลย
+ *
+ * - JsonOut: ตัวเขียนแบบต่อท้าย ถ้าล้นบัฟเฟอร์จะตั้งธง overflow (ไม่เขียนเกิน)
+ * - writeStatusJson(): payload เดียวกับของเดิม + โหมด delta
+ *   (ใส่เฉพาะห้องที่เปลี่ยนจากครั้งล่าสุดที่ backend ยืนยันแล้ว)
+ * - ไม่พึ่ง Arduino.h เพื่อให้คอมไพล์บนเครื่อง PC ได้ด้วย
+ * ========================================================= */
+
+struct JsonOut {
+  char  *buf;
+  size_t cap;
+  size_t len;
+  bool   overflow;
+
+  JsonOut(char *b, size_t c) : buf(b), cap(c), len(0), overflow(false) {
+    if (cap) buf[0] = '\0';
+  }
+
+  void put(const char *s, size_t n) {
+    if (overflow || len + n + 1 > cap) { overflow = true; return; }
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+  }
+  void raw(const char *s) { put(s, strlen(s)); }
+  void ch(char c)         { put(&c, 1); }
+
+  void u32(uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    char out[10];
+    for (int i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    put(out, n);
+  }
+  void boolean(bool b) { raw(b ? "true" : "false"); }
+
+  // สตริงพร้อม escape " \ และตัวควบคุม (ข้อความ LINE มีขึ้นบรรทัดใหม่)
+  void str(const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    ch('"');
+    for (; *s; s++) {
+      uint8_t c = (uint8_t)*s;
+      if (c == '"' || c == '\\') { ch('\\'); ch((char)c); }
+      else if (c == '\n')        raw("\\n");
+      else if (c == '\r')        raw("\\r");
+      else if (c == '\t')        raw("\\t");
+      else if (c < 0x20)         { raw("\\u00"); ch(hex[c >> 4]); ch(hex[c & 15]); }
+      else                       ch((char)c);
+    }
+    ch('"');
+  }
+
+  // "key":  (ใช้คู่กับ u32/boolean/str ต่อท้าย)
+  void key(const char *k) { ch('"'); raw(k); raw("\":"); }
+};
+
+/* ส่งแบบเต็มทุกกี่ครั้งที่ได้ ack (ที่เหลือเป็น delta) — ใช้ทั้ง POST สถานะและ batch */
+#define STATUS_FULL_EVERY 10
+
+/* สถานะห้องที่ต้องรายงาน (snapshot ณ ตอนส่ง) */
+enum RoomReportState : uint8_t {
+  ROOM_VACANT   = 0,
+  ROOM_OCCUPIED = 1,
+  ROOM_CLEANING = 2,
+};
+
+struct RoomReport {
+  uint8_t  state;       // RoomReportState
+  bool     doorClosed;
+  uint32_t uses;
+  uint32_t totalMs;
+};
+
+static inline bool roomReportEqual(const RoomReport &a, const RoomReport &b) {
+  return a.state == b.state && a.doorClosed == b.doorClosed &&
+         a.uses == b.uses && a.totalMs == b.totalMs;
+}
+
+static inline const char* roomReportStateWord(uint8_t s) {
+  switch (s) {
+    case ROOM_CLEANING: return "cleaning";
+    case ROOM_OCCUPIED: return "occupied";
+    default:            return "vacant";
+  }
+}
+
+/* เขียน field เพิ่มท้าย object ("key":value โดยไม่ต้องใส่ comma นำหน้า) */
+typedef void (*JsonExtraWriter)(JsonOut &out);
+
+/*
+ * เขียน payload สถานะลง out
+ * - acked == nullptr  -> payload เต็ม (ทุกห้อง) เหมือนของเดิม
+ * - acked != nullptr  -> โหมด delta: "delta":true และ rooms มีเฉพาะห้องที่ต่างจาก acked
+ * - extra != nullptr  -> ต่อ field เพิ่มหลัง ts_ms (เช่น บล็อก "perf")
+ * คืน true ถ้าเขียนครบ (ไม่ล้นบัฟเฟอร์)
+ */
+static inline bool writeStatusJson(JsonOut &out,
+                                   const char *deviceId,
+                                   uint32_t lastCleanMs,
+                                   bool cleaningRequired,
+                                   const RoomReport *rooms,
+                                   size_t roomCount,
+                                   const RoomReport *acked,
+                                   uint32_t tsMs,
+                                   JsonExtraWriter extra = nullptr) {
+  out.ch('{');
+  out.key("device_id");         out.str(deviceId);              out.ch(',');
+  out.key("last_clean_ts_ms");  out.u32(lastCleanMs);           out.ch(',');
+  out.key("cleaning_required"); out.boolean(cleaningRequired);  out.ch(',');
+  if (acked) { out.key("delta"); out.boolean(true); out.ch(','); }
+
+  out.key("rooms");
+  out.ch('[');
+  bool first = true;
+  for (size_t i = 0; i < roomCount; i++) {
+    if (acked && roomReportEqual(rooms[i], acked[i])) continue;  // delta: ห้องนี้ไม่เปลี่ยน
+    if (!first) out.ch(',');
+    first = false;
+    out.ch('{');
+    out.key("room_id");      out.u32((uint32_t)(i + 1));                   out.ch(',');
+    out.key("state");        out.str(roomReportStateWord(rooms[i].state)); out.ch(',');
+    out.key("use_count");    out.u32(rooms[i].uses);                       out.ch(',');
+    out.key("total_use_ms"); out.u32(rooms[i].totalMs);                    out.ch(',');
+    out.key("door_closed");  out.boolean(rooms[i].doorClosed);
+    out.ch('}');
+  }
+  out.ch(']');
+  out.ch(',');
+
+  out.key("ts_ms"); out.u32(tsMs);
+  if (extra) { out.ch(','); extra(out); }
+  out.ch('}');
+  return !out.overflow;
+}
+
+#endif
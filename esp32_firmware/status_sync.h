@@ -0,0 +1,207 @@
+#ifndef STATUS_SYNC_H
+#define STATUS_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "status_json.h"     // JsonOut + writeStatusJson()
+#include "journal_event.h"   // JournalEvent ใน payload batch
+#include "perf_probe.h"      // PERF_JSON_MAX (บล็อก "perf" ใน payload เต็ม)
+#include "panel_config.h"    // Panel + ROOM_COUNT
+
+/* =========================================================
+ * กติกาซิงก์สถานะกับ backend (ไม่พึ่ง Arduino.h)
+ * ใช้ร่วมกันระหว่างบอร์ดจริง (send_to_backend.h) กับตัวยิงโหลดบน PC (tools/fleet_loadgen)
+ *
+ * - statusSnapshot(): panel -> RoomReport ของทุกห้อง
+ * - StatusAck: snapshot ล่าสุดที่ backend ยืนยันแล้ว (ฐานของ delta) + นับรอบส่งเต็ม
+ * - writeStatusDoc() / writeBatchJson(): payload POST สถานะ และ /batch (event + สถานะ)
+ * - statusAfterPost() / statusAfterBatch(): แปลผลตอบกลับ -> อัปเดต ack
+ *   (ok / need_full) ให้รอบหน้าเลือกเต็มหรือ delta ถูก
+ * ========================================================= */
+
+#ifndef STATUS_PERF
+#define STATUS_PERF 1                // 1 = แนบบล็อก "perf" (histogram เวลา) กับ payload เต็ม (ไม่แนบกับ delta)
+#endif
+#if STATUS_PERF
+#define STATUS_JSON_BUF       (160 + ROOM_COUNT * 110 + PERF_JSON_MAX)  // หัว ~120 + ห้องละ ~100 bytes + perf
+#else
+#define STATUS_JSON_BUF       (160 + ROOM_COUNT * 110)  // หัว ~120 + ห้องละ ~100 bytes (3 ห้อง = 490)
+#endif
+#define BATCH_JSON_BUF        (STATUS_JSON_BUF + JOURNAL_BATCH_MAX * 112)
+
+/*
+ * Snapshot สถานะห้อง -> RoomReport (ป้อนให้ตัวสร้าง JSON ใน status_json.h)
+ * - ถ้ามีธง cleaningRequired รวม ให้ state ทุกห้องเป็น "cleaning"
+ * - ไม่เช่นนั้นแสดง occupied/vacant ตามจริงของห้อง
+ */
+static inline void statusSnapshot(const Panel &p, bool cleaningRequired, RoomReport out[ROOM_COUNT]) {
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    out[i].state      = cleaningRequired ? ROOM_CLEANING
+                      : p.lightOn[i]     ? ROOM_OCCUPIED
+                                         : ROOM_VACANT;
+    out[i].doorClosed = p.doorClosed[i];   // สถานะประตูจากรีดสวิตช์ (หลัง debounce)
+    out[i].uses       = p.uses[i];         // จำนวนรอบที่จบแล้ว
+    out[i].totalMs    = p.totalMs[i];      // เวลาสะสม (ms)
+  }
+}
+
+/*
+ * Delta: จำ snapshot ล่าสุดที่ backend ยืนยัน (200 + ok) แล้ว
+ * - ครั้งต่อไปส่งเฉพาะห้องที่เปลี่ยน ("delta":true)
+ * - ส่งแบบเต็มทุก STATUS_FULL_EVERY ครั้ง หรือเมื่อยังไม่เคยได้ ack
+ *   (เช่นหลังบูต หรือ backend รีสตาร์ตแล้วตอบ need_full)
+ * - ใช้กติกาเดียวกันทั้ง POST สถานะเดี่ยวและ "status" ใน batch
+ */
+struct StatusAck {
+  RoomReport rooms[ROOM_COUNT];
+  bool       have;
+  uint8_t    sinceFull;
+};
+
+/* รอบนี้ส่ง delta ได้ไหม (มี ack แล้วและยังไม่ถึงรอบส่งเต็ม) */
+static inline bool statusUseDelta(const StatusAck &a) {
+  return a.have && a.sinceFull < STATUS_FULL_EVERY;
+}
+
+/* backend ตอบรับ snapshot นี้แล้ว -> จำไว้เป็นฐานของ delta ครั้งถัดไป */
+static inline void statusAccepted(StatusAck &a, const RoomReport snap[ROOM_COUNT], bool delta) {
+  memcpy(a.rooms, snap, sizeof(a.rooms));
+  a.have      = true;
+  a.sinceFull = delta ? a.sinceFull + 1 : 0;
+}
+
+/* ตรวจ body ว่า backend ตอบ ok (FastAPI ส่ง JSON แบบไม่มีช่องว่าง จึงรับทั้งสองแบบ) */
+static inline bool statusRespOk(const char *resp) {
+  return strstr(resp, "\"ok\":true") || strstr(resp, "\"ok\": true");
+}
+
+/* backend ไม่มีฐานให้ต่อ delta (เช่นเพิ่งรีสตาร์ต) */
+static inline bool statusRespNeedFull(const char *resp) {
+  return strstr(resp, "\"need_full\":true") || strstr(resp, "\"need_full\": true");
+}
+
+/*
+ * ผล POST สถานะเดี่ยว คืน true ถ้า backend รับ (200 + ok)
+ * ตอบอย่างอื่น (เช่น need_full) -> รอบหน้าส่งเต็ม; ส่งไม่ถึง (code <= 0) -> ack เดิมยังใช้ได้
+ */
+static inline bool statusAfterPost(StatusAck &a, const RoomReport snap[ROOM_COUNT], bool delta,
+                                   int code, const char *resp) {
+  if (code <= 0) return false;
+  if (code == 200 && statusRespOk(resp)) {
+    statusAccepted(a, snap, delta);
+    return true;
+  }
+  a.have = false;
+  return false;
+}
+
+/*
+ * ผล POST batch คืน true ถ้า event ถูกรับ (ลบออกจาก journal ได้)
+ * ok แต่ need_full: event ถูกรับแล้ว แต่สถานะยังไม่ถือว่า ack -> a.have = false ผู้เรียกส่งสถานะเต็มตามไป
+ */
+static inline bool statusAfterBatch(StatusAck &a, const RoomReport snap[ROOM_COUNT], bool delta,
+                                    int code, const char *resp) {
+  if (code != 200 || !statusRespOk(resp)) return false;
+  if (statusRespNeedFull(resp)) a.have = false;
+  else                          statusAccepted(a, snap, delta);
+  return true;
+}
+
+/* ทุกอย่างที่ payload สถานะหนึ่งชิ้นต้องใช้ */
+struct StatusDoc {
+  const char       *deviceId;
+  uint32_t          lastCleanMs;
+  bool              cleaningRequired;
+  const RoomReport *rooms;         // ROOM_COUNT ห้อง
+  const RoomReport *acked;         // nullptr = payload เต็ม, ไม่เช่นนั้น delta เทียบกับชุดนี้
+  uint32_t          tsMs;
+  JsonExtraWriter   perfWriter;    // บล็อก "perf" (ใส่เฉพาะ payload เต็ม เมื่อ STATUS_PERF)
+};
+
+/* doc ของรอบนี้: delta เทียบกับ ack, payload เต็มแนบบล็อก "perf" */
+static inline StatusDoc statusDoc(const char *deviceId, uint32_t lastCleanMs, bool cleaningRequired,
+                                  const RoomReport snap[ROOM_COUNT], const StatusAck &a, bool delta,
+                                  uint32_t tsMs, JsonExtraWriter perfWriter) {
+  StatusDoc d;
+  d.deviceId         = deviceId;
+  d.lastCleanMs      = lastCleanMs;
+  d.cleaningRequired = cleaningRequired;
+  d.rooms            = snap;
+  d.acked            = delta ? a.rooms : nullptr;
+  d.tsMs             = tsMs;
+  d.perfWriter       = (STATUS_PERF && !delta) ? perfWriter : nullptr;
+  return d;
+}
+
+/*
+ * payload สถานะ:
+ * {
+ *   "device_id": "...",
+ *   "last_clean_ts_ms": <ms>,
+ *   "cleaning_required": true/false,
+ *   "delta": true,                      <- เฉพาะโหมด delta
+ *   "rooms": [
+ *      {"room_id":1,"state":"occupied|vacant|cleaning","use_count":N,"total_use_ms":M,"door_closed":true/false},
+ *      ...
+ *   ],
+ *   "ts_ms": <เวลาสร้าง payload>,
+ *   "perf": {...}                       <- เฉพาะ payload เต็ม
+ * }
+ */
+static inline bool writeStatusDoc(JsonOut &out, const StatusDoc &d) {
+  return writeStatusJson(out, d.deviceId, d.lastCleanMs, d.cleaningRequired,
+                         d.rooms, ROOM_COUNT, d.acked, d.tsMs, d.perfWriter);
+}
+
+static inline const char* journalKindWord(uint8_t kind) {
+  switch (kind) {
+    case JEV_START: return "start";
+    case JEV_END:   return "end";
+    case JEV_RESET: return "reset";
+    default:        return "unknown";
+  }
+}
+
+/*
+ * payload batch:
+ * {
+ *   "device_id": "...",
+ *   "boot_id": B,                       <- บูตปัจจุบัน (ts_ms นับจากบูตนี้)
+ *   "ts_ms": <ms>,
+ *   "events": [
+ *      {"seq":N,"boot_id":B,"room_id":1,"kind":"start|end|reset","ts_ms":T,"dur_ms":D},
+ *      ...
+ *   ],
+ *   "status": { ...payload แบบ writeStatusDoc() (เต็ม หรือ delta ตามกติกาเดียวกับ POST สถานะ)... }
+ * }
+ */
+static inline bool writeBatchJson(JsonOut &out, const StatusDoc &d, uint16_t bootId,
+                                  const JournalEvent *ev, uint16_t n) {
+  out.ch('{');
+  out.key("device_id"); out.str(d.deviceId);  out.ch(',');
+  out.key("boot_id");   out.u32(bootId);      out.ch(',');
+  out.key("ts_ms");     out.u32(d.tsMs);      out.ch(',');
+  out.key("events");
+  out.ch('[');
+  for (uint16_t i = 0; i < n; i++) {
+    if (i) out.ch(',');
+    out.ch('{');
+    out.key("seq");     out.u32(ev[i].seq);                         out.ch(',');
+    out.key("boot_id"); out.u32(ev[i].boot);                        out.ch(',');
+    // room_id ใช้ 1..N เหมือน payload ปกติ (0 = ทุกห้อง สำหรับ reset)
+    out.key("room_id"); out.u32(ev[i].room == JOURNAL_ALL_ROOMS ? 0 : ev[i].room + 1); out.ch(',');
+    out.key("kind");    out.str(journalKindWord(ev[i].kind));       out.ch(',');
+    out.key("ts_ms");   out.u32(ev[i].tsMs);                        out.ch(',');
+    out.key("dur_ms");  out.u32(ev[i].durMs);
+    out.ch('}');
+  }
+  out.ch(']');
+  out.ch(',');
+  out.key("status");
+  writeStatusDoc(out, d);
+  out.ch('}');
+  return !out.overflow;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef WIFI_FAST_H
+#define WIFI_FAST_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "esp_attr.h"           // RTC_DATA_ATTR
+#include "esp_rom_crc.h"        // esp_rom_crc32_le()
+#include "esp_task_wdt.h"
+#include "event_journal.h"      // journalBootId()
+
+/* =========================================================
+ * ต่อ Wi-Fi แบบเร็วหลังตื่นจาก light sleep / รีบูต
+ *
+ * เดิม: ทุกครั้งที่หลุด wifiEnsure() สแกนทุกช่อง + DHCP ใหม่ และ poll ทีละ 500ms
+ *       -> กว่าจะ POST แรกหลังตื่นได้ใช้หลายวินาที
+ * ตอนนี้:
+ * - ต่อสำเร็จครั้งใด -> จำ BSSID + channel ของ AP (และ IP/gateway/mask/DNS) ไว้ใน RTC RAM
+ * - ครั้งถัดไป WiFi.begin(ssid, pass, channel, bssid) ตรงไปที่ AP เดิม ไม่ต้องสแกน
+ *   และ poll ทีละ WIFI_FAST_POLL_MS ไม่เกิน WIFI_FAST_TIMEOUT_MS
+ * - (ทางเลือก) WIFI_FAST_STATIC_IP=1: ใช้ IP เดิมแบบ static ข้าม DHCP ด้วย
+ *   เฉพาะ lease ที่ได้มาในการบูตเดียวกันและอายุไม่เกิน WIFI_FAST_LEASE_MS
+ *   (DHCP server ไม่รู้ว่าเรายังใช้ IP อยู่ จึงต้องกลับไปขอใหม่ก่อน lease จริงหมด)
+ * - ต่อเร็วไม่สำเร็จ -> ลบ cache แล้วให้ผู้เรียกไปทางเต็ม (สแกน + DHCP)
+ * - cache มี CRC: RTC RAM ที่เสีย/เพิ่งจ่ายไฟจะไม่ถูกใช้
+ *
+ * ใช้จาก net task เท่านั้น
+ * ========================================================= */
+
+#ifndef WIFI_FAST_STATIC_IP
+#define WIFI_FAST_STATIC_IP 0
+#endif
+
+#define WIFI_FAST_MAGIC       0x57464331          // "WFC1"
+#define WIFI_FAST_TIMEOUT_MS  1500                // รอ AP เดิมไม่เกินเท่านี้ก่อนถอยไปทางเต็ม
+#define WIFI_FAST_POLL_MS     20
+#define WIFI_FAST_LEASE_MS    (30UL * 60UL * 1000UL)   // ใช้ IP เดิมซ้ำได้ไม่เกิน 30 นาทีหลังได้ lease
+
+struct WifiFastCache {
+  uint32_t magic;
+  uint8_t  bssid[6];
+  uint8_t  channel;
+  uint8_t  haveIp;
+  uint32_t ip, gateway, mask, dns;
+  uint16_t leaseBootId;     // journalBootId() ตอนได้ lease (บูตใหม่ -> millis() เริ่มใหม่ อายุ lease ไม่น่าเชื่อถือ)
+  uint16_t reserved;
+  uint32_t leaseAtMs;       // millis() ตอนได้ lease จาก DHCP
+  uint32_t crc;
+};
+
+RTC_DATA_ATTR WifiFastCache wifiFastRTC = {};
+
+/* สถิติการต่อ (ดูใน log/perf) */
+struct WifiConnectStats {
+  uint32_t fastOk, fastFail;
+  uint32_t fullOk, fullFail;
+  uint32_t lastMs;          // เวลาที่ใช้ต่อครั้งล่าสุด
+  uint32_t fastMaxMs;
+  uint32_t fullMaxMs;
+};
+static WifiConnectStats wifiStats = {};
+
+static inline uint32_t wifiFastCrc(const WifiFastCache &c) {
+  return esp_rom_crc32_le(0, (const uint8_t *)&c, offsetof(WifiFastCache, crc));
+}
+
+static inline bool wifiFastValid() {
+  return wifiFastRTC.magic == WIFI_FAST_MAGIC &&
+         wifiFastRTC.channel >= 1 && wifiFastRTC.channel <= 14 &&
+         wifiFastRTC.crc == wifiFastCrc(wifiFastRTC);
+}
+
+static inline void wifiFastInvalidate() {
+  wifiFastRTC.magic = 0;
+}
+
+/* lease ของ IP ใน cache ยังใช้ซ้ำแบบ static ได้ไหม */
+static inline bool wifiFastLeaseUsable() {
+  return WIFI_FAST_STATIC_IP && wifiFastRTC.haveIp &&
+         wifiFastRTC.leaseBootId == journalBootId() &&
+         millis() - wifiFastRTC.leaseAtMs < WIFI_FAST_LEASE_MS;
+}
+
+/*
+ * จำ AP ที่ต่ออยู่ตอนนี้ (เรียกหลังต่อสำเร็จ)
+ * freshLease = true ถ้า IP ตอนนี้มาจาก DHCP (ไม่ใช่ static จาก cache) -> เริ่มนับอายุ lease ใหม่
+ */
+static inline void wifiFastRemember(bool freshLease) {
+  WifiFastCache c = wifiFastRTC;
+  c.magic = WIFI_FAST_MAGIC;
+  memcpy(c.bssid, WiFi.BSSID(), sizeof(c.bssid));
+  c.channel = (uint8_t)WiFi.channel();
+  if (freshLease) {
+    c.haveIp      = 1;
+    c.ip          = (uint32_t)WiFi.localIP();
+    c.gateway     = (uint32_t)WiFi.gatewayIP();
+    c.mask        = (uint32_t)WiFi.subnetMask();
+    c.dns         = (uint32_t)WiFi.dnsIP();
+    c.leaseBootId = journalBootId();
+    c.leaseAtMs   = millis();
+  }
+  c.crc = wifiFastCrc(c);
+  wifiFastRTC = c;
+}
+
+/* กลับไปใช้ DHCP (netif จำ static จาก cache ไว้ข้ามการ begin -> ต้องเรียกก่อนทุกครั้งที่ไม่ได้ใช้ static) */
+static inline void wifiUseDhcp() {
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+}
+
+/*
+ * ต่อ AP เดิมจาก cache โดยไม่สแกน
+ * คืน true ถ้าต่อได้ภายใน WIFI_FAST_TIMEOUT_MS; false = ไม่มี cache หรือไม่สำเร็จ (cache ถูกลบ)
+ */
+static inline bool wifiFastConnect() {
+  if (!wifiFastValid()) return false;
+
+  bool staticIp = wifiFastLeaseUsable();
+  uint32_t t0 = millis();
+
+  WiFi.mode(WIFI_STA);
+  if (staticIp) {
+    WiFi.config(IPAddress(wifiFastRTC.ip), IPAddress(wifiFastRTC.gateway),
+                IPAddress(wifiFastRTC.mask), IPAddress(wifiFastRTC.dns));
+  } else {
+    wifiUseDhcp();   // lease ใน cache หมดอายุแล้ว -> อย่าใช้ static ที่ค้างจากรอบก่อน
+  }
+  WiFi.begin(WIFI_SSID, WIFI_PASS, wifiFastRTC.channel, wifiFastRTC.bssid, true);
+
+  while (WiFi.status() != WL_CONNECTED && millis() - t0 < WIFI_FAST_TIMEOUT_MS) {
+    delay(WIFI_FAST_POLL_MS);
+    esp_task_wdt_reset();
+  }
+
+  uint32_t dt = millis() - t0;
+  wifiStats.lastMs = dt;
+  if (WiFi.status() != WL_CONNECTED) {
+    wifiStats.fastFail++;
+    Serial.printf("[WiFi] fast reconnect FAIL after %lu ms (ch=%u) -> full connect\n",
+                  (unsigned long)dt, (unsigned)wifiFastRTC.channel);
+    WiFi.disconnect();
+    wifiFastInvalidate();           // ทางเต็มจะกลับไปใช้ DHCP เอง
+    return false;
+  }
+
+  wifiStats.fastOk++;
+  if (dt > wifiStats.fastMaxMs) wifiStats.fastMaxMs = dt;
+  wifiFastRemember(!staticIp);
+  Serial.printf("[WiFi] fast reconnect OK in %lu ms (ch=%u, %s)  IP=%s\n",
+                (unsigned long)dt, (unsigned)wifiFastRTC.channel,
+                staticIp ? "cached IP" : "DHCP", WiFi.localIP().toString().c_str());
+  return true;
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef VISIT_GEN_H
+#define VISIT_GEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+
+/* =========================================================
+ * คนเข้าห้องสังเคราะห์ (ใช้ร่วมกันทุกเครื่องมือบน PC: room_sim / room_scale / fleet_loadgen)
+ *
+ * - เวลามาถึง: Poisson แบบอัตราไม่คงที่ (thinning) กลางวัน 07-21 น. ถี่กว่ากลางคืน (nightFactor)
+ * - อยู่ในห้อง log-normal median 3 นาที (20s .. 15 นาที)
+ * - ประตูปิด (รีดเด้ง 0-3 ครั้ง) -> PIR เป็นพัลส์ HIGH 2-5s เว้น 0.5-6s
+ *   (1% เป็นช่วงนั่งนิ่ง 8-20s เกิน HOLD_ON_MS ได้) -> ประตูเปิด
+ * - คนถัดไปของห้องเดียวกันมาได้หลังคนนี้ออกอย่างน้อย 10-120s
+ *
+ * ขาใช้ตาม PinMap (PanelPins หรือแผงสมมติ) ส่ง edge ออกทาง emit(const PinEdge &)
+ * ลำดับการสุ่มคงที่ -> seed เดิมได้ trace เดิมทุกเครื่องมือ
+ *
+ * คอมไพล์: เพิ่ม -Itools/common
+ * ========================================================= */
+
+#define CLEANER_DELAY_US (10LL * 60 * 1000000)   // แม่บ้านมากดรีเซ็ตหลังแจ้งเตือน 10 นาที
+
+struct PinEdge {
+  int64_t tUs;
+  uint8_t pin;
+  uint8_t level;
+};
+
+/* ใช้กับ std::priority_queue ให้ edge เร็วสุดอยู่บน */
+struct EdgeLater {
+  bool operator()(const PinEdge &a, const PinEdge &b) const { return a.tUs > b.tUs; }
+};
+
+/* ground truth: คนเข้าห้อง (ประตูปิด) .. ออก (ประตูเปิด) */
+struct Visit {
+  uint8_t room;
+  int64_t startUs;
+  int64_t endUs;
+};
+
+struct VisitParams {
+  double ratePerHour;           // คน/ชม./ห้อง ช่วงกลางวัน
+  double clockOffsetS = 0.0;    // เวลาเสมือน 0 = กี่วินาทีหลังเที่ยงคืน
+  double nightFactor  = 0.1;    // อัตรานอก 07-21 น. เทียบกลางวัน (1.0 = คงที่ทั้งวัน)
+};
+
+/* สุ่มเวลามาถึง + ระยะเวลาของคนถัดไปหลัง afterUs (ยังไม่สร้าง edge) */
+template <class Rng>
+static inline Visit visitDraw(Rng &rng, size_t room, int64_t afterUs, const VisitParams &p) {
+  std::uniform_real_distribution<double> U(0.0, 1.0);
+  std::normal_distribution<double> logDur(log(180.0), 0.6);
+
+  double t = afterUs / 1e6;
+  for (;;) {
+    t += -log(1.0 - U(rng)) * 3600.0 / p.ratePerHour;
+    double hour = fmod((t + p.clockOffsetS) / 3600.0, 24.0);
+    double f = (hour >= 7.0 && hour < 21.0) ? 1.0 : p.nightFactor;
+    if (U(rng) < f) break;
+  }
+  double durS = std::min(900.0, std::max(20.0, exp(logDur(rng))));
+  return {(uint8_t)room, (int64_t)(t * 1e6), (int64_t)((t + durS) * 1e6)};
+}
+
+/* ประตูเปลี่ยนระดับ + รีดเด้ง 0-3 ครั้ง */
+template <class Rng, class Emit>
+static inline void visitEmitDoor(Rng &rng, uint8_t pin, int64_t t, bool level, Emit &emit) {
+  std::uniform_int_distribution<int> bounces(0, 3);
+  std::uniform_int_distribution<int> jitterUs(300, 1500);
+  emit(PinEdge{t, pin, (uint8_t)level});
+  int n = bounces(rng);
+  for (int k = 0; k < n; k++) {
+    t += jitterUs(rng);
+    emit(PinEdge{t, pin, (uint8_t)!level});
+    t += jitterUs(rng);
+    emit(PinEdge{t, pin, (uint8_t)level});
+  }
+}
+
+/* สร้าง edge ของคนหนึ่งคน คืนเวลาที่เริ่มสุ่มคนถัดไปของห้องนี้ได้ */
+template <class PinMap, class Rng, class Emit>
+static inline int64_t visitEmit(Rng &rng, const Visit &v, Emit emit) {
+  std::uniform_real_distribution<double> U(0.0, 1.0);
+  auto uni = [&](double a, double b) { return a + (b - a) * U(rng); };
+  auto us  = [](double s) { return (int64_t)(s * 1e6); };
+  const bool closedLvl = !PinMap::reedActiveLow;
+
+  visitEmitDoor(rng, PinMap::door[v.room], v.startUs, closedLvl, emit);
+  double p = v.startUs / 1e6 + uni(0.3, 2.0);
+  while (us(p) < v.endUs) {
+    double hi = uni(2.0, 5.0);
+    emit(PinEdge{us(p), PinMap::pir[v.room], 1});
+    emit(PinEdge{us(p + hi), PinMap::pir[v.room], 0});
+    p += hi + (U(rng) < 0.01 ? uni(8.0, 20.0) : uni(0.5, 6.0));
+  }
+  visitEmitDoor(rng, PinMap::door[v.room], v.endUs, !closedLvl, emit);
+  return v.endUs + us(uni(10.0, 120.0));
+}
+
+#endif
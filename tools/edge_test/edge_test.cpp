@@ -0,0 +1,235 @@
+/* =========================================================
+ * edge_test: ทดสอบ edge_capture.h (ไฟล์จริง ไม่แก้) บนเครื่อง PC
+ *
+ * Arduino/ESP-IDF ถูกแทนด้วยของปลอมใน tools/edge_test/fake (fake_idf.h):
+ * ระดับขาอยู่ในตัวแปร, ISR ถูกเรียกตรง ๆ เมื่อเทสต์เปลี่ยนระดับขาที่ interrupt เปิดอยู่
+ *
+ * ครอบคลุม:
+ * - edgeCaptureBegin: ผูก CHANGE ครบทุกขาของแผง (Panel::edgePins)
+ * - ISR -> ring: ลำดับ FIFO, เวลา, ระดับขา (ทั้งขา < 32 และ >= 32), ปลุก loop task
+ * - ring ล้น: เก็บ EDGE_QUEUE_LEN ตัวแรก ตั้งธง overflow, edgeTakeOverflow คืน true ครั้งเดียว
+ * - head/tail วนรอบ uint32 ไม่ทำให้ลำดับเสีย
+ * - edgeWait: ไม่ block ถ้ามี event ค้าง
+ * - edgeSleepArm: มี edge ค้าง -> false + เปิด interrupt คืน, ว่าง -> ปลุกแบบ level ตรงข้าม
+ * - edgeSleepDisarm: edge สังเคราะห์ (เวลา = wakeUs) เฉพาะขาที่เปลี่ยนระหว่างหลับ
+ *   + interrupt กลับเป็น ANYEDGE, ขาที่เปลี่ยนระหว่างหลับไม่ถูกนับซ้ำโดย ISR
+ * ไม่ผ่านข้อใด -> exit 1
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -Itools/edge_test/fake -Iesp32_firmware tools/edge_test/edge_test.cpp -o edge_test
+ *
+ * ใช้งาน:
+ *   ./edge_test
+ * ========================================================= */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "panel_config.h"     // Panel::edgePins (ขาจริงของแผง)
+#include "edge_capture.h"
+
+static int failures = 0;
+static int checks = 0;
+
+#define CHECK(cond, ...)                                 \
+  do {                                                   \
+    checks++;                                            \
+    if (!(cond)) {                                       \
+      failures++;                                        \
+      printf("  FAIL %s:%d: ", __FILE__, __LINE__);      \
+      printf(__VA_ARGS__);                               \
+      printf("\n");                                      \
+    }                                                    \
+  } while (0)
+
+static uint8_t pins[Panel::kEdgePinCount];
+
+static size_t drain() {
+  EdgeEvent e;
+  size_t n = 0;
+  while (edgePop(e)) n++;
+  return n;
+}
+
+static void testBegin() {
+  printf("begin\n");
+  edgeCaptureBegin(pins, Panel::kEdgePinCount);
+  CHECK(edgeWaiter == xTaskGetCurrentTaskHandle(), "waiter not set to loop task");
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    CHECK(fakePins[pins[i]].isr == edgeIsr && fakePins[pins[i]].mode == CHANGE,
+          "pin %u not attached as CHANGE", pins[i]);
+  }
+}
+
+static void testFifo() {
+  printf("isr -> ring (fifo, time, level, notify)\n");
+  int n0 = fakeNotifies;
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    fakeNowUs = 1000 + (int64_t)i * 10;
+    fakeSetPin(pins[i], 1);
+  }
+  fakeNowUs = 5000;
+  fakeSetPin(pins[0], 0);
+  CHECK(fakeNotifies - n0 == (int)Panel::kEdgePinCount + 1, "notify count %d", fakeNotifies - n0);
+  CHECK(fakeYields > 0, "no portYIELD_FROM_ISR");
+
+  EdgeEvent e;
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    bool ok = edgePop(e);
+    CHECK(ok && e.pin == pins[i] && e.level == 1 && e.tUs == 1000 + (int64_t)i * 10,
+          "event %zu: pin=%u level=%u t=%lld", i, e.pin, e.level, (long long)e.tUs);
+  }
+  CHECK(edgePop(e) && e.pin == pins[0] && e.level == 0 && e.tUs == 5000, "falling edge");
+  CHECK(!edgePop(e), "ring not empty");
+  CHECK(!edgeTakeOverflow(), "unexpected overflow");
+}
+
+static void testOverflow() {
+  printf("overflow (%d slots)\n", EDGE_QUEUE_LEN);
+  const uint8_t p = pins[0];
+  for (int i = 0; i < EDGE_QUEUE_LEN + 10; i++) {
+    fakeNowUs = 10000 + i;
+    fakeSetPin(p, (fakeGpioIn >> p) & 1 ? 0 : 1);
+  }
+  CHECK(edgeHead - edgeTail == EDGE_QUEUE_LEN, "queued %u", edgeHead - edgeTail);
+
+  EdgeEvent e;
+  bool order = true;
+  for (int i = 0; i < EDGE_QUEUE_LEN; i++) {
+    if (!edgePop(e) || e.tUs != 10000 + i) order = false;
+  }
+  CHECK(order, "kept events are not the oldest %d in order", EDGE_QUEUE_LEN);
+  CHECK(!edgePop(e), "more than %d events kept", EDGE_QUEUE_LEN);
+  CHECK(edgeTakeOverflow(), "overflow flag not set");
+  CHECK(!edgeTakeOverflow(), "overflow flag reported twice");
+
+  fakeNowUs = 20000;
+  fakeSetPin(p, (fakeGpioIn >> p) & 1 ? 0 : 1);
+  CHECK(edgePop(e) && e.tUs == 20000, "ring unusable after overflow");
+  CHECK(!edgeTakeOverflow(), "overflow after recovery");
+}
+
+static void testWrap() {
+  printf("head/tail wrap-around\n");
+  edgeHead = edgeTail = 0xFFFFFFF0u;
+  const uint8_t p = pins[1];
+  for (int i = 0; i < 32; i++) {
+    fakeNowUs = 30000 + i;
+    fakeSetPin(p, (fakeGpioIn >> p) & 1 ? 0 : 1);
+    if (i % 3 == 2) {             // ดึงบ้างระหว่างทาง (loop ช้ากว่า ISR)
+      EdgeEvent e;
+      edgePop(e);
+    }
+  }
+  EdgeEvent e;
+  int64_t last = 0;
+  bool order = true;
+  size_t n = 0;
+  while (edgePop(e)) {
+    if (e.tUs <= last) order = false;
+    last = e.tUs;
+    n++;
+  }
+  CHECK(order && last == 30031, "order broken across wrap (last=%lld)", (long long)last);
+  CHECK(n == 32 - 32 / 3, "popped %zu after wrap", n);
+  CHECK(!edgeTakeOverflow(), "false overflow at wrap");
+}
+
+static void testWait() {
+  printf("edgeWait\n");
+  int c0 = fakeTakeCalls;
+  edgeInject(pins[0], 1, 40000);
+  edgeWait(250);
+  CHECK(fakeTakeCalls == c0, "blocked with a pending event");
+  drain();
+  edgeWait(250);
+  CHECK(fakeTakeCalls == c0 + 1 && fakeTakeTicks == pdMS_TO_TICKS(250), "did not block for 250ms");
+}
+
+static void testSleepArmBusy() {
+  printf("edgeSleepArm with pending edge\n");
+  uint8_t levels[Panel::kEdgePinCount];
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) levels[i] = (uint8_t)((fakeGpioIn >> pins[i]) & 1);
+  edgeInject(pins[2], 1, 50000);
+  CHECK(!edgeSleepArm(pins, levels, Panel::kEdgePinCount), "armed with a pending edge");
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    CHECK(fakePins[pins[i]].intrEnabled && fakePins[pins[i]].wakeType == 0,
+          "pin %u left disarmed/wake-enabled", pins[i]);
+  }
+  drain();
+}
+
+static void testSleepCycle() {
+  printf("edgeSleepArm / edgeSleepDisarm\n");
+  // ระดับที่ state machine รู้ = ระดับขาตอนนี้
+  uint8_t levels[Panel::kEdgePinCount];
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) levels[i] = (uint8_t)((fakeGpioIn >> pins[i]) & 1);
+
+  CHECK(edgeSleepArm(pins, levels, Panel::kEdgePinCount), "arm failed on empty ring");
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    const FakePin &fp = fakePins[pins[i]];
+    int want = levels[i] ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+    CHECK(!fp.intrEnabled, "pin %u interrupt still on while asleep", pins[i]);
+    CHECK(fp.wakeType == want, "pin %u wake type %d, want %d", pins[i], fp.wakeType, want);
+  }
+
+  // ระหว่างหลับ: ขา 1 และขาสุดท้าย (ขา >= 32) เปลี่ยน, ขา 2 เปลี่ยนแล้วกลับ (ไม่ควรเห็น)
+  const size_t last = Panel::kEdgePinCount - 1;
+  fakeSetPin(pins[1], !levels[1]);
+  fakeSetPin(pins[last], !levels[last]);
+  fakeSetPin(pins[2], !levels[2]);
+  fakeSetPin(pins[2], levels[2]);
+  CHECK(edgeHead == edgeTail, "ISR fired while asleep");
+
+  const int64_t wakeUs = 60000;
+  edgeSleepDisarm(pins, levels, Panel::kEdgePinCount, wakeUs);
+
+  EdgeEvent e;
+  CHECK(edgePop(e) && e.pin == pins[1] && e.level == !levels[1] && e.tUs == wakeUs,
+        "synthetic edge 1: pin=%u level=%u t=%lld", e.pin, e.level, (long long)e.tUs);
+  CHECK(edgePop(e) && e.pin == pins[last] && e.level == !levels[last] && e.tUs == wakeUs,
+        "synthetic edge 2: pin=%u level=%u t=%lld", e.pin, e.level, (long long)e.tUs);
+  CHECK(!edgePop(e), "extra synthetic edge for pin %u", e.pin);
+
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) {
+    const FakePin &fp = fakePins[pins[i]];
+    CHECK(fp.intrEnabled && fp.intrType == GPIO_INTR_ANYEDGE && fp.wakeType == 0,
+          "pin %u not restored to ANYEDGE", pins[i]);
+  }
+
+  // edge จริงหลังตื่นต้องเข้าคิวด้วยเวลาใหม่กว่า wakeUs
+  fakeNowUs = wakeUs + 5;
+  fakeSetPin(pins[1], levels[1]);
+  CHECK(edgePop(e) && e.pin == pins[1] && e.tUs > wakeUs, "edge after wake lost");
+}
+
+static void testDisarmOverflow() {
+  printf("edgeSleepDisarm into a full ring\n");
+  uint8_t levels[Panel::kEdgePinCount];
+  for (size_t i = 0; i < Panel::kEdgePinCount; i++) levels[i] = (uint8_t)((fakeGpioIn >> pins[i]) & 1);
+  CHECK(edgeSleepArm(pins, levels, Panel::kEdgePinCount), "arm failed");
+  for (int i = 0; i < EDGE_QUEUE_LEN; i++) edgeInject(pins[0], 1, 70000 + i);   // ring เต็มพอดี
+  fakeSetPin(pins[3], !levels[3]);
+  edgeSleepDisarm(pins, levels, Panel::kEdgePinCount, 80000);
+  CHECK(edgeTakeOverflow(), "lost synthetic edge without overflow flag");
+  CHECK(drain() == EDGE_QUEUE_LEN, "ring size changed");
+}
+
+int main() {
+  Panel::edgePins(pins);
+  fakeGpioIn = 0;
+
+  testBegin();
+  testFifo();
+  testOverflow();
+  testWrap();
+  testWait();
+  testSleepArmBusy();
+  testSleepCycle();
+  testDisarmOverflow();
+
+  CHECK(fakeCriticalErrors == 0 && edgeMux.held == 0, "critical section nested/unbalanced (%d)", fakeCriticalErrors);
+
+  printf("\n%s: %d/%d checks passed\n", failures ? "FAIL" : "PASS", checks - failures, checks);
+  return failures ? 1 : 0;
+}
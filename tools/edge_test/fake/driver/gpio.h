@@ -0,0 +1,2 @@
+/* ของปลอมสำหรับ tools/edge_test (ดู fake_idf.h) */
+#include "../fake_idf.h"
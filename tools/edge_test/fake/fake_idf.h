@@ -0,0 +1,107 @@
+#ifndef FAKE_IDF_H
+#define FAKE_IDF_H
+
+/* =========================================================
+ * ของปลอม Arduino/ESP-IDF ขั้นต่ำ ให้ edge_capture.h คอมไพล์บน PC ได้โดยไม่แก้ไฟล์
+ *
+ * - ระดับขา GPIO = fakeGpioIn (bit ละขา) อ่านผ่าน REG_READ(GPIO_IN_REG / GPIO_IN1_REG)
+ * - esp_timer_get_time() = fakeNowUs (เทสต์เลื่อนเวลาเอง)
+ * - critical section / task notify / gpio_* แค่บันทึกการเรียกไว้ให้เทสต์ตรวจ
+ * ใช้กับ tools/edge_test เท่านั้น (เธรดเดียว: ISR ถูกเรียกตรง ๆ จากเทสต์)
+ * ========================================================= */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define IRAM_ATTR
+#define CHANGE 3
+
+/* ===== GPIO input register ===== */
+#define GPIO_IN_REG  0
+#define GPIO_IN1_REG 1
+static uint64_t fakeGpioIn = 0;
+#define REG_READ(r) ((uint32_t)((r) == GPIO_IN_REG ? fakeGpioIn : (fakeGpioIn >> 32)))
+
+/* ===== esp_timer ===== */
+static int64_t fakeNowUs = 0;
+static inline int64_t esp_timer_get_time() { return fakeNowUs; }
+
+/* ===== critical section (ตรวจว่าไม่ซ้อน/ไม่ค้าง) ===== */
+typedef struct { int held; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+static int fakeCriticalErrors = 0;
+static inline void fakeEnter(portMUX_TYPE *m) { if (m->held++) fakeCriticalErrors++; }
+static inline void fakeExit(portMUX_TYPE *m)  { if (--m->held) fakeCriticalErrors++; }
+#define portENTER_CRITICAL(m)     fakeEnter(m)
+#define portEXIT_CRITICAL(m)      fakeExit(m)
+#define portENTER_CRITICAL_ISR(m) fakeEnter(m)
+#define portEXIT_CRITICAL_ISR(m)  fakeExit(m)
+
+/* ===== FreeRTOS task notify ===== */
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+static int fakeLoopTask = 0;
+static int fakeNotifies = 0;
+static int fakeYields = 0;
+static int fakeTakeCalls = 0;
+static TickType_t fakeTakeTicks = 0;
+static inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &fakeLoopTask; }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *woken) {
+  fakeNotifies++;
+  *woken = pdTRUE;
+}
+#define portYIELD_FROM_ISR() (fakeYields++)
+static inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks) {
+  fakeTakeCalls++;
+  fakeTakeTicks = ticks;
+  return 0;
+}
+
+/* ===== GPIO interrupt / wakeup ===== */
+typedef int gpio_num_t;
+typedef enum {
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+#define FAKE_GPIO_COUNT 40
+struct FakePin {
+  void (*isr)(void *);
+  void *arg;
+  int  mode;          // attachInterruptArg
+  bool intrEnabled;
+  int  intrType;      // gpio_set_intr_type
+  int  wakeType;      // gpio_wakeup_enable (0 = ปิด)
+};
+static FakePin fakePins[FAKE_GPIO_COUNT];
+
+static inline void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode) {
+  fakePins[pin].isr = isr;
+  fakePins[pin].arg = arg;
+  fakePins[pin].mode = mode;
+  fakePins[pin].intrEnabled = true;
+  fakePins[pin].intrType = GPIO_INTR_ANYEDGE;
+}
+static inline int gpio_intr_disable(gpio_num_t p) { fakePins[p].intrEnabled = false; return 0; }
+static inline int gpio_intr_enable(gpio_num_t p)  { fakePins[p].intrEnabled = true; return 0; }
+static inline int gpio_set_intr_type(gpio_num_t p, gpio_int_type_t t) { fakePins[p].intrType = t; return 0; }
+static inline int gpio_wakeup_enable(gpio_num_t p, gpio_int_type_t t) { fakePins[p].wakeType = t; return 0; }
+static inline int gpio_wakeup_disable(gpio_num_t p) { fakePins[p].wakeType = 0; return 0; }
+
+/* ตั้งระดับขา แล้วเรียก ISR ถ้า interrupt ของขานั้นเปิดอยู่ (เหมือนฮาร์ดแวร์) */
+static inline void fakeSetPin(uint8_t pin, int level) {
+  uint64_t bit = 1ULL << pin;
+  bool changed = ((fakeGpioIn & bit) != 0) != (level != 0);
+  fakeGpioIn = level ? (fakeGpioIn | bit) : (fakeGpioIn & ~bit);
+  if (changed && fakePins[pin].isr && fakePins[pin].intrEnabled) fakePins[pin].isr(fakePins[pin].arg);
+}
+
+#endif
@@ -0,0 +1,733 @@
+/* =========================================================
+ * fleet_loadgen: ยิงโหลด /api/restroom/status และ /status/batch จากแผงเสมือนหลายร้อย-หลายพันตัว
+ *
+ * แต่ละแผงเสมือนใช้ลอจิกชุดเดียวกับบอร์ดจริง:
+ *   - RoomController<ROOM_COUNT, PanelPins>  (room_controller.h / panel_config.h)
+ *     ป้อน edge PIR/ประตูจากคนเข้าห้องแบบสุ่ม (visit_gen.h ชุดเดียวกับ room_sim: กลางวันถี่ กลางคืนห่าง)
+ *   - lightSleepAllowed() / schedDueIn() / heartbeatSendsStatus() (panel_policy.h):
+ *     ว่างนาน -> หลับ, ตื่นด้วย timer 5 นาทีแล้วส่ง heartbeat, ตอน active heartbeat ทุก HEARTBEAT_MS
+ *   - status_sync.h: snapshot, payload สถานะ/batch, กติกา ack/STATUS_FULL_EVERY/need_full
+ *     ชุดเดียวกับ send_to_backend.h (payload เต็มแนบบล็อก "perf" ของแผงนั้นเอง)
+ * ทุกเหตุการณ์ (เริ่ม/จบ session, รีเซ็ต) ถูกจดลง journal ของแผงแล้วส่งแบบ batch เหมือน netDrain():
+ *   มี event ค้าง -> POST <url>/batch ทีละ JOURNAL_BATCH_MAX (ส่งไม่ผ่าน = เก็บไว้รอบหน้า)
+ *   แล้วส่งสถานะเต็มตามถ้า backend ตอบ need_full, ไม่มี event ค้าง -> POST สถานะเดี่ยว
+ * DEVICE_ID ไม่ซ้ำกัน (--prefix + เลขลำดับ)
+ *
+ * ส่ง POST จริงด้วย socket POSIX (HTTP/1.1 keep-alive, 1 socket ต่อ worker thread)
+ * แผงถูกแบ่งให้ worker แต่ละตัว; worker เดินนาฬิกาเสมือน (--speed เท่าของเวลาจริง)
+ * รายงาน: throughput, latency p50/p99/p999/max, code ตอบกลับ, สัดส่วน full/delta/need_full,
+ * จำนวน batch/event และ event ที่ยังค้าง
+ * และความล่าช้าของตัวยิงเอง (ถ้าสูง = ตัวยิงไม่ทัน ต้องเพิ่ม --threads)
+ * latency นับจากเวลาที่แผงควรส่ง (ตามตารางเวลาเสมือน) ถึงตอนได้คำตอบ -> รวมเวลาที่ต่อคิวรอ worker
+ * ตอน backend ช้า (ไม่ตกหลุม coordinated omission); เวลา POST ล้วนรายงานแยกเป็น service
+ * หยุดเมื่อครบ --duration ตามเวลาจริงเสมอ งานที่ถึงกำหนดแล้วแต่ยังไม่ได้ทำนับเป็น unsent
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -pthread -Iesp32_firmware -Itools/common tools/fleet_loadgen/fleet_loadgen.cpp -o fleet_loadgen
+ *
+ * ใช้งาน:
+ *   ./fleet_loadgen --url http://127.0.0.1:8000/api/restroom/status --devices 1000 --duration 60
+ *   ./fleet_loadgen --devices 500 --speed 20 --threads 32   # เร่งเวลา 20 เท่า (~โหลดของ 10,000 แผง)
+ *   ตัวเลือกอื่น: --rate คน/ชม./ห้อง (กลางวัน), --start-hour, --seed, --prefix, --no-keepalive
+ * ========================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int64_t wallUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define PERF_NOW_US() wallUs()
+#include "panel_config.h"
+#include "panel_policy.h"
+#include "status_sync.h"   // snapshot + payload สถานะ/batch + กติกา ack (ชุดเดียวกับ send_to_backend.h)
+#include "visit_gen.h"     // คนเข้าห้องสังเคราะห์ (ชุดเดียวกับ room_sim)
+
+#define HTTP_TIMEOUT_MS     5000                    // เท่ากับ http_conn.h
+#define LOADGEN_BOOT_ID     1                       // แผงเสมือนบูตครั้งเดียว
+#define LOADGEN_JOURNAL_MAX (JOURNAL_RTC_LEN + JOURNAL_SPILL_MAX)   // ความจุ journal บนบอร์ด (RTC + NVS)
+
+struct Options {
+  std::string url      = "http://127.0.0.1:8000/api/restroom/status";
+  std::string prefix   = "fleet-";
+  int      devices     = 100;
+  int      threads     = 8;
+  double   durationS   = 60.0;
+  double   speed       = 1.0;
+  double   rate        = 4.0;     // คน/ชม./ห้อง ช่วงกลางวัน
+  double   startHour   = 9.0;
+  uint32_t seed        = 1;
+  bool     keepAlive   = true;
+};
+
+/* =========================================================
+ * HTTP/1.1 POST แบบ raw socket (เฉพาะ http://)
+ * ========================================================= */
+struct HttpTarget {
+  std::string host;
+  std::string port = "80";
+  std::string path = "/";
+  struct addrinfo *addr = nullptr;
+};
+
+static bool parseUrl(const std::string &url, HttpTarget &t) {
+  const std::string scheme = "http://";
+  if (url.compare(0, scheme.size(), scheme) != 0) return false;
+  std::string rest = url.substr(scheme.size());
+  size_t slash = rest.find('/');
+  std::string hostPort = rest.substr(0, slash);
+  if (slash != std::string::npos) t.path = rest.substr(slash);
+  size_t colon = hostPort.rfind(':');
+  t.host = hostPort.substr(0, colon);
+  if (colon != std::string::npos) t.port = hostPort.substr(colon + 1);
+  if (t.host.empty()) return false;
+
+  struct addrinfo hints = {};
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  return getaddrinfo(t.host.c_str(), t.port.c_str(), &hints, &t.addr) == 0;
+}
+
+struct HttpConn {
+  int fd = -1;
+  uint32_t opens = 0;
+  void close() { if (fd >= 0) ::close(fd); fd = -1; }
+};
+
+static bool httpConnect(HttpConn &c, const HttpTarget &t) {
+  for (struct addrinfo *a = t.addr; a; a = a->ai_next) {
+    int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) continue;
+    struct timeval tv = {HTTP_TIMEOUT_MS / 1000, (HTTP_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+      c.fd = fd;
+      c.opens++;
+      return true;
+    }
+    ::close(fd);
+  }
+  return false;
+}
+
+static bool sendAll(int fd, const char *p, size_t n) {
+  while (n > 0) {
+    ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+    if (w <= 0) { if (w < 0 && errno == EINTR) continue; return false; }
+    p += w;
+    n -= (size_t)w;
+  }
+  return true;
+}
+
+static std::string headerValue(const std::string &head, const char *name) {
+  size_t n = strlen(name);
+  size_t pos = 0;
+  while ((pos = head.find("\r\n", pos)) != std::string::npos) {
+    pos += 2;
+    if (head.size() - pos > n && strncasecmp(head.c_str() + pos, name, n) == 0 && head[pos + n] == ':') {
+      size_t v = pos + n + 1;
+      while (v < head.size() && head[v] == ' ') v++;
+      size_t e = head.find("\r\n", v);
+      return head.substr(v, e == std::string::npos ? std::string::npos : e - v);
+    }
+  }
+  return std::string();
+}
+
+/* อ่าน response 1 ตัว (Content-Length หรือ chunked) คืน code, -1 = socket เสีย/timeout */
+static int httpReadResponse(HttpConn &c, std::string &body, bool &mustClose) {
+  std::string in;
+  char buf[4096];
+  size_t headEnd;
+  while ((headEnd = in.find("\r\n\r\n")) == std::string::npos) {
+    ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+    if (r <= 0) return -1;
+    in.append(buf, (size_t)r);
+  }
+  std::string head = in.substr(0, headEnd);
+  int code = 0;
+  if (sscanf(head.c_str(), "HTTP/1.%*d %d", &code) != 1) return -1;
+  std::string rest = in.substr(headEnd + 4);
+
+  std::string conn = headerValue(head, "Connection");
+  mustClose = strncasecmp(conn.c_str(), "close", 5) == 0;
+
+  if (strncasecmp(headerValue(head, "Transfer-Encoding").c_str(), "chunked", 7) == 0) {
+    body.clear();
+    for (;;) {
+      size_t eol;
+      while ((eol = rest.find("\r\n")) == std::string::npos) {
+        ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+        if (r <= 0) return -1;
+        rest.append(buf, (size_t)r);
+      }
+      size_t size = strtoul(rest.c_str(), nullptr, 16);
+      while (rest.size() < eol + 2 + size + 2) {
+        ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+        if (r <= 0) return -1;
+        rest.append(buf, (size_t)r);
+      }
+      body.append(rest, eol + 2, size);
+      rest.erase(0, eol + 2 + size + 2);
+      if (size == 0) break;           // (ไม่รองรับ trailer header)
+    }
+    return code;
+  }
+
+  std::string lenStr = headerValue(head, "Content-Length");
+  if (lenStr.empty()) {               // ไม่บอกความยาว -> อ่านจนปิด
+    mustClose = true;
+    for (;;) {
+      ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+      if (r <= 0) break;
+      rest.append(buf, (size_t)r);
+    }
+    body.swap(rest);
+    return code;
+  }
+  size_t len = strtoul(lenStr.c_str(), nullptr, 10);
+  while (rest.size() < len) {
+    ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+    if (r <= 0) return -1;
+    rest.append(buf, (size_t)r);
+  }
+  body = rest.substr(0, len);
+  return code;
+}
+
+/* POST แบบเดียวกับ httpPost() บนบอร์ด: socket ที่ใช้ซ้ำแล้วตาย -> ต่อใหม่แล้วลองอีก 1 ครั้ง */
+static int httpPost(HttpConn &c, const HttpTarget &t, const std::string &path, bool keepAlive,
+                    const char *body, size_t len, std::string &resp) {
+  // head + body ในบัฟเฟอร์เดียว -> ส่งเป็น segment เดียว (ไม่ติด Nagle/delayed ACK ฝั่ง server)
+  char req[512 + BATCH_JSON_BUF];
+  int hn = snprintf(req, sizeof(req),
+                    "POST %s HTTP/1.1\r\nHost: %s:%s\r\nContent-Type: application/json\r\n"
+                    "Content-Length: %zu\r\nConnection: %s\r\n\r\n",
+                    path.c_str(), t.host.c_str(), t.port.c_str(), len,
+                    keepAlive ? "keep-alive" : "close");
+  if (hn < 0 || (size_t)hn + len > sizeof(req)) return -1;
+  memcpy(req + hn, body, len);
+
+  resp.clear();
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = c.fd >= 0;
+    if (!reused && !httpConnect(c, t)) return -1;
+
+    bool mustClose = false;
+    int code = -1;
+    if (sendAll(c.fd, req, (size_t)hn + len)) {
+      code = httpReadResponse(c, resp, mustClose);
+    }
+    if (code > 0) {
+      if (mustClose || !keepAlive) c.close();
+      return code;
+    }
+    c.close();
+    if (!reused) return -1;
+  }
+  return -1;
+}
+
+/* =========================================================
+ * แผงเสมือน 1 ตัว
+ * ========================================================= */
+/* ผลข้างเคียงของ state machine เหมือน PanelSink: จดลง journal + ขอส่งสถานะ */
+struct LoadSink {
+  std::deque<JournalEvent> journal;     // event ที่ยังไม่ได้ ok จาก backend
+  uint32_t nextSeq       = 0;
+  uint64_t dropped       = 0;           // journal เต็ม (backend ล่มนาน) -> ทิ้งก้อนเก่าสุดเหมือน NVS
+  bool     statusPending = false;
+  bool     becameDirty   = false;
+
+  void append(uint8_t kind, uint8_t room, uint32_t tsMs, uint32_t durMs) {
+    if (journal.size() >= LOADGEN_JOURNAL_MAX) {
+      journal.erase(journal.begin(), journal.begin() + JOURNAL_SPILL_CHUNK);
+      dropped += JOURNAL_SPILL_CHUNK;
+    }
+    journal.push_back({nextSeq++, tsMs, durMs, room, kind, LOADGEN_BOOT_ID});
+  }
+  void onSessionStart(size_t i, int64_t tUs) {
+    append(JEV_START, (uint8_t)i, (uint32_t)(tUs / 1000), 0);
+    statusPending = true;
+  }
+  void onSessionEnd(size_t i, int64_t endUs, uint32_t durMs, bool, bool dirty) {
+    append(JEV_END, (uint8_t)i, (uint32_t)(endUs / 1000), durMs);
+    statusPending = true;
+    if (dirty) becameDirty = true;
+  }
+};
+
+struct VirtualDevice {
+  char     id[32];
+  Panel    panel;
+  LoadSink sink;
+  std::mt19937_64 rng;
+  std::priority_queue<PinEdge, std::vector<PinEdge>, EdgeLater> edges;
+  int64_t  nextVisitGenUs[ROOM_COUNT];   // เวลาที่ต้องสุ่มคนถัดไปของห้องนั้น
+
+  bool     cleaningRequired = false;
+  uint32_t lastCleanMs      = 0;
+  int64_t  cleanerAtUs      = INT64_MAX;
+
+  int64_t  stepUs     = 0;               // เวลาเสมือนของรอบล่าสุด
+  uint32_t lastBeatMs = 0;               // เหมือน lastBeat ใน loop()
+  bool     asleep     = false;
+  int64_t  sleepFromUs = 0;
+  int64_t  wakeAtUs   = 0;               // timer ปลุก (LIGHT_SLEEP_INTERVAL_US)
+  int64_t  lastWakeUs = 0;
+  SleepStats sleep    = {};
+
+  StatusAck ack  = {};
+  PerfState perf = {};                   // บล็อก "perf" ของแผงนี้ (PERF_HTTP = latency ที่วัดได้จริง)
+
+  VirtualDevice() : panel({HOLD_ON_MS, USES_THRESHOLD_PER_ROOM,
+                           TOTAL_MS_THRESHOLD_PER_ROOM, DOOR_DEBOUNCE_MS}) {}
+};
+
+/* สุ่มคนถัดไปของห้อง i หลังเวลา afterUs (visit_gen.h) แล้วใส่ edge เข้าคิวของแผง */
+static void generateVisit(VirtualDevice &d, size_t i, int64_t afterUs, const VisitParams &vp) {
+  Visit v = visitDraw(d.rng, i, afterUs, vp);
+  d.nextVisitGenUs[i] = visitEmit<PanelPins>(d.rng, v, [&](const PinEdge &e) { d.edges.push(e); });
+}
+
+/* เวลาเสมือนถัดไปที่แผงนี้มีงาน */
+static int64_t deviceNextUs(const VirtualDevice &d) {
+  int64_t t = d.asleep ? d.wakeAtUs
+                       : d.stepUs + (int64_t)schedDueIn((uint32_t)(d.stepUs / 1000), d.lastBeatMs,
+                                                        HEARTBEAT_MS) * 1000;
+  if (!d.edges.empty())             t = std::min(t, d.edges.top().tUs);
+  for (size_t i = 0; i < ROOM_COUNT; i++) t = std::min(t, d.nextVisitGenUs[i]);
+  t = std::min(t, d.panel.nextDeadlineUs());
+  t = std::min(t, d.cleanerAtUs);
+  return t;
+}
+
+static void deviceWake(VirtualDevice &d, int64_t nowUs, bool byGpio) {
+  sleepStatsAdd(d.sleep, (uint64_t)(nowUs - d.sleepFromUs), byGpio, SCHED_HEARTBEAT);
+  d.asleep     = false;
+  d.lastWakeUs = nowUs;
+}
+
+/*
+ * เดินแผงถึงเวลา nowUs (ลำดับเดียวกับ loop()) คืน true ถ้าต้องส่งสถานะ
+ */
+static bool deviceStep(VirtualDevice &d, int64_t nowUs, const Options &o, double clockOffsetS) {
+  d.stepUs = nowUs;
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    if (d.nextVisitGenUs[i] <= nowUs) generateVisit(d, i, d.nextVisitGenUs[i], {o.rate, clockOffsetS});
+  }
+
+  // edge ที่ถึงเวลา (PIR ขึ้นตอนหลับ = ปลุกด้วย EXT1)
+  while (!d.edges.empty() && d.edges.top().tUs <= nowUs) {
+    PinEdge e = d.edges.top();
+    d.edges.pop();
+    if (d.asleep && e.level && Panel::roomOfPir(e.pin) >= 0) deviceWake(d, e.tUs, true);
+    d.panel.applyEdge(e.pin, e.level != 0, e.tUs, d.sink);
+  }
+  d.panel.tick(nowUs, d.sink);
+
+  d.cleaningRequired = d.panel.anyNeedCleaning();
+  if (d.sink.becameDirty) {
+    d.sink.becameDirty = false;
+    if (d.cleanerAtUs == INT64_MAX) d.cleanerAtUs = nowUs + CLEANER_DELAY_US;
+  }
+
+  // แม่บ้านกดรีเซ็ต (doResetCounters)
+  uint32_t nowMs = (uint32_t)(nowUs / 1000);
+  if (d.cleanerAtUs <= nowUs) {
+    d.cleanerAtUs = INT64_MAX;
+    d.panel.resetCounters();
+    d.lastCleanMs = nowMs;
+    d.sink.append(JEV_RESET, JOURNAL_ALL_ROOMS, d.lastCleanMs, 0);
+    d.cleaningRequired = false;
+    d.sink.statusPending = true;
+  }
+
+  if (d.asleep) {
+    if (nowUs >= d.wakeAtUs) {            // timer ปลุก -> heartbeat (heartbeatOnWake)
+      deviceWake(d, nowUs, false);
+      d.sink.statusPending = true;
+    }
+  } else if (schedDueIn(nowMs, d.lastBeatMs, HEARTBEAT_MS) == 0) {
+    d.lastBeatMs = nowMs;
+    uint32_t lastMotionMs = (uint32_t)(d.panel.lastAnyMotionUs() / 1000);
+    if (heartbeatSendsStatus(nowMs, lastMotionMs, d.cleaningRequired, SLEEP_IDLE_MS))
+      d.sink.statusPending = true;
+  }
+
+  bool send = d.sink.statusPending;
+  d.sink.statusPending = false;
+
+  // หลับยาวเมื่อว่างนาน (หลังส่งเสร็จ)
+  if (!d.asleep) {
+    SleepGateInputs in;
+    in.nowMs            = nowMs;
+    in.lastWakeMs       = (uint32_t)(d.lastWakeUs / 1000);
+    in.lastMotionMs     = (uint32_t)(d.panel.lastAnyMotionUs() / 1000);
+    in.anyOccupied      = d.panel.anyOccupied();
+    in.cleaningRequired = d.cleaningRequired;
+    in.netBusy          = false;
+    in.anyDoorClosed    = d.panel.anyDoorClosed();
+    if (lightSleepAllowed(in, AWAKE_HOLDOFF_MS, SLEEP_IDLE_MS)) {
+      d.asleep      = true;
+      d.sleepFromUs = nowUs;
+      d.wakeAtUs    = nowUs + (int64_t)LIGHT_SLEEP_INTERVAL_US;
+    }
+  }
+  return send;
+}
+
+/* =========================================================
+ * สถิติ
+ * ========================================================= */
+struct WorkerStats {
+  std::vector<uint32_t> latUs;      // ตั้งแต่กำหนดส่งถึงได้คำตอบ (รวมเวลาต่อคิว)
+  std::vector<uint32_t> svcUs;      // เวลา POST ล้วน
+  uint64_t requests = 0, ok2xx = 0, http4xx = 0, http5xx = 0, transport = 0;
+  uint64_t full = 0, delta = 0, needFull = 0, bytes = 0;
+  uint64_t batches = 0, events = 0;   // POST /batch และ event ที่ backend รับแล้ว
+  uint64_t lateSends = 0;          // ส่งช้ากว่ากำหนด > 100ms (ตัวยิงไม่ทัน)
+  int64_t  maxLagUs = 0;
+  uint64_t unsent = 0;             // รอบตื่นที่ถึงกำหนดก่อนหมดเวลาแต่ไม่ได้ทำ
+  int64_t  behindUs = 0;           // ตอนหยุด เวลาเสมือนของ worker ตามหลังกำหนดเท่าไร (มากสุด)
+  uint32_t connOpens = 0;
+};
+
+static std::atomic<uint64_t> liveRequests{0};
+
+/* =========================================================
+ * ส่งสถานะของแผง (ลำดับเดียวกับ netDrain() / sendStatusImmediately() / sendJournalBatch())
+ * ========================================================= */
+struct WorkerNet {
+  HttpConn           conn;
+  const HttpTarget  *target;
+  std::string        batchPath;      // เหมือน API_BATCH_URL = API_URL "/batch"
+  bool               keepAlive;
+  char               buf[BATCH_JSON_BUF];
+  std::string        resp;
+  WorkerStats       *st;
+  int64_t            dueWallUs;      // เวลาจริงที่รอบนี้ควรส่ง (ฐานของ latency)
+};
+
+/* JsonExtraWriter เป็น function pointer -> ชี้ PerfState ของแผงที่กำลังส่งผ่านตัวแปรของ thread */
+static thread_local const PerfState *currentPerf = nullptr;
+
+static void devicePerfJson(JsonOut &out) {
+  perfWriteStateJson(out, *currentPerf);
+}
+
+/* เหมือน perfSnapshotCounters() บนบอร์ด (เฉพาะตัวนับที่แผงเสมือนมี) */
+static void devicePerfCounters(VirtualDevice &d, int64_t nowUs) {
+  d.perf.counters.awakePermille = sleepStatsAwakePermille(d.sleep, (uint64_t)nowUs);
+  d.perf.counters.sleeps        = d.sleep.sleeps;
+}
+
+static int devicePost(WorkerNet &net, VirtualDevice &d, const std::string &path, size_t len) {
+  int64_t t0 = wallUs();
+  int code = httpPost(net.conn, *net.target, path, net.keepAlive, net.buf, len, net.resp);
+  int64_t dt = wallUs() - t0;
+  perfRecordIn(d.perf, PERF_HTTP, (uint32_t)std::min<int64_t>(dt, UINT32_MAX));
+
+  WorkerStats *st = net.st;
+  st->requests++;
+  st->bytes += len;
+  liveRequests.fetch_add(1, std::memory_order_relaxed);
+
+  if (code <= 0)      st->transport++;
+  else if (code >= 500) st->http5xx++;
+  else if (code >= 400) st->http4xx++;
+  else if (code >= 200 && code < 300) st->ok2xx++;
+  if (code > 0) {
+    st->latUs.push_back((uint32_t)std::min<int64_t>(t0 + dt - net.dueWallUs, UINT32_MAX));
+    st->svcUs.push_back((uint32_t)std::min<int64_t>(dt, UINT32_MAX));
+  }
+  return code;
+}
+
+static void deviceSendStatus(WorkerNet &net, VirtualDevice &d, uint32_t nowMs) {
+  RoomReport snap[ROOM_COUNT];
+  statusSnapshot(d.panel, d.cleaningRequired, snap);
+  bool delta = statusUseDelta(d.ack);
+
+  currentPerf = &d.perf;
+  JsonOut out(net.buf, sizeof(net.buf));
+  if (!writeStatusDoc(out, statusDoc(d.id, d.lastCleanMs, d.cleaningRequired, snap, d.ack, delta,
+                                     nowMs, devicePerfJson))) return;
+
+  int code = devicePost(net, d, net.target->path, out.len);
+  (delta ? net.st->delta : net.st->full)++;
+  if (!statusAfterPost(d.ack, snap, delta, code, net.resp.c_str()) && code > 0 &&
+      statusRespNeedFull(net.resp.c_str())) net.st->needFull++;
+}
+
+/* คืน true ถ้า backend รับ event ชุดนี้แล้ว (ลบออกจาก journal) */
+static bool deviceSendBatch(WorkerNet &net, VirtualDevice &d, uint32_t nowMs) {
+  JournalEvent batch[JOURNAL_BATCH_MAX];
+  uint16_t n = (uint16_t)std::min<size_t>(d.sink.journal.size(), JOURNAL_BATCH_MAX);
+  std::copy_n(d.sink.journal.begin(), n, batch);
+
+  RoomReport snap[ROOM_COUNT];
+  statusSnapshot(d.panel, d.cleaningRequired, snap);
+  bool delta = statusUseDelta(d.ack);
+
+  currentPerf = &d.perf;
+  JsonOut out(net.buf, sizeof(net.buf));
+  if (!writeBatchJson(out, statusDoc(d.id, d.lastCleanMs, d.cleaningRequired, snap, d.ack, delta,
+                                     nowMs, devicePerfJson), LOADGEN_BOOT_ID, batch, n)) return false;
+
+  int code = devicePost(net, d, net.batchPath, out.len);
+  net.st->batches++;
+  (delta ? net.st->delta : net.st->full)++;
+  if (!statusAfterBatch(d.ack, snap, delta, code, net.resp.c_str())) return false;
+
+  d.sink.journal.erase(d.sink.journal.begin(), d.sink.journal.begin() + n);
+  net.st->events += n;
+  if (!d.ack.have) net.st->needFull++;
+  return true;
+}
+
+static void deviceSend(WorkerNet &net, VirtualDevice &d, int64_t nowUs) {
+  uint32_t nowMs = (uint32_t)(nowUs / 1000);
+  devicePerfCounters(d, nowUs);
+  if (d.sink.journal.empty()) {
+    deviceSendStatus(net, d, nowMs);
+    return;
+  }
+  bool sent = false;
+  while (!d.sink.journal.empty()) {
+    if (!deviceSendBatch(net, d, nowMs)) break;
+    sent = true;
+  }
+  // backend ตอบ need_full กับ status ใน batch -> ส่งสถานะเต็มตามไป
+  if (sent && !d.ack.have) deviceSendStatus(net, d, nowMs);
+}
+
+struct HeapItem {
+  int64_t  atUs;
+  uint32_t dev;
+  bool operator>(const HeapItem &o) const { return atUs > o.atUs; }
+};
+
+static void workerMain(std::vector<VirtualDevice> *devices, std::vector<uint32_t> mine,
+                       const Options *o, const HttpTarget *target,
+                       int64_t wallStartUs, double clockOffsetS, WorkerStats *st) {
+  WorkerNet net;
+  net.target    = target;
+  net.batchPath = target->path + "/batch";
+  net.keepAlive = o->keepAlive;
+  net.st        = st;
+  const int64_t endVirtUs = (int64_t)(o->durationS * o->speed * 1e6);
+  const int64_t endWallUs = wallStartUs + (int64_t)(o->durationS * 1e6);
+
+  std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+  for (uint32_t id : mine) heap.push({deviceNextUs((*devices)[id]), id});
+
+  while (!heap.empty() && heap.top().atUs < endVirtUs) {
+    // หมดเวลาจริงแล้ว (backend/ตัวยิงช้ากว่ากำหนด) -> หยุด ไม่ยิงงานค้างต่อจนเลย --duration
+    if (wallUs() >= endWallUs) {
+      st->behindUs = endVirtUs - heap.top().atUs;
+      while (!heap.empty()) {
+        if (heap.top().atUs < endVirtUs) st->unsent++;
+        heap.pop();
+      }
+      break;
+    }
+    HeapItem it = heap.top();
+    heap.pop();
+
+    // รอถึงเวลาจริงที่ตรงกับเวลาเสมือนนี้
+    int64_t dueWall = wallStartUs + (int64_t)(it.atUs / o->speed);
+    int64_t lag = wallUs() - dueWall;
+    if (lag < 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(-lag));
+      lag = 0;
+    }
+
+    VirtualDevice &d = (*devices)[it.dev];
+    if (deviceStep(d, it.atUs, *o, clockOffsetS)) {
+      if (lag > st->maxLagUs) st->maxLagUs = lag;
+      if (lag > 100000) st->lateSends++;
+      net.dueWallUs = dueWall;
+      deviceSend(net, d, it.atUs);
+    }
+    heap.push({deviceNextUs(d), it.dev});
+  }
+  net.conn.close();
+  st->connOpens = net.conn.opens;
+}
+
+static double pct(const std::vector<uint32_t> &v, double p) {
+  if (v.empty()) return 0.0;
+  size_t k = (size_t)ceil(p * v.size());
+  if (k == 0) k = 1;
+  return v[std::min(k, v.size()) - 1] / 1000.0;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fleet_loadgen [--url http://host:port/path] [--devices N] [--threads T]\n"
+          "                     [--duration S] [--speed X] [--rate R] [--start-hour H]\n"
+          "                     [--seed S] [--prefix P] [--no-keepalive]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (!strcmp(a, "--no-keepalive")) { o.keepAlive = false; continue; }
+    if (i + 1 >= argc) usage();
+    const char *v = argv[++i];
+    if      (!strcmp(a, "--url"))        o.url = v;
+    else if (!strcmp(a, "--prefix"))     o.prefix = v;
+    else if (!strcmp(a, "--devices"))    o.devices = atoi(v);
+    else if (!strcmp(a, "--threads"))    o.threads = atoi(v);
+    else if (!strcmp(a, "--duration"))   o.durationS = atof(v);
+    else if (!strcmp(a, "--speed"))      o.speed = atof(v);
+    else if (!strcmp(a, "--rate"))       o.rate = atof(v);
+    else if (!strcmp(a, "--start-hour")) o.startHour = atof(v);
+    else if (!strcmp(a, "--seed"))       o.seed = (uint32_t)strtoul(v, nullptr, 10);
+    else usage();
+  }
+  if (o.devices <= 0 || o.threads <= 0 || o.durationS <= 0 || o.speed <= 0 || o.rate <= 0) usage();
+  if (o.threads > o.devices) o.threads = o.devices;
+
+  HttpTarget target;
+  if (!parseUrl(o.url, target)) {
+    fprintf(stderr, "fleet_loadgen: cannot resolve %s (only http:// is supported)\n", o.url.c_str());
+    return 1;
+  }
+
+  // เวลาเสมือน 0 = บูตพร้อมกันตอน --start-hour (ชั่วโมงของวัน ใช้กำหนดความถี่คนเข้า)
+  const double clockOffsetS = o.startHour * 3600.0;
+
+  std::vector<VirtualDevice> devices((size_t)o.devices);
+  std::mt19937_64 seeder(o.seed);
+  for (int k = 0; k < o.devices; k++) {
+    VirtualDevice &d = devices[(size_t)k];
+    snprintf(d.id, sizeof(d.id), "%s%05d", o.prefix.c_str(), k);
+    d.rng.seed(seeder());
+    // บูตไม่พร้อมกันเป๊ะ: heartbeat แรกกระจายใน HEARTBEAT_MS แรก (กัน thundering herd เทียม)
+    d.lastBeatMs = 0u - std::uniform_int_distribution<uint32_t>(0, HEARTBEAT_MS)(d.rng);
+    for (size_t i = 0; i < ROOM_COUNT; i++) d.nextVisitGenUs[i] = 0;
+  }
+
+  printf("fleet_loadgen: %d devices x %u rooms, %d threads, %.0fs at speed x%.1f -> %s (%s)\n",
+         o.devices, (unsigned)ROOM_COUNT, o.threads, o.durationS, o.speed, o.url.c_str(),
+         o.keepAlive ? "keep-alive" : "new connection per request");
+  fflush(stdout);
+
+  std::vector<WorkerStats> stats((size_t)o.threads);
+  std::vector<std::thread> pool;
+  int64_t wallStart = wallUs();
+  for (int w = 0; w < o.threads; w++) {
+    std::vector<uint32_t> mine;
+    for (int k = w; k < o.devices; k += o.threads) mine.push_back((uint32_t)k);
+    pool.emplace_back(workerMain, &devices, std::move(mine), &o, &target,
+                      wallStart, clockOffsetS, &stats[(size_t)w]);
+  }
+
+  // ความคืบหน้าทุก 5s
+  std::atomic<bool> done{false};
+  std::thread progress([&] {
+    uint64_t last = 0;
+    int64_t tick = wallStart;
+    while (!done.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      int64_t now = wallUs();
+      if (now - tick < 5000000) continue;
+      uint64_t n = liveRequests.load(std::memory_order_relaxed);
+      printf("  t=%5.0fs  requests=%llu  (%.0f req/s)\n", (now - wallStart) / 1e6,
+             (unsigned long long)n, (n - last) / ((now - tick) / 1e6));
+      fflush(stdout);
+      last = n;
+      tick = now;
+    }
+  });
+
+  for (std::thread &t : pool) t.join();
+  double elapsedS = (wallUs() - wallStart) / 1e6;
+  done.store(true);
+  progress.join();
+  freeaddrinfo(target.addr);
+
+  WorkerStats all;
+  for (const WorkerStats &s : stats) {
+    all.latUs.insert(all.latUs.end(), s.latUs.begin(), s.latUs.end());
+    all.svcUs.insert(all.svcUs.end(), s.svcUs.begin(), s.svcUs.end());
+    all.requests  += s.requests;   all.ok2xx   += s.ok2xx;
+    all.http4xx   += s.http4xx;    all.http5xx += s.http5xx;
+    all.transport += s.transport;  all.full    += s.full;
+    all.delta     += s.delta;      all.needFull += s.needFull;
+    all.batches   += s.batches;    all.events  += s.events;
+    all.bytes     += s.bytes;      all.lateSends += s.lateSends;
+    all.maxLagUs   = std::max(all.maxLagUs, s.maxLagUs);
+    all.unsent    += s.unsent;     all.behindUs = std::max(all.behindUs, s.behindUs);
+    all.connOpens += s.connOpens;
+  }
+  std::sort(all.latUs.begin(), all.latUs.end());
+  std::sort(all.svcUs.begin(), all.svcUs.end());
+
+  uint64_t sessions = 0, pending = 0, dropped = 0, awakePm = 0;
+  for (const VirtualDevice &d : devices) {
+    for (size_t i = 0; i < ROOM_COUNT; i++) sessions += d.panel.uses[i];
+    pending += d.sink.journal.size();
+    dropped += d.sink.dropped;
+    awakePm += sleepStatsAwakePermille(d.sleep, (uint64_t)(o.durationS * o.speed * 1e6));
+  }
+
+  printf("\n=== fleet_loadgen report ===\n");
+  printf("elapsed          : %.1f s wall (%.1f min virtual per device)\n",
+         elapsedS, o.durationS * o.speed / 60.0);
+  printf("requests         : %llu  (%.1f req/s, %.1f KB/s payload)\n",
+         (unsigned long long)all.requests, all.requests / elapsedS, all.bytes / 1024.0 / elapsedS);
+  printf("responses        : 2xx=%llu 4xx=%llu 5xx=%llu transport-errors=%llu\n",
+         (unsigned long long)all.ok2xx, (unsigned long long)all.http4xx,
+         (unsigned long long)all.http5xx, (unsigned long long)all.transport);
+  printf("payloads         : full=%llu delta=%llu need_full=%llu  avg %.0f bytes\n",
+         (unsigned long long)all.full, (unsigned long long)all.delta,
+         (unsigned long long)all.needFull, all.requests ? (double)all.bytes / all.requests : 0.0);
+  printf("journal          : batches=%llu events=%llu  pending=%llu dropped=%llu\n",
+         (unsigned long long)all.batches, (unsigned long long)all.events,
+         (unsigned long long)pending, (unsigned long long)dropped);
+  printf("latency (ms)     : p50=%.2f p99=%.2f p999=%.2f max=%.2f  (n=%zu)\n",
+         pct(all.latUs, 0.50), pct(all.latUs, 0.99), pct(all.latUs, 0.999),
+         all.latUs.empty() ? 0.0 : all.latUs.back() / 1000.0, all.latUs.size());
+  printf("service (ms)     : p50=%.2f p99=%.2f p999=%.2f max=%.2f  (POST only, no queueing)\n",
+         pct(all.svcUs, 0.50), pct(all.svcUs, 0.99), pct(all.svcUs, 0.999),
+         all.svcUs.empty() ? 0.0 : all.svcUs.back() / 1000.0);
+  printf("connections      : %u opened\n", all.connOpens);
+  printf("generator        : max lag %.1f ms, %llu sends >100ms late%s\n",
+         all.maxLagUs / 1000.0, (unsigned long long)all.lateSends,
+         all.lateSends ? "  (add --threads or lower --speed)" : "");
+  printf("unsent           : %llu device wakeups due before the deadline were not run",
+         (unsigned long long)all.unsent);
+  if (all.unsent) printf("  (%.1f s virtual behind; backend or generator too slow)", all.behindUs / 1e6);
+  printf("\n");
+  printf("simulated usage  : %llu sessions finished across %d devices, awake %.1f%% avg\n",
+         (unsigned long long)sessions, o.devices, awakePm / 10.0 / o.devices);
+  return (all.transport || all.unsent) ? 1 : 0;
+}
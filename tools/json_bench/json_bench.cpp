@@ -0,0 +1,356 @@
+/* =========================================================
+ * json_bench: เทียบตัวสร้าง payload สถานะ แบบเดิม (String +=) กับ writeStatusJson()
+ *
+ * แบบเดิม (ก่อน status_json.h): buildStatusJson() ต่อ Arduino String ทีละชิ้น
+ *   + สร้าง String ชั่วคราวจาก "..." + String(x) + "," ทุก field แล้วพิมพ์ payload ทั้งก้อนลง Serial
+ * แบบใหม่: writeStatusJson() เขียนลงบัฟเฟอร์ static (เต็ม หรือ delta เฉพาะห้องที่เปลี่ยน)
+ *
+ * บน PC ไม่มี Arduino String จึงใช้ตัวเลียนแบบ (BenchString) ที่จองหน่วยความจำแบบเดียวกับ
+ * WString ของ arduino-esp32: SSO 11 ตัวอักษร, เกินนั้น realloc ขนาดพอดี (+1) ทุกครั้งที่โต
+ * ทุกการจองผ่านตัวนับ (counting allocator) + operator new ทั่วโปรแกรมก็ถูกนับด้วย
+ *
+ * รายงานต่อการสร้าง 1 ครั้ง: จำนวนครั้งที่จอง, byte ที่จอง, byte ที่ส่ง (HTTP body)
+ * + byte ที่พิมพ์ลง Serial (ดีบัก), และเวลา (ns) บนเครื่อง PC นี้
+ *
+ * send mix: ลำดับการส่งจริงของบอร์ดต่อ 1 คน -> เริ่ม session (batch 1 event + status),
+ *   heartbeat ทุก 10s ระหว่างใช้ (POST สถานะ), จบ session (batch 1 event + status)
+ *   payload เต็มพ่วงบล็อก "perf" เหมือนบอร์ด; เทียบ batch ที่ส่งสถานะเต็มเสมอ (เดิม)
+ *   กับ batch ที่ใช้ delta ตามกติกาเดียวกับ POST สถานะ (STATUS_FULL_EVERY)
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -Iesp32_firmware tools/json_bench/json_bench.cpp -o json_bench
+ *
+ * ใช้งาน:
+ *   ./json_bench                  # ROOM_COUNT ห้อง, 200000 รอบ
+ *   ./json_bench --rooms 16 --iters 100000 --beats 18
+ * ========================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+
+#include "panel_config.h"     // ROOM_COUNT
+#include "status_json.h"
+#define PERF_NOW_US() 0       // บน PC ไม่ได้จับเวลาจริง แค่ต้องการขนาดบล็อก "perf"
+#include "perf_probe.h"
+
+#define BENCH_ROOMS_MAX 32
+#define BENCH_DEVICE_ID "panel-01"
+#define BENCH_JSON_BUF  (160 + BENCH_ROOMS_MAX * 110 + PERF_JSON_MAX + 200)
+
+/* =========================================================
+ * counting allocator
+ * ========================================================= */
+static size_t allocCalls = 0;
+static size_t allocBytes = 0;
+
+static void *countedMalloc(size_t n)           { allocCalls++; allocBytes += n; return malloc(n); }
+static void *countedRealloc(void *p, size_t n) { allocCalls++; allocBytes += n; return realloc(p, n); }
+
+void *operator new(size_t n) {
+  void *p = countedMalloc(n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept           { free(p); }
+void operator delete(void *p, size_t) noexcept   { free(p); }
+
+/* =========================================================
+ * BenchString: จองหน่วยความจำแบบ Arduino String (arduino-esp32 WString)
+ * ========================================================= */
+class BenchString {
+ public:
+  static const size_t SSO_CAP = 11;
+
+  BenchString() { init(); }
+  BenchString(const char *s) { init(); copy(s, strlen(s)); }
+  BenchString(const BenchString &o) { init(); copy(o.c_str(), o.len_); }
+  explicit BenchString(unsigned long v) {
+    char tmp[21];
+    snprintf(tmp, sizeof(tmp), "%lu", v);
+    init();
+    copy(tmp, strlen(tmp));
+  }
+  explicit BenchString(unsigned int v) : BenchString((unsigned long)v) {}
+  explicit BenchString(int v) : BenchString((unsigned long)v) {}
+  ~BenchString() { if (heap_) free(heap_); }
+
+  BenchString &operator=(const BenchString &o) {
+    if (this != &o) { len_ = 0; copy(o.c_str(), o.len_); }
+    return *this;
+  }
+
+  BenchString &operator+=(const char *s)        { concat(s, strlen(s)); return *this; }
+  BenchString &operator+=(const BenchString &o) { concat(o.c_str(), o.len_); return *this; }
+
+  // "..." + String / String + "..." -> StringSumHelper (ชั่วคราว 1 ตัวต่อ +)
+  friend BenchString operator+(const char *a, const BenchString &b) {
+    BenchString r(a);
+    r += b;
+    return r;
+  }
+  friend BenchString operator+(const BenchString &a, const char *b) {
+    BenchString r(a);
+    r += b;
+    return r;
+  }
+
+  const char *c_str() const { return heap_ ? heap_ : sso_; }
+  size_t length() const     { return len_; }
+
+ private:
+  char  *heap_;
+  char   sso_[SSO_CAP + 1];
+  size_t len_, cap_;
+
+  void init() { heap_ = nullptr; sso_[0] = '\0'; len_ = 0; cap_ = SSO_CAP; }
+
+  void reserve(size_t n) {
+    if (n <= cap_) return;
+    char *p = (char *)countedRealloc(heap_, n + 1);   // WString::changeBuffer(): ขนาดพอดี
+    if (!heap_) memcpy(p, sso_, len_ + 1);
+    heap_ = p;
+    cap_  = n;
+  }
+  void copy(const char *s, size_t n) {
+    reserve(n);
+    memcpy((char *)c_str(), s, n);
+    len_ = n;
+    ((char *)c_str())[n] = '\0';
+  }
+  void concat(const char *s, size_t n) {
+    reserve(len_ + n);
+    memcpy((char *)c_str() + len_, s, n + 1);
+    len_ += n;
+  }
+};
+
+/* =========================================================
+ * แบบเดิม: buildStatusJson() จาก send_to_backend.h ก่อนเปลี่ยน (ขยายเป็น N ห้อง)
+ * ========================================================= */
+static BenchString legacyBuildStatusJson(const RoomReport *rooms, size_t n,
+                                         uint32_t lastCleanMs, bool cleaningRequired, uint32_t now) {
+  BenchString j = "{";
+  j += "\"device_id\":\"" + BenchString(BENCH_DEVICE_ID) + "\",";
+  j += "\"last_clean_ts_ms\":" + BenchString((unsigned long)lastCleanMs) + ",";
+  j += "\"cleaning_required\":" + BenchString(cleaningRequired ? "true" : "false") + ",";
+
+  j += "\"rooms\":[";
+  for (size_t i = 0; i < n; i++) {
+    j += "{";
+    j += "\"room_id\":" + BenchString((unsigned long)(i + 1)) + ",";
+    j += "\"state\":\""; j += roomReportStateWord(rooms[i].state); j += "\",";
+    j += "\"use_count\":" + BenchString((unsigned long)rooms[i].uses) + ",";
+    j += "\"total_use_ms\":" + BenchString((unsigned long)rooms[i].totalMs) + ",";
+    j += "\"door_closed\":" + BenchString(rooms[i].doorClosed ? "true" : "false");
+    j += "}";
+    if (i + 1 < n) j += ",";
+  }
+  j += "],";
+
+  j += "\"ts_ms\":" + BenchString((unsigned long)now);
+  j += "}";
+  return j;
+}
+
+/* =========================================================
+ * ตัววัด
+ * ========================================================= */
+struct BenchResult {
+  double allocCalls, allocBytes, bodyBytes, serialBytes, ns;
+};
+
+static volatile size_t sink;   // กัน compiler ตัดงานทิ้ง
+
+/* snapshot ที่เปลี่ยนทีละห้องต่อรอบ (รูปแบบที่พบบ่อย: 1 ห้องเริ่ม/จบ session) */
+static void mutate(RoomReport *rooms, size_t n, uint32_t k) {
+  RoomReport &r = rooms[k % n];
+  r.state = (r.state == ROOM_OCCUPIED) ? ROOM_VACANT : ROOM_OCCUPIED;
+  r.doorClosed = r.state == ROOM_OCCUPIED;
+  if (r.state == ROOM_VACANT) { r.uses++; r.totalMs += 150000 + (k * 7919) % 200000; }
+}
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static BenchResult runLegacy(size_t n, uint32_t iters) {
+  RoomReport rooms[BENCH_ROOMS_MAX] = {};
+  size_t c0 = allocCalls, b0 = allocBytes, body = 0, serial = 0;
+  int64_t t0 = nowNs();
+  for (uint32_t k = 0; k < iters; k++) {
+    mutate(rooms, n, k);
+    BenchString payload = legacyBuildStatusJson(rooms, n, 123456, false, 1000000 + k);
+    body   += payload.length();
+    serial += strlen("[DEBUG] payload:\n") + payload.length() + 1;   // พิมพ์ทุกครั้งในแบบเดิม
+    sink   += payload.c_str()[payload.length() - 1];
+  }
+  int64_t dt = nowNs() - t0;
+  return {(double)(allocCalls - c0) / iters, (double)(allocBytes - b0) / iters,
+          (double)body / iters, (double)serial / iters, (double)dt / iters};
+}
+
+static BenchResult runWriter(size_t n, uint32_t iters, bool delta) {
+  static char buf[BENCH_JSON_BUF];
+  RoomReport rooms[BENCH_ROOMS_MAX] = {};
+  RoomReport acked[BENCH_ROOMS_MAX] = {};
+  size_t c0 = allocCalls, b0 = allocBytes, body = 0;
+  int64_t t0 = nowNs();
+  for (uint32_t k = 0; k < iters; k++) {
+    mutate(rooms, n, k);
+    JsonOut out(buf, sizeof(buf));
+    writeStatusJson(out, BENCH_DEVICE_ID, 123456, false, rooms, n,
+                    delta ? acked : nullptr, 1000000 + k);
+    if (delta) memcpy(acked, rooms, sizeof(RoomReport) * n);   // backend ตอบ ok ทุกครั้ง
+    body += out.len;
+    sink += buf[out.len - 1];
+  }
+  int64_t dt = nowNs() - t0;
+  return {(double)(allocCalls - c0) / iters, (double)(allocBytes - b0) / iters,
+          (double)body / iters, 0.0, (double)dt / iters};
+}
+
+/* =========================================================
+ * send mix: ลำดับการส่งของบอร์ดจริง (net task) ต่อ 1 คนที่เข้าห้อง
+ * ========================================================= */
+struct MixResult {
+  uint32_t sends, fullSends;
+  double   batchBytes, beatBytes, perVisitBytes;
+};
+
+/* batch ที่มี event เดียว: โครงเดียวกับ buildBatchJson() ใน send_to_backend.h */
+static void writeMixBatch(JsonOut &out, uint32_t seq, size_t room, bool end,
+                          const RoomReport *rooms, size_t n, const RoomReport *acked, uint32_t ts) {
+  out.ch('{');
+  out.key("device_id"); out.str(BENCH_DEVICE_ID); out.ch(',');
+  out.key("boot_id");   out.u32(1);               out.ch(',');
+  out.key("ts_ms");     out.u32(ts);              out.ch(',');
+  out.key("events");
+  out.ch('[');
+  out.ch('{');
+  out.key("seq");     out.u32(seq);                    out.ch(',');
+  out.key("boot_id"); out.u32(1);                      out.ch(',');
+  out.key("room_id"); out.u32((uint32_t)room + 1);     out.ch(',');
+  out.key("kind");    out.str(end ? "end" : "start");  out.ch(',');
+  out.key("ts_ms");   out.u32(ts);                     out.ch(',');
+  out.key("dur_ms");  out.u32(end ? 180000 : 0);
+  out.ch('}');
+  out.ch(']');
+  out.ch(',');
+  out.key("status");
+  writeStatusJson(out, BENCH_DEVICE_ID, 123456, false, rooms, n, acked, ts,
+                  acked ? nullptr : perfWriteJson);
+  out.ch('}');
+}
+
+static MixResult runMix(size_t n, uint32_t visits, uint32_t beatsPerVisit, bool batchDelta) {
+  static char buf[BENCH_JSON_BUF];
+  RoomReport rooms[BENCH_ROOMS_MAX] = {};
+  RoomReport acked[BENCH_ROOMS_MAX] = {};
+  bool haveAck = false;
+  uint32_t sinceFull = 0, seq = 0, ts = 1000;
+  uint64_t batchB = 0, beatB = 0, batches = 0, beats = 0;
+  MixResult r = {};
+
+  // ส่ง 1 ครั้ง (backend ตอบ ok ทุกครั้ง) คืนขนาด body
+  auto send = [&](bool isBatch, size_t room, bool end) -> size_t {
+    bool delta = haveAck && sinceFull < STATUS_FULL_EVERY;
+    if (isBatch && !batchDelta) delta = false;        // เดิม: batch ส่งสถานะเต็มเสมอ
+    const RoomReport *base = delta ? acked : nullptr;
+    JsonOut out(buf, sizeof(buf));
+    if (isBatch) writeMixBatch(out, seq++, room, end, rooms, n, base, ts);
+    else         writeStatusJson(out, BENCH_DEVICE_ID, 123456, false, rooms, n, base, ts,
+                                 delta ? nullptr : perfWriteJson);
+    memcpy(acked, rooms, sizeof(RoomReport) * n);
+    haveAck = true;
+    sinceFull = delta ? sinceFull + 1 : 0;
+    r.sends++;
+    if (!delta) r.fullSends++;
+    ts += 10000;
+    return out.len;
+  };
+
+  for (uint32_t v = 0; v < visits; v++) {
+    size_t k = v % n;
+    rooms[k].state = ROOM_OCCUPIED;
+    rooms[k].doorClosed = true;
+    batchB += send(true, k, false);
+    batches++;
+    for (uint32_t b = 0; b < beatsPerVisit; b++) {
+      beatB += send(false, k, false);
+      beats++;
+    }
+    rooms[k].state = ROOM_VACANT;
+    rooms[k].doorClosed = false;
+    rooms[k].uses++;
+    rooms[k].totalMs += 180000;
+    batchB += send(true, k, true);
+    batches++;
+  }
+  r.batchBytes    = batches ? (double)batchB / batches : 0.0;
+  r.beatBytes     = beats ? (double)beatB / beats : 0.0;
+  r.perVisitBytes = visits ? (double)(batchB + beatB) / visits : 0.0;
+  return r;
+}
+
+static void printMixRow(const char *name, const MixResult &r) {
+  printf("%-28s %7.1f%% %10.1f %10.1f %12.1f\n", name,
+         r.sends ? 100.0 * r.fullSends / r.sends : 0.0, r.batchBytes, r.beatBytes, r.perVisitBytes);
+}
+
+static void printRow(const char *name, const BenchResult &r) {
+  printf("%-24s %8.1f %10.1f %10.1f %10.1f %10.1f\n",
+         name, r.allocCalls, r.allocBytes, r.bodyBytes, r.serialBytes, r.ns);
+}
+
+int main(int argc, char **argv) {
+  size_t rooms = ROOM_COUNT;
+  uint32_t iters = 200000;
+  uint32_t beats = 18;          // heartbeat ต่อคน (ใช้ห้อง ~3 นาที, HEARTBEAT_MS = 10s)
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if      (!strcmp(argv[i], "--rooms")) rooms = (size_t)atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--iters")) iters = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    else if (!strcmp(argv[i], "--beats")) beats = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    else { fprintf(stderr, "usage: json_bench [--rooms N] [--iters K] [--beats B]\n"); return 2; }
+  }
+  if (rooms < 1 || rooms > BENCH_ROOMS_MAX || iters == 0) {
+    fprintf(stderr, "json_bench: --rooms must be 1..%d, --iters > 0\n", BENCH_ROOMS_MAX);
+    return 2;
+  }
+
+  // ตรวจว่าสองแบบให้ JSON เดียวกัน (แบบใหม่มี door_closed ลำดับเดียวกัน)
+  {
+    RoomReport r[BENCH_ROOMS_MAX] = {};
+    for (size_t i = 0; i < rooms; i++) mutate(r, rooms, (uint32_t)i);
+    static char buf[BENCH_JSON_BUF];
+    JsonOut out(buf, sizeof(buf));
+    writeStatusJson(out, BENCH_DEVICE_ID, 42, true, r, rooms, nullptr, 99);
+    BenchString old = legacyBuildStatusJson(r, rooms, 42, true, 99);
+    if (strcmp(old.c_str(), buf) != 0) {
+      fprintf(stderr, "json_bench: payload mismatch\n old: %s\n new: %s\n", old.c_str(), buf);
+      return 1;
+    }
+  }
+
+  printf("json_bench: %zu rooms, %u iterations (1 room changes per send)\n\n", rooms, iters);
+  printf("%-24s %8s %10s %10s %10s %10s\n", "per serialization", "allocs", "alloc B", "body B", "serial B", "ns");
+  printRow("String += (old)",          runLegacy(rooms, iters));
+  printRow("writeStatusJson full",     runWriter(rooms, iters, false));
+  printRow("writeStatusJson delta",    runWriter(rooms, iters, true));
+
+  // บล็อก "perf" ขนาดเหมือนบอร์ดที่รันมาสักพัก (ทุกขั้นมีตัวอย่าง)
+  for (uint8_t st = 0; st < PERF_STAGES; st++)
+    for (uint32_t k = 0; k < 1000; k++) perfRecord(st, 50u + k * 37u * (st + 1));
+  perf.counters = {1234, 5678901, 12, 3456};
+
+  const uint32_t visits = 3000;
+  printf("\nsend mix: %u visits, per visit 2 batch (1 event) + %u heartbeat; full payload carries \"perf\"\n\n",
+         visits, beats);
+  printf("%-28s %8s %10s %10s %12s\n", "routing", "full", "batch B", "beat B", "B/visit");
+  printMixRow("batch status always full",  runMix(rooms, visits, beats, false));
+  printMixRow("batch status uses delta",   runMix(rooms, visits, beats, true));
+  return 0;
+}
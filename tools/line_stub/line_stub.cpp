@@ -0,0 +1,298 @@
+/* =========================================================
+ * line_stub: ตัวแทน LINE push API ในเครื่อง (ทดสอบคิวแจ้งเตือนของเฟิร์มแวร์)
+ *
+ * รับ POST แบบ HTTP/1.1 keep-alive เหมือน api.line.me แล้วตรวจแบบเดียวกับของจริง
+ *   - ต้องมี "Authorization: Bearer ..." (ไม่มี -> 401)
+ *   - messages ต้องมี 1..5 ข้อความ (เกิน -> 400)
+ *   - จำกัดอัตรา: เกิน --limit push ใน --window-ms -> 429
+ *   - --fail-every K: ทุก push ที่ K ตอบ 500 (จำลอง server ล่ม)
+ *   - X-Line-Retry-Key ที่เคยตอบ 200 ไปแล้ว -> 409 (ไม่นับเป็นข้อความใหม่)
+ *   - --drop-every K: ทุก push ที่ K รับแล้วแต่ปิด socket ไม่ตอบ (คำตอบหาย -> เฟิร์มแวร์ต้องส่งซ้ำด้วย key เดิม)
+ * พิมพ์ทุก push (จำนวนข้อความ + ข้อความ) และสรุปเมื่อกด Ctrl+C
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 tools/line_stub/line_stub.cpp -o line_stub
+ *
+ * ใช้งาน:
+ *   ./line_stub [--port 8080] [--limit N] [--window-ms W] [--fail-every K] [--drop-every K] [--latency-ms L]
+ * แล้วแฟลชเฟิร์มแวร์ด้วย -DLINE_PUSH_URL='"http://<ip เครื่องนี้>:8080/v2/bot/message/push"'
+ * ========================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#define MAX_CLIENTS   16
+#define LINE_MAX_MSGS 5
+
+struct Options {
+  int      port      = 8080;
+  int      limit     = 0;        // 0 = ไม่จำกัด
+  int      windowMs  = 60000;
+  int      failEvery = 0;        // 0 = ไม่จำลองล่ม
+  int      dropEvery = 0;        // 0 = ไม่จำลองคำตอบหาย
+  int      latencyMs = 0;
+};
+
+struct Stats {
+  unsigned long requests = 0;
+  unsigned long ok       = 0;
+  unsigned long msgs     = 0;
+  unsigned long r400     = 0;
+  unsigned long r401     = 0;
+  unsigned long r429     = 0;
+  unsigned long r409     = 0;
+  unsigned long r500     = 0;
+  unsigned long dropped  = 0;      // รับแล้วแต่ไม่ตอบ
+  unsigned long noKey    = 0;      // push ที่ไม่มี X-Line-Retry-Key
+  unsigned long maxBatch = 0;
+  unsigned long conns    = 0;
+};
+
+struct Client {
+  int         fd = -1;
+  std::string in;
+};
+
+static volatile sig_atomic_t stopFlag = 0;
+static void onSignal(int) { stopFlag = 1; }
+
+/* ms นับจากเริ่มโปรแกรม */
+static long long nowMs() {
+  static long long t0 = -1;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  long long t = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  if (t0 < 0) t0 = t;
+  return t - t0;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: line_stub [--port P] [--limit N] [--window-ms W] [--fail-every K] [--drop-every K]\n"
+          "                 [--latency-ms L]\n");
+  exit(2);
+}
+
+static bool parseArgs(int argc, char **argv, Options &o) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (i + 1 >= argc) return false;
+    int v = atoi(argv[++i]);
+    if      (!strcmp(a, "--port"))       o.port = v;
+    else if (!strcmp(a, "--limit"))      o.limit = v;
+    else if (!strcmp(a, "--window-ms"))  o.windowMs = v;
+    else if (!strcmp(a, "--fail-every")) o.failEvery = v;
+    else if (!strcmp(a, "--drop-every")) o.dropEvery = v;
+    else if (!strcmp(a, "--latency-ms")) o.latencyMs = v;
+    else return false;
+  }
+  return o.port > 0 && o.windowMs > 0;
+}
+
+/* หา header แบบไม่สนตัวพิมพ์เล็ก/ใหญ่ คืนค่าหลัง ':' (ตัดช่องว่างหน้า) */
+static std::string headerValue(const std::string &head, const char *name) {
+  size_t n = strlen(name);
+  size_t pos = 0;
+  while ((pos = head.find("\r\n", pos)) != std::string::npos) {
+    pos += 2;
+    if (head.size() - pos > n && strncasecmp(head.c_str() + pos, name, n) == 0 && head[pos + n] == ':') {
+      size_t v = pos + n + 1;
+      while (v < head.size() && head[v] == ' ') v++;
+      size_t e = head.find("\r\n", v);
+      return head.substr(v, e == std::string::npos ? std::string::npos : e - v);
+    }
+  }
+  return std::string();
+}
+
+/* ดึงค่า "text":"..." ทุกตัว (decode \" \\ \n พอให้อ่าน log ได้) */
+static std::vector<std::string> messageTexts(const std::string &body) {
+  std::vector<std::string> out;
+  const std::string key = "\"text\":\"";
+  size_t pos = 0;
+  while ((pos = body.find(key, pos)) != std::string::npos) {
+    pos += key.size();
+    std::string t;
+    while (pos < body.size() && body[pos] != '"') {
+      char c = body[pos++];
+      if (c == '\\' && pos < body.size()) {
+        char e = body[pos++];
+        c = (e == 'n') ? '\n' : (e == 't') ? '\t' : (e == 'r') ? '\r' : e;
+      }
+      t += c;
+    }
+    out.push_back(t);
+  }
+  return out;
+}
+
+static void sendResponse(int fd, int code, const char *reason, const char *body) {
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                   "Content-Length: %zu\r\nConnection: keep-alive\r\n\r\n",
+                   code, reason, strlen(body));
+  std::string all(head, n);
+  all += body;
+  size_t off = 0;
+  while (off < all.size()) {
+    ssize_t w = send(fd, all.data() + off, all.size() - off, MSG_NOSIGNAL);
+    if (w <= 0) return;
+    off += (size_t)w;
+  }
+}
+
+/* ตอบ 1 request; คืนจำนวน byte ที่ใช้จาก c.in (0 = ยังไม่ครบ, c.fd = -1 ถ้าจำลองคำตอบหาย) */
+static size_t handleRequest(Client &c, const Options &o, Stats &st, std::deque<long long> &okTimes,
+                            std::set<std::string> &acceptedKeys) {
+  size_t headEnd = c.in.find("\r\n\r\n");
+  if (headEnd == std::string::npos) return 0;
+  std::string head = c.in.substr(0, headEnd);
+  size_t len = (size_t)atol(headerValue(head, "Content-Length").c_str());
+  size_t total = headEnd + 4 + len;
+  if (c.in.size() < total) return 0;
+  std::string body = c.in.substr(headEnd + 4, len);
+
+  st.requests++;
+  long long t = nowMs();
+  if (o.latencyMs > 0) usleep((useconds_t)o.latencyMs * 1000);
+
+  std::string auth = headerValue(head, "Authorization");
+  std::string key  = headerValue(head, "X-Line-Retry-Key");
+  std::vector<std::string> texts = messageTexts(body);
+  while (!okTimes.empty() && t - okTimes.front() >= o.windowMs) okTimes.pop_front();
+
+  if (head.compare(0, 5, "POST ") != 0 || auth.compare(0, 7, "Bearer ") != 0) {
+    st.r401++;
+    printf("[%lld] 401 missing bearer token\n", t);
+    sendResponse(c.fd, 401, "Unauthorized", "{\"message\":\"Authentication failed\"}");
+  } else if (texts.empty() || texts.size() > LINE_MAX_MSGS) {
+    st.r400++;
+    printf("[%lld] 400 messages=%zu (must be 1..%d)\n", t, texts.size(), LINE_MAX_MSGS);
+    sendResponse(c.fd, 400, "Bad Request", "{\"message\":\"The request body has 1 error(s)\"}");
+  } else if (!key.empty() && acceptedKeys.count(key)) {
+    st.r409++;
+    printf("[%lld] 409 retry key %s already accepted\n", t, key.c_str());
+    sendResponse(c.fd, 409, "Conflict", "{\"message\":\"The retry key is already accepted\"}");
+  } else if (o.limit > 0 && (int)okTimes.size() >= o.limit) {
+    st.r429++;
+    printf("[%lld] 429 rate limited (%d push / %d ms)\n", t, o.limit, o.windowMs);
+    sendResponse(c.fd, 429, "Too Many Requests",
+                 "{\"message\":\"The API rate limit has been exceeded. Try again later.\"}");
+  } else if (o.failEvery > 0 && st.requests % (unsigned long)o.failEvery == 0) {
+    st.r500++;
+    printf("[%lld] 500 simulated failure\n", t);
+    sendResponse(c.fd, 500, "Internal Server Error", "{\"message\":\"Internal server error\"}");
+  } else {
+    st.ok++;
+    st.msgs += texts.size();
+    if (texts.size() > st.maxBatch) st.maxBatch = texts.size();
+    okTimes.push_back(t);
+    if (key.empty()) st.noKey++;
+    else             acceptedKeys.insert(key);
+    printf("[%lld] 200 push with %zu message(s) key=%s\n", t, texts.size(), key.empty() ? "-" : key.c_str());
+    for (const std::string &m : texts) {
+      printf("    | ");
+      for (char ch : m) {
+        if (ch == '\n') printf("\n    | ");
+        else             putchar(ch);
+      }
+      putchar('\n');
+    }
+    if (o.dropEvery > 0 && st.ok % (unsigned long)o.dropEvery == 0) {
+      st.dropped++;
+      printf("    (response dropped, closing socket)\n");
+      fflush(stdout);
+      close(c.fd);
+      c.fd = -1;
+      return total;
+    }
+    sendResponse(c.fd, 200, "OK", "{}");
+  }
+  fflush(stdout);
+  return total;
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) usage();
+
+  int ls = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons((uint16_t)o.port);
+  if (ls < 0 || bind(ls, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(ls, 8) < 0) {
+    perror("line_stub: listen");
+    return 1;
+  }
+
+  struct sigaction sa = {};
+  sa.sa_handler = onSignal;   // ไม่ใส่ SA_RESTART -> poll() ถูกขัดแล้วออกจากลูปได้
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  nowMs();
+  printf("line_stub listening on :%d (limit=%d/%dms fail-every=%d drop-every=%d latency=%dms)\n",
+         o.port, o.limit, o.windowMs, o.failEvery, o.dropEvery, o.latencyMs);
+  fflush(stdout);
+
+  Stats st;
+  std::deque<long long> okTimes;
+  std::set<std::string> acceptedKeys;
+  std::vector<Client> clients;
+
+  while (!stopFlag) {
+    std::vector<struct pollfd> pfds;
+    pfds.push_back({ls, POLLIN, 0});
+    for (const Client &c : clients) pfds.push_back({c.fd, POLLIN, 0});
+    if (poll(pfds.data(), pfds.size(), 1000) < 0) continue;
+
+    if ((pfds[0].revents & POLLIN) && clients.size() < MAX_CLIENTS) {
+      int fd = accept(ls, nullptr, nullptr);
+      if (fd >= 0) {
+        clients.push_back(Client{fd, std::string()});
+        st.conns++;
+      }
+    }
+
+    for (size_t i = 1; i < pfds.size(); i++) {
+      if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      Client &c = clients[i - 1];
+      char buf[4096];
+      ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+      if (r <= 0) { close(c.fd); c.fd = -1; continue; }
+      c.in.append(buf, (size_t)r);
+      size_t used;
+      while (c.fd >= 0 && (used = handleRequest(c, o, st, okTimes, acceptedKeys)) > 0) c.in.erase(0, used);
+    }
+    for (size_t i = clients.size(); i-- > 0;) {
+      if (clients[i].fd < 0) clients.erase(clients.begin() + i);
+    }
+  }
+
+  for (const Client &c : clients) close(c.fd);
+  close(ls);
+
+  printf("\n=== line_stub summary ===\n");
+  printf("requests=%lu  connections=%lu (keep-alive reuse %.1f req/conn)\n",
+         st.requests, st.conns, st.conns ? (double)st.requests / st.conns : 0.0);
+  printf("200=%lu  messages=%lu  avg/push=%.2f  max/push=%lu\n",
+         st.ok, st.msgs, st.ok ? (double)st.msgs / st.ok : 0.0, st.maxBatch);
+  printf("400=%lu  401=%lu  409=%lu  429=%lu  500=%lu  dropped=%lu  no-retry-key=%lu\n",
+         st.r400, st.r401, st.r409, st.r429, st.r500, st.dropped, st.noKey);
+  return 0;
+}
@@ -0,0 +1,184 @@
+/* =========================================================
+ * oled_bench: วัด byte บนสาย I2C ของจอ OLED บน PC
+ *
+ * เทียบ 2 แบบด้วยเลย์เอาต์ชุดเดียวกับบอร์ด (oled_view.h):
+ *   - full    : วาดใหม่ + display() ทั้งจอ 1KB ทุก 250ms (แบบเดิม)
+ *   - partial : วาดเฉพาะเมื่อ model เปลี่ยน + ส่งเฉพาะ page/คอลัมน์ที่เปลี่ยน (oled_partial.h)
+ * mock จอเก็บ GDDRAM จำลองและตรวจว่าตรงกับ framebuffer ทุกครั้งหลังส่ง
+ * (ฟอนต์ใน mock เป็นลายสุ่มตามตัวอักษร ขนาดช่อง 6x8 เท่าฟอนต์จริงของ Adafruit GFX
+ *  จึงให้ "พื้นที่ที่เปลี่ยน" เท่ากับของจริง)
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -Iesp32_firmware tools/oled_bench/oled_bench.cpp -o oled_bench
+ *
+ * ใช้งาน:
+ *   ./oled_bench [--minutes M] [--seed S]
+ * ========================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "panel_config.h"
+#include "oled_view.h"
+#include "oled_partial.h"
+
+/* ====== mock Adafruit GFX: วาดลง framebuffer แบบ page เดียวกับ SSD1306 ====== */
+struct MockGfx {
+  uint8_t fb[OLED_FB_BYTES];
+  int cx = 0, cy = 0, size = 1;
+
+  void clearDisplay() { memset(fb, 0, sizeof(fb)); cx = cy = 0; }
+  void setTextSize(int s) { size = s; }
+  void setTextColor(int) {}
+  void setCursor(int x, int y) { cx = x; cy = y; }
+  uint8_t *getBuffer() { return fb; }
+
+  void pixel(int x, int y) {
+    if (x < 0 || y < 0 || x >= OLED_WIDTH || y >= OLED_PAGES * 8) return;
+    fb[(y / 8) * OLED_WIDTH + x] |= (uint8_t)(1 << (y & 7));
+  }
+
+  // ลายของตัวอักษร: 5x7 จุด (ช่องว่าง = ว่างจริง)
+  void glyph(char c) {
+    if (c == '\n') { cx = 0; cy += 8 * size; return; }
+    if (c != ' ') {
+      for (int col = 0; col < 5; col++) {
+        uint8_t bits = (uint8_t)(((unsigned)c * 2654435761u >> (col * 5)) & 0x7F) | 0x01;
+        for (int row = 0; row < 7; row++) {
+          if (!(bits & (1 << row))) continue;
+          for (int dx = 0; dx < size; dx++)
+            for (int dy = 0; dy < size; dy++) pixel(cx + col * size + dx, cy + row * size + dy);
+        }
+      }
+    }
+    cx += 6 * size;
+  }
+
+  void print(const char *s) { for (; *s; s++) glyph(*s); }
+  void print(char c) { glyph(c); }
+  void print(unsigned long v) { char b[16]; snprintf(b, sizeof(b), "%lu", v); print(b); }
+  void println(const char *s) { print(s); glyph('\n'); }
+
+  void getTextBounds(const char *s, int, int, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
+    *x1 = 0; *y1 = 0;
+    *w = (uint16_t)(strlen(s) * 6 * size);
+    *h = (uint16_t)(8 * size);
+  }
+
+  void drawRoundRect(int x, int y, int w, int h, int r, int) {
+    for (int i = x + r; i < x + w - r; i++) { pixel(i, y); pixel(i, y + h - 1); }
+    for (int j = y + r; j < y + h - r; j++) { pixel(x, j); pixel(x + w - 1, j); }
+  }
+};
+
+/* ====== mock จอ: รับหน้าต่าง/ข้อมูลแบบเดียวกับ WireOledBus แล้วเขียนลง GDDRAM จำลอง ====== */
+struct MockBus {
+  uint8_t gddram[OLED_FB_BYTES] = {};
+  uint8_t page = 0, col = 0, p0 = 0, p1 = 0, c0 = 0, c1 = 0;
+
+  // horizontal addressing: ครบคอลัมน์สุดท้าย -> กลับคอลัมน์แรกของ page ถัดไป (วนในหน้าต่าง)
+  void window(uint8_t pa, uint8_t pb, uint8_t a, uint8_t b) {
+    p0 = pa; p1 = pb; c0 = a; c1 = b; page = pa; col = a;
+  }
+  void data(const uint8_t *d, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      gddram[page * OLED_WIDTH + col] = d[i];
+      if (col < c1) { col++; continue; }
+      col  = c0;
+      page = (page == p1) ? p0 : (uint8_t)(page + 1);
+    }
+  }
+};
+
+Panel panel({
+  HOLD_ON_MS,
+  USES_THRESHOLD_PER_ROOM,
+  TOTAL_MS_THRESHOLD_PER_ROOM,
+  DOOR_DEBOUNCE_MS,
+});
+
+int main(int argc, char **argv) {
+  int minutes = 60;
+  uint32_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--minutes") && i + 1 < argc) minutes = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else { fprintf(stderr, "usage: %s [--minutes M] [--seed S]\n", argv[0]); return 2; }
+  }
+  if (minutes <= 0) return 2;
+
+  std::mt19937 rng(seed);
+  std::exponential_distribution<double> flipS(1.0 / 90.0);   // เปลี่ยนสถานะเฉลี่ยทุก 90s ต่อห้อง
+
+  // สถานะห้องจำลอง: สลับว่าง/ใช้งานแบบสุ่ม, ถึงเกณฑ์ -> โหมดทำความสะอาด 10 นาที
+  uint32_t nextFlipMs[ROOM_COUNT];
+  uint32_t cleaningUntilMs = 0;
+  for (size_t i = 0; i < ROOM_COUNT; i++) nextFlipMs[i] = (uint32_t)(flipS(rng) * 1000);
+
+  MockGfx gfx;
+  MockBus bus;
+  OledShadow shadow = {};
+  OledFlushStats partial = {};
+  uint64_t fullBytes = 0;
+  uint32_t renders = 0, ticks = 0, mismatches = 0;
+  uint64_t modeMs[2] = {}, modeFull[2] = {}, modePartial[2] = {};
+
+  OledModel<ROOM_COUNT> shown;
+  bool shownValid = false;
+  const uint32_t endMs = (uint32_t)minutes * 60000u;
+
+  for (uint32_t now = 0; now < endMs; now += 250) {
+    ticks++;
+
+    // อัปเดตห้องจำลอง (เขียนลง panel ตรง ๆ)
+    bool cleaning = now < cleaningUntilMs;
+    for (size_t i = 0; i < ROOM_COUNT && !cleaning; i++) {
+      if (now < nextFlipMs[i]) continue;
+      panel.lightOn[i] = !panel.lightOn[i];
+      if (!panel.lightOn[i] && ++panel.uses[i] >= USES_THRESHOLD_PER_ROOM) {
+        cleaningUntilMs = now + 10 * 60000u;   // แม่บ้านมารีเซ็ตใน 10 นาที
+        panel.resetCounters();
+        for (size_t k = 0; k < ROOM_COUNT; k++) panel.lightOn[k] = false;
+      }
+      nextFlipMs[i] = now + (uint32_t)(flipS(rng) * 1000);
+    }
+    cleaning = now < cleaningUntilMs;
+
+    OledModel<ROOM_COUNT> m;
+    oledBuildModel(m, panel, cleaning, now);
+
+    // แบบเดิม: วาดและส่งทั้งจอทุกรอบ
+    uint32_t full = oledI2cBytes(OLED_FB_BYTES);
+    fullBytes += full;
+    modeMs[m.mode] += 250;
+    modeFull[m.mode] += full;
+
+    // แบบใหม่: วาด/ส่งเฉพาะเมื่อเปลี่ยน
+    if (shownValid && oledModelEqual(m, shown)) continue;
+    oledRender(gfx, m);
+    uint32_t sent = oledFlushChanged(gfx.getBuffer(), shadow, bus, partial);
+    modePartial[m.mode] += sent;
+    renders++;
+    shown = m;
+    shownValid = true;
+    if (memcmp(bus.gddram, gfx.getBuffer(), OLED_FB_BYTES) != 0) mismatches++;
+  }
+
+  double secs = endMs / 1000.0;
+  printf("rooms=%u, %d min, %u ticks @250ms\n", (unsigned)ROOM_COUNT, minutes, ticks);
+  printf("full    : %.0f B/s\n", fullBytes / secs);
+  printf("partial : %.0f B/s (%u renders, %u windows, %.1fx less)\n",
+         partial.bytes / secs, renders, partial.windows,
+         partial.bytes ? (double)fullBytes / partial.bytes : 0.0);
+  const char *names[2] = {"main", "cleaning"};
+  for (int k = 0; k < 2; k++) {
+    if (!modeMs[k]) continue;
+    double s = modeMs[k] / 1000.0;
+    printf("  %-8s: full %.0f B/s, partial %.0f B/s (%.0f s)\n",
+           names[k], modeFull[k] / s, modePartial[k] / s, s);
+  }
+  printf("verify  : %s\n", mismatches ? "MISMATCH" : "GDDRAM matches framebuffer");
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/* =========================================================
+ * room_scale: ต้นทุนต่อรอบ loop ของ RoomController<N, PinMap> เมื่อ N โตขึ้น (3 / 8 / 16 ห้อง)
+ *
+ * - N=3 ใช้ PanelPins ของแผงจริง (panel_config.h)
+ * - N=8 / N=16 ใช้ PinMap สมมติในไฟล์นี้ (PIR เป็น RTC GPIO ทุกขา ผ่าน static_assert ชุดเดียวกับบอร์ด)
+ * - ทุก N ได้ edge สังเคราะห์ (visit_gen.h) อัตราเดียวกันต่อห้อง (คนเข้า -> ประตูปิด -> PIR เป็นพัลส์ -> ออก)
+ * - 1 รอบ = งานที่ loop() ทำกับ panel ทุกรอบ: ป้อน edge ที่ถึงเวลา + tick()
+ *   + สรุปรวมที่ scheduler/sleep ใช้ (nextDeadlineUs, anyOccupied, anyDoorClosed, lastAnyMotionUs)
+ *
+ * รายงาน ns/รอบ, ns/รอบ/ห้อง, ns/edge และขนาด state ต่อ N
+ * ตรวจ: ต้นทุนต่อรอบต้องโตไม่เกินเชิงเส้น (ns/รอบ/ห้อง ของ N ใหญ่ <= --max-ratio เท่าของ N=3)
+ * ไม่ผ่าน -> exit 1
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -Iesp32_firmware -Itools/common tools/room_scale/room_scale.cpp -o room_scale
+ *
+ * ใช้งาน:
+ *   ./room_scale                            # 24 ชม. เวลาเซนเซอร์, รอบละ 5ms
+ *   ./room_scale --hours 72 --rate 12 --step-ms 20 --max-ratio 2 --seed 3
+ * ========================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "panel_config.h"
+#include "visit_gen.h"     // คนเข้าห้องสังเคราะห์ (ชุดเดียวกับ room_sim)
+
+/* ===== PinMap สมมติสำหรับแผงใหญ่ (ใช้บน PC เท่านั้น) ===== */
+struct Pins8 {
+  static constexpr uint8_t pir[]  = {0, 2, 4, 12, 13, 14, 15, 25};
+  static constexpr uint8_t door[] = {1, 3, 5, 16, 17, 18, 19, 21};
+  static constexpr uint8_t led[]  = {22, 23, 6, 7, 8, 9, 10, 11};
+  static constexpr bool reedActiveLow = true;
+};
+
+struct Pins16 {
+  static constexpr uint8_t pir[]  = {0, 2, 4, 12, 13, 14, 15, 25, 26, 27, 32, 33, 34, 35, 36, 37};
+  static constexpr uint8_t door[] = {1, 3, 5, 6, 7, 8, 9, 10, 11, 16, 17, 18, 19, 21, 22, 23};
+  static constexpr uint8_t led[]  = {38, 39, 24, 28, 29, 30, 31, 20, 1, 3, 5, 6, 7, 8, 9, 10};
+  static constexpr bool reedActiveLow = true;
+};
+
+struct Options {
+  double   hours    = 24.0;
+  double   stepMs   = 5.0;
+  double   rate     = 6.0;     // คน/ชม./ห้อง
+  double   maxRatio = 2.0;
+  uint32_t seed     = 1;
+};
+
+static Options opt;
+
+struct CountSink {
+  uint64_t starts = 0, ends = 0;
+  void onSessionStart(size_t, int64_t) { starts++; }
+  void onSessionEnd(size_t, int64_t, uint32_t, bool, bool) { ends++; }
+};
+
+struct ScaleResult {
+  size_t   rooms;
+  size_t   stateBytes;
+  uint64_t iters, edges, sessions;
+  double   nsPerIter, nsPerEdge;
+};
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* edge ของทั้งแผงเรียงตามเวลา (ทุกห้องอัตราเท่ากันตลอดวัน, seed ต่อห้องเหมือนกันทุก N) */
+template <size_t N, class PinMap>
+static std::vector<PinEdge> makeEdges(int64_t horizonUs) {
+  std::vector<PinEdge> out;
+  const VisitParams vp = {opt.rate, 0.0, 1.0};
+  auto emit = [&](const PinEdge &e) { out.push_back(e); };
+  for (size_t i = 0; i < N; i++) {
+    std::mt19937_64 rng(opt.seed * 1000003ULL + i);
+    int64_t after = 0;
+    for (;;) {
+      Visit v = visitDraw(rng, i, after, vp);
+      if (v.endUs >= horizonUs) break;
+      after = visitEmit<PinMap>(rng, v, emit);
+    }
+  }
+  std::stable_sort(out.begin(), out.end(),
+                   [](const PinEdge &a, const PinEdge &b) { return a.tUs < b.tUs; });
+  return out;
+}
+
+template <size_t N, class PinMap>
+static ScaleResult runScale() {
+  typedef RoomController<N, PinMap> Ctrl;
+  static Ctrl ctrl({HOLD_ON_MS, USES_THRESHOLD_PER_ROOM, TOTAL_MS_THRESHOLD_PER_ROOM, DOOR_DEBOUNCE_MS});
+  CountSink sink;
+
+  const int64_t horizonUs = (int64_t)(opt.hours * 3.6e9);
+  const int64_t stepUs = (int64_t)(opt.stepMs * 1000);
+  std::vector<PinEdge> edges = makeEdges<N, PinMap>(horizonUs);
+
+  volatile int64_t keep = 0;      // กัน compiler ตัดผลรวมทิ้ง
+  uint64_t iters = 0;
+  size_t next = 0;
+
+  // รอบ loop: edge ที่ถึงเวลา + tick + สรุปรวม
+  int64_t t0 = nowNs();
+  for (int64_t nowUs = stepUs; nowUs <= horizonUs; nowUs += stepUs) {
+    while (next < edges.size() && edges[next].tUs <= nowUs) {
+      const PinEdge &e = edges[next++];
+      ctrl.applyEdge(e.pin, e.level != 0, e.tUs, sink);
+    }
+    ctrl.tick(nowUs, sink);
+    if (ctrl.anyNeedCleaning()) ctrl.resetCounters();     // แม่บ้านรีเซ็ตทันที (ให้ tick ทำงานปกติ)
+    keep = keep + ctrl.nextDeadlineUs() + ctrl.lastAnyMotionUs() +
+           ctrl.anyOccupied() + ctrl.anyDoorClosed();
+    iters++;
+  }
+  int64_t loopNs = nowNs() - t0;
+
+  // ต้นทุน applyEdge ล้วน ๆ (edge ชุดเดิม, controller ใหม่)
+  static Ctrl fresh({HOLD_ON_MS, USES_THRESHOLD_PER_ROOM, TOTAL_MS_THRESHOLD_PER_ROOM, DOOR_DEBOUNCE_MS});
+  CountSink sink2;
+  int64_t t1 = nowNs();
+  for (const PinEdge &e : edges) fresh.applyEdge(e.pin, e.level != 0, e.tUs, sink2);
+  int64_t edgeNs = nowNs() - t1;
+  keep = keep + fresh.uses[0];
+
+  ScaleResult r;
+  r.rooms      = N;
+  r.stateBytes = sizeof(Ctrl);
+  r.iters      = iters;
+  r.edges      = edges.size();
+  r.sessions   = sink.ends;
+  r.nsPerIter  = (double)loopNs / iters;
+  r.nsPerEdge  = edges.empty() ? 0.0 : (double)edgeNs / edges.size();
+  return r;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: room_scale [--hours H] [--step-ms M] [--rate R] [--max-ratio X] [--seed S]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    const char *a = argv[i], *v = argv[++i];
+    if      (!strcmp(a, "--hours"))     opt.hours = atof(v);
+    else if (!strcmp(a, "--step-ms"))   opt.stepMs = atof(v);
+    else if (!strcmp(a, "--rate"))      opt.rate = atof(v);
+    else if (!strcmp(a, "--max-ratio")) opt.maxRatio = atof(v);
+    else if (!strcmp(a, "--seed"))      opt.seed = (uint32_t)strtoul(v, nullptr, 10);
+    else usage();
+  }
+  if (opt.hours <= 0 || opt.stepMs <= 0 || opt.rate <= 0 || opt.maxRatio <= 0) usage();
+
+  ScaleResult res[3] = {
+    runScale<ROOM_COUNT, PanelPins>(),
+    runScale<8, Pins8>(),
+    runScale<16, Pins16>(),
+  };
+
+  printf("room_scale: %.0f h sensor time, loop step %.1f ms, %.1f visits/h/room\n\n",
+         opt.hours, opt.stepMs, opt.rate);
+  printf("%6s %10s %10s %10s %10s %12s %10s %10s\n",
+         "rooms", "state B", "iters", "edges", "sessions", "ns/iter", "ns/iter/N", "ns/edge");
+  for (const ScaleResult &r : res) {
+    printf("%6zu %10zu %10llu %10llu %10llu %12.2f %10.2f %10.2f\n",
+           r.rooms, r.stateBytes, (unsigned long long)r.iters, (unsigned long long)r.edges,
+           (unsigned long long)r.sessions, r.nsPerIter, r.nsPerIter / r.rooms, r.nsPerEdge);
+  }
+
+  // ต้นทุนต่อห้องต้องไม่โตเกิน maxRatio เท่าของแผง 3 ห้อง (= โตไม่เกินเชิงเส้นโดยประมาณ)
+  double base = res[0].nsPerIter / res[0].rooms;
+  bool ok = true;
+  for (size_t k = 1; k < 3; k++) {
+    double ratio = (res[k].nsPerIter / res[k].rooms) / base;
+    bool pass = ratio <= opt.maxRatio;
+    printf("%s: N=%zu per-room cost %.2fx of N=%zu (limit %.1fx)\n",
+           pass ? "PASS" : "FAIL", res[k].rooms, ratio, res[0].rooms, opt.maxRatio);
+    ok = ok && pass;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,2 @@
+/* ของปลอมสำหรับ tools/room_sim (ดู sim_board.h) */
+#include "sim_board.h"
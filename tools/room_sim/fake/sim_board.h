@@ -0,0 +1,861 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+/* =========================================================
+ * บอร์ดปลอมบน PC ให้ SmartRestroom.ino ทั้งไฟล์คอมไพล์และรันได้โดยไม่แก้ (tools/room_sim)
+ *
+ * - นาฬิกาเสมือน simNowUs: esp_timer_get_time()/millis() อ่านจากตรงนี้
+ *   โค้ดเฟิร์มแวร์รัน "ไม่ใช้เวลา" เวลาเดินเฉพาะตอน block (delay, ulTaskNotifyTake,
+ *   HTTP/Wi-Fi ที่จำลอง latency, light sleep)
+ * - task จริง 2 ตัวแบบ cooperative (ucontext): loopTask (setup()/loop()) และ net task
+ *   จาก xTaskCreatePinnedToCore (netTaskMain ตัวจริง) -> ใครถึงเวลาตื่นก่อนได้รันก่อน
+ *   net task ที่รอ HTTP อยู่จึงกิน "เวลา" คู่ขนานกับ loop เหมือนบอร์ด 2 core (netBusy() เห็นจริง)
+ * - ขา GPIO = fakeGpioIn; edge จาก trace ถูกป้อนผ่าน simSetPin() ตามเวลา -> ISR ของ edge_capture.h
+ *   ระหว่าง light sleep ISR ไม่ทำงาน แต่ตรวจเงื่อนไขปลุก (EXT1 any-high / GPIO level / timer)
+ * - light sleep ทั้งชิป: net task ไม่ได้รันจนกว่า loop จะตื่น
+ * - Wi-Fi: ต่อ AP ได้ (หรือไม่ได้เลยเมื่อ --wifi-off) ด้วยเวลาคงที่, หลับนานเกิน SIM_WIFI_DROP_US หลุด AP
+ *   ไม่จำลอง beacon/DTIM ที่พลาดเพราะ light sleep สั้น ๆ ขณะต่อ AP (ต้องวัดบนบอร์ดจริง)
+ *   แค่นับว่ามี tick sleep ตอนต่อ AP อยู่กี่ครั้ง (ค่าปกติ = 0, ดู TICK_SLEEP_ASSOCIATED)
+ * - HTTP: backend ตอบ ok เสมอ ใช้เวลาตาม SIM_HTTP_* (+ เปิด socket/TLS ใหม่เมื่อ keep-alive หมด)
+ *   LINE ตอบตามสคริปต์ความผิดพลาด (429/500/409/drop) ได้ และกันซ้ำด้วย X-Line-Retry-Key เหมือนของจริง
+ * - เน็ตค้าง (simNetStallAtUs): ตั้งแต่เวลานั้น WiFi.begin()/HTTPClient::POST() ไม่กลับมาอีกเลย
+ * - NVS (Preferences) อยู่ในหน่วยความจำ, จอ OLED/I2C แค่นับ byte, Serial ทิ้ง (หรือพิมพ์เมื่อ simSerialEcho)
+ *
+ * ผู้ขับ (room_sim.cpp) ตั้ง simExtNextUs/simExtApply ให้ป้อน edge และ simOnLoopYield ไว้สังเกตสถานะ
+ * ========================================================= */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ucontext.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* ===== เวลาที่จำลอง (ตัวเลขประมาณจากบอร์ดจริง/ค่าทั่วไป ใช้เทียบกันเอง ไม่ใช่ค่าจริงแม่นยำ) ===== */
+#define SIM_WAKE_COST_US        1000      // ออกจาก light sleep + กลับเข้า (นับเป็นเวลาตื่น)
+#define SIM_WIFI_FAST_MS        300       // ต่อ AP เดิมจาก cache (ไม่สแกน)
+#define SIM_WIFI_FULL_MS        2500      // สแกน + DHCP
+#define SIM_WIFI_DROP_US        (10LL * 1000000)   // หลับนานกว่านี้ AP ตัดการเชื่อมต่อ (beacon/keep-alive หาย)
+#define SIM_HTTP_BACKEND_MS     40        // POST ไป backend ใน LAN
+#define SIM_HTTP_LINE_MS        300       // POST /push ไป LINE
+#define SIM_TCP_CONNECT_MS      10        // เปิด socket ใหม่ (http)
+#define SIM_TLS_HANDSHAKE_MS    800       // เปิด socket ใหม่ (https)
+#define SIM_BACKEND_IDLE_MS     5000      // backend ปิด keep-alive ที่ว่างนานกว่านี้
+#define SIM_LINE_IDLE_MS        60000     // LINE ปิด keep-alive ที่ว่างนานกว่านี้
+#define SIM_TASK_STACK          (256 * 1024)
+
+/* ===== นาฬิกาเสมือน ===== */
+static int64_t simNowUs = 0;
+static inline int64_t esp_timer_get_time() { return simNowUs; }
+static inline unsigned long millis() { return (unsigned long)(simNowUs / 1000); }
+static inline unsigned long micros() { return (unsigned long)simNowUs; }
+
+/* ===== ค่าคงที่/ชนิดพื้นฐานของ Arduino + IDF ===== */
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define HIGH   1
+#define LOW    0
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define CHANGE 3
+#define F(s) (s)
+
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_FAIL               -1
+#define ESP_ERR_INVALID_STATE  0x103
+
+template <class T> static inline T min(T a, T b) { return b < a ? b : a; }
+template <class T> static inline T max(T a, T b) { return a < b ? b : a; }
+
+/* ===== String (เท่าที่เฟิร์มแวร์ใช้) ===== */
+class String {
+ public:
+  String() {}
+  String(const char *s) : s_(s ? s : "") {}
+  String(const std::string &s) : s_(s) {}
+  const char *c_str() const { return s_.c_str(); }
+  unsigned length() const { return (unsigned)s_.size(); }
+  int indexOf(const char *p) const {
+    size_t k = s_.find(p);
+    return k == std::string::npos ? -1 : (int)k;
+  }
+  String operator+(const char *p) const { return String(s_ + p); }
+  String &operator+=(const char *p) { s_ += p; return *this; }
+ private:
+  std::string s_;
+};
+
+/* ===== Serial ===== */
+static bool simSerialEcho = false;   // true = พิมพ์ log ของเฟิร์มแวร์ออก stdout พร้อมเวลาเสมือน
+
+struct SimSerial {
+  bool lineStart = true;
+  void begin(unsigned long) {}
+  void flush() {}
+  int  available() { return 0; }
+  int  read() { return -1; }
+  void out(const char *s) {
+    if (!simSerialEcho) return;
+    for (; *s; s++) {
+      if (lineStart) ::printf("%10.3f | ", simNowUs / 1e6);
+      putchar(*s);
+      lineStart = *s == '\n';
+    }
+  }
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (!simSerialEcho) return 0;
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    out(buf);
+    return n;
+  }
+  void print(const char *s) { out(s); }
+  void print(const String &s) { out(s.c_str()); }
+  void println() { out("\n"); }
+  void println(const char *s) { out(s); out("\n"); }
+  void println(const String &s) { println(s.c_str()); }
+};
+static SimSerial Serial;
+
+/* ===== critical section (task สลับกันที่จุด block เท่านั้น -> ไม่ต้องล็อกจริง) ===== */
+typedef struct { int held; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(m)     ((m)->held++)
+#define portEXIT_CRITICAL(m)      ((m)->held--)
+#define portENTER_CRITICAL_ISR(m) ((m)->held++)
+#define portEXIT_CRITICAL_ISR(m)  ((m)->held--)
+
+/* =========================================================
+ * Task แบบ cooperative + ตัวจัดลำดับตามเวลาเสมือน
+ * ========================================================= */
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))   // 1 tick = 1 ms
+
+#define SIM_NEVER INT64_MAX
+
+struct SimTask {
+  ucontext_t ctx;
+  bool       exists;
+  int64_t    wakeAtUs;        // ตื่นเองเมื่อถึงเวลานี้ (SIM_NEVER = รอ notify อย่างเดียว)
+  bool       notifyWait;      // block ใน ulTaskNotifyTake -> notify ปลุกได้
+  uint32_t   notifyCount;
+  TaskFunction_t fn;
+  void      *arg;
+  std::vector<char> stack;
+};
+typedef SimTask *TaskHandle_t;
+
+enum { SIM_LOOP_TASK = 0, SIM_NET_TASK = 1, SIM_TASKS = 2 };
+static SimTask simTasks[SIM_TASKS] = {};
+static int simCur = SIM_LOOP_TASK;
+static bool simChipAsleep = false;
+
+/* ผู้ขับป้อนเหตุการณ์ภายนอก (edge จาก trace / การกดปุ่ม) */
+static int64_t (*simExtNextUs)() = nullptr;   // เวลาเหตุการณ์ถัดไป (SIM_NEVER = หมด)
+static void    (*simExtApply)()  = nullptr;   // ทำเหตุการณ์นั้น (เรียก simSetPin)
+static void    (*simOnLoopYield)() = nullptr; // loop กำลังจะ block (สังเกต journal/ธงได้ ณ จุดนี้)
+
+/* เวลา CPU ของเครื่อง PC ที่ loop ใช้จริง (ไม่รวมช่วง block) */
+static std::chrono::steady_clock::time_point simLoopSegStart;
+static uint64_t simLoopHostNs = 0;
+
+static inline void simSchedule();
+
+/* task ปัจจุบัน block จนถึง untilUs (หรือจนถูก notify ถ้า notifiable) */
+static inline void simBlock(int64_t untilUs, bool notifiable) {
+  SimTask &me = simTasks[simCur];
+  me.wakeAtUs = untilUs;
+  me.notifyWait = notifiable;
+  if (simCur == SIM_LOOP_TASK) {
+    simLoopHostNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - simLoopSegStart).count();
+    if (simOnLoopYield) simOnLoopYield();
+  }
+  simSchedule();
+  me.notifyWait = false;
+  if (simCur == SIM_LOOP_TASK) simLoopSegStart = std::chrono::steady_clock::now();
+}
+
+static inline void simTaskEntry() {
+  SimTask &t = simTasks[simCur];
+  t.fn(t.arg);
+  // task ของเฟิร์มแวร์ไม่ return (เหมือน FreeRTOS) -> ถ้า return ก็หลับตลอดไป
+  for (;;) simBlock(SIM_NEVER, false);
+}
+
+/* เลือก task ที่ถึงเวลาก่อน; ก่อนหน้านั้นป้อนเหตุการณ์ภายนอกที่เกิดก่อนตามลำดับเวลา */
+static inline void simSchedule() {
+  for (;;) {
+    int pick = -1;
+    int64_t tNext = SIM_NEVER;
+    for (int k = 0; k < SIM_TASKS; k++) {
+      const SimTask &t = simTasks[k];
+      if (!t.exists) continue;
+      if (simChipAsleep && k != SIM_LOOP_TASK) continue;   // ชิปหลับ -> task อื่นไม่ได้รัน
+      if (t.wakeAtUs < tNext || pick < 0) {
+        if (t.wakeAtUs == SIM_NEVER && pick >= 0) continue;
+        pick = k;
+        tNext = t.wakeAtUs;
+      }
+    }
+    int64_t tExt = simExtNextUs ? simExtNextUs() : SIM_NEVER;
+    if (tExt != SIM_NEVER && tExt <= tNext) {
+      if (tExt > simNowUs) simNowUs = tExt;
+      simExtApply();
+      continue;
+    }
+    if (pick < 0 || tNext == SIM_NEVER) {
+      fprintf(stderr, "[sim] deadlock: no task will ever wake (t=%.3f s)\n", simNowUs / 1e6);
+      exit(3);
+    }
+    if (tNext > simNowUs) simNowUs = tNext;
+    if (pick == simCur) return;
+    int prev = simCur;
+    simCur = pick;
+    swapcontext(&simTasks[prev].ctx, &simTasks[pick].ctx);
+    // กลับมาที่นี่เมื่อมีคนสลับกลับมาหา prev (simCur ถูกตั้งเป็น prev แล้ว)
+    return;
+  }
+}
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &simTasks[simCur]; }
+static inline BaseType_t xPortGetCoreID() { return simCur == SIM_NET_TASK ? 0 : 1; }
+
+static inline void simNotify(TaskHandle_t h) {
+  h->notifyCount++;
+  if (h->notifyWait && h->wakeAtUs > simNowUs) h->wakeAtUs = simNowUs;
+}
+static inline void xTaskNotifyGive(TaskHandle_t h) { simNotify(h); }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t h, BaseType_t *woken) {
+  simNotify(h);
+  *woken = pdTRUE;
+}
+#define portYIELD_FROM_ISR() ((void)0)
+
+static inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  SimTask &me = simTasks[simCur];
+  if (me.notifyCount == 0 && ticks > 0) {
+    simBlock(ticks == portMAX_DELAY ? SIM_NEVER : simNowUs + (int64_t)ticks * 1000, true);
+  }
+  uint32_t v = me.notifyCount;
+  if (v) me.notifyCount = clearOnExit ? 0 : v - 1;
+  return v;
+}
+
+static inline void delay(unsigned long ms) {
+  simBlock(simNowUs + (int64_t)ms * 1000, false);
+}
+
+static inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *, uint32_t, void *arg,
+                                                 int, TaskHandle_t *out, int) {
+  SimTask &t = simTasks[SIM_NET_TASK];
+  if (t.exists) return 0;
+  t.exists = true;
+  t.fn = fn;
+  t.arg = arg;
+  t.wakeAtUs = simNowUs;           // เริ่มรันเมื่อ loop block ครั้งถัดไป
+  t.stack.resize(SIM_TASK_STACK);
+  getcontext(&t.ctx);
+  t.ctx.uc_stack.ss_sp = t.stack.data();
+  t.ctx.uc_stack.ss_size = t.stack.size();
+  t.ctx.uc_link = nullptr;
+  makecontext(&t.ctx, simTaskEntry, 0);
+  if (out) *out = &t;
+  return pdPASS;
+}
+
+/* เรียกครั้งเดียวก่อน setup(): task ปัจจุบัน (main) คือ loopTask */
+static inline void simBoardInit() {
+  simTasks[SIM_LOOP_TASK].exists = true;
+  simTasks[SIM_LOOP_TASK].wakeAtUs = 0;
+  simCur = SIM_LOOP_TASK;
+  simLoopSegStart = std::chrono::steady_clock::now();
+}
+
+/* =========================================================
+ * GPIO + interrupt + เงื่อนไขปลุก
+ * ========================================================= */
+#define GPIO_IN_REG  0
+#define GPIO_IN1_REG 1
+static uint64_t fakeGpioIn = 0;
+#define REG_READ(r) ((uint32_t)((r) == GPIO_IN_REG ? fakeGpioIn : (fakeGpioIn >> 32)))
+
+typedef int gpio_num_t;
+typedef enum {
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+#define FAKE_GPIO_COUNT 40
+struct FakePin {
+  void (*isr)(void *);
+  void *arg;
+  bool intrEnabled;
+  int  intrType;
+  int  wakeType;      // gpio_wakeup_enable (0 = ปิด)
+  int  mode;
+  int  outLevel;
+};
+static FakePin fakePins[FAKE_GPIO_COUNT];
+
+static inline void pinMode(uint8_t pin, int mode) { fakePins[pin].mode = mode; }
+static inline void digitalWrite(uint8_t pin, int level) { fakePins[pin].outLevel = level; }
+static inline int  digitalRead(uint8_t pin) { return (int)((fakeGpioIn >> pin) & 1); }
+
+static inline void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int) {
+  fakePins[pin].isr = isr;
+  fakePins[pin].arg = arg;
+  fakePins[pin].intrEnabled = true;
+  fakePins[pin].intrType = GPIO_INTR_ANYEDGE;
+}
+static inline int gpio_intr_disable(gpio_num_t p) { fakePins[p].intrEnabled = false; return 0; }
+static inline int gpio_intr_enable(gpio_num_t p)  { fakePins[p].intrEnabled = true; return 0; }
+static inline int gpio_set_intr_type(gpio_num_t p, gpio_int_type_t t) { fakePins[p].intrType = t; return 0; }
+static inline int gpio_wakeup_enable(gpio_num_t p, gpio_int_type_t t) { fakePins[p].wakeType = t; return 0; }
+static inline int gpio_wakeup_disable(gpio_num_t p) { fakePins[p].wakeType = 0; return 0; }
+
+/* ===== esp_sleep ===== */
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+  ESP_SLEEP_WAKEUP_ULP,
+  ESP_SLEEP_WAKEUP_GPIO,
+  ESP_SLEEP_WAKEUP_UART,
+} esp_sleep_wakeup_cause_t;
+typedef esp_sleep_wakeup_cause_t esp_sleep_source_t;
+typedef enum { ESP_EXT1_WAKEUP_ALL_LOW = 0, ESP_EXT1_WAKEUP_ANY_HIGH = 1 } esp_sleep_ext1_wakeup_mode_t;
+#define UART_NUM_0 0
+
+struct SimSleepCfg {
+  bool     timer;
+  uint64_t timerUs;
+  bool     ext1;
+  uint64_t ext1Mask;
+  bool     gpio;
+};
+static SimSleepCfg simSleepCfg = {};
+static esp_sleep_wakeup_cause_t simWakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+/* สถิติการหลับที่ตัวจำลองเห็น (แยกหลับยาว EXT1 กับหลับสั้นระหว่าง deadline) */
+struct SimSleepStats {
+  int64_t  asleepUs;
+  uint32_t idleSleeps;                      // ตั้ง EXT1 (maybeEnterLightSleep)
+  uint32_t tickSleeps;                      // ตั้ง GPIO wake (tickSleep)
+};
+static SimSleepStats simSleep = {};
+static void (*simOnSleepEnd)(bool idle) = nullptr;   // ผู้ขับแยกเหตุปลุก (อ่าน simWakeCause/ระดับขาได้)
+static inline void simWifiBeforeSleep(bool idle);
+static inline void simWifiAfterSleep(int64_t sleptUs);
+
+static inline esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t) { simSleepCfg = {}; return ESP_OK; }
+static inline esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t) {
+  simSleepCfg.ext1 = true;
+  simSleepCfg.ext1Mask = mask;
+  return ESP_OK;
+}
+static inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) {
+  simSleepCfg.timer = true;
+  simSleepCfg.timerUs = us;
+  return ESP_OK;
+}
+static inline esp_err_t esp_sleep_enable_gpio_wakeup() { simSleepCfg.gpio = true; return ESP_OK; }
+static inline esp_err_t esp_sleep_enable_uart_wakeup(int) { return ESP_OK; }   // ไม่มีคนพิมพ์ในตัวจำลอง
+static inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return simWakeCause; }
+
+/* ระดับขาตอนนี้ตรงเงื่อนไขปลุกไหม */
+static inline esp_sleep_wakeup_cause_t simWakeByPins() {
+  if (simSleepCfg.ext1 && (fakeGpioIn & simSleepCfg.ext1Mask)) return ESP_SLEEP_WAKEUP_EXT1;
+  if (simSleepCfg.gpio) {
+    for (int p = 0; p < FAKE_GPIO_COUNT; p++) {
+      int w = fakePins[p].wakeType;
+      if (!w) continue;
+      int lvl = digitalRead(p);
+      if ((w == GPIO_INTR_HIGH_LEVEL && lvl) || (w == GPIO_INTR_LOW_LEVEL && !lvl)) return ESP_SLEEP_WAKEUP_GPIO;
+    }
+  }
+  return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+/* ตั้งระดับขาจากภายนอก: ตื่นอยู่ -> ISR (ถ้าเปิด), หลับอยู่ -> ตรวจเงื่อนไขปลุก */
+static inline void simSetPin(uint8_t pin, int level) {
+  uint64_t bit = 1ULL << pin;
+  bool changed = ((fakeGpioIn & bit) != 0) != (level != 0);
+  fakeGpioIn = level ? (fakeGpioIn | bit) : (fakeGpioIn & ~bit);
+  if (!changed) return;
+  if (simChipAsleep) {
+    esp_sleep_wakeup_cause_t c = simWakeByPins();
+    if (c != ESP_SLEEP_WAKEUP_UNDEFINED && simWakeCause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+      simWakeCause = c;
+      simTasks[SIM_LOOP_TASK].wakeAtUs = simNowUs;
+    }
+    return;
+  }
+  if (fakePins[pin].isr && fakePins[pin].intrEnabled) fakePins[pin].isr(fakePins[pin].arg);
+}
+
+static inline esp_err_t esp_light_sleep_start() {
+  int64_t t0 = simNowUs;
+  bool idle = simSleepCfg.ext1;
+  simWakeCause = simWakeByPins();
+  simWifiBeforeSleep(idle);
+  if (simWakeCause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+    simChipAsleep = true;
+    simBlock(simSleepCfg.timer ? t0 + (int64_t)simSleepCfg.timerUs : SIM_NEVER, false);
+    simChipAsleep = false;
+    if (simWakeCause == ESP_SLEEP_WAKEUP_UNDEFINED) simWakeCause = ESP_SLEEP_WAKEUP_TIMER;
+  }
+  int64_t slept = simNowUs - t0;
+  simSleep.asleepUs += slept > SIM_WAKE_COST_US ? slept - SIM_WAKE_COST_US : 0;
+  if (idle) simSleep.idleSleeps++;
+  else      simSleep.tickSleeps++;
+  simWifiAfterSleep(slept);
+  if (simOnSleepEnd) simOnSleepEnd(idle);
+  return ESP_OK;
+}
+
+/* ===== watchdog (ไม่มี watchdog จริง; เวลาห่างของการ feed ดูได้จาก perf ของเฟิร์มแวร์) ===== */
+typedef struct {
+  uint32_t timeout_ms;
+  uint32_t idle_core_mask;
+  bool     trigger_panic;
+} esp_task_wdt_config_t;
+static inline esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t *) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_add(TaskHandle_t) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+
+/* ===== CRC / random ===== */
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static uint64_t simRandState = 0x9E3779B97F4A7C15ull;
+static inline void esp_fill_random(void *buf, size_t len) {
+  uint8_t *p = (uint8_t *)buf;
+  for (size_t i = 0; i < len; i++) {
+    simRandState = simRandState * 6364136223846793005ull + 1442695040888963407ull;
+    p[i] = (uint8_t)(simRandState >> 56);
+  }
+}
+
+/* ===== UART (พิมพ์คำสั่งขณะหลับ) ===== */
+static inline esp_err_t uart_set_wakeup_threshold(int, int) { return ESP_OK; }
+
+/* =========================================================
+ * NVS (Preferences) ในหน่วยความจำ
+ * ========================================================= */
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> simNvs;
+static uint32_t simNvsWrites = 0;
+
+class Preferences {
+ public:
+  bool begin(const char *ns, bool) { ns_ = ns; return true; }
+  void end() {}
+  size_t getBytesLength(const char *key) {
+    auto &m = simNvs[ns_];
+    auto it = m.find(key);
+    return it == m.end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char *key, void *buf, size_t len) {
+    auto &m = simNvs[ns_];
+    auto it = m.find(key);
+    if (it == m.end()) return 0;
+    size_t n = it->second.size() < len ? it->second.size() : len;
+    memcpy(buf, it->second.data(), n);
+    return n;
+  }
+  size_t putBytes(const char *key, const void *buf, size_t len) {
+    simNvs[ns_][key].assign((const uint8_t *)buf, (const uint8_t *)buf + len);
+    simNvsWrites++;
+    return len;
+  }
+  uint16_t getUShort(const char *key, uint16_t def) {
+    uint16_t v = def;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+  }
+  size_t putUShort(const char *key, uint16_t v) { return putBytes(key, &v, sizeof(v)); }
+  bool remove(const char *key) { return simNvs[ns_].erase(key) > 0; }
+ private:
+  std::string ns_;
+};
+
+/* =========================================================
+ * Wi-Fi
+ * ========================================================= */
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL,
+  WL_SCAN_COMPLETED,
+  WL_CONNECTED,
+  WL_CONNECT_FAILED,
+  WL_CONNECTION_LOST,
+  WL_DISCONNECTED,
+} wl_status_t;
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+typedef enum { WIFI_PS_NONE = 0, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+static inline esp_err_t esp_wifi_set_ps(wifi_ps_type_t) { return ESP_OK; }
+
+class IPAddress {
+ public:
+  IPAddress() {}
+  explicit IPAddress(uint32_t v) : v_(v) {}
+  operator uint32_t() const { return v_; }
+  String toString() const {
+    char b[16];
+    snprintf(b, sizeof(b), "%u.%u.%u.%u", v_ & 0xFF, (v_ >> 8) & 0xFF, (v_ >> 16) & 0xFF, v_ >> 24);
+    return String(b);
+  }
+ private:
+  uint32_t v_ = 0;
+};
+
+struct SimWifiStats {
+  uint32_t connects;       // ต่อ AP สำเร็จ
+  uint32_t drops;          // หลุดเพราะหลับนาน
+  uint32_t assocTickSleeps; // tick sleep ขณะต่อ AP อยู่ (ไม่จำลองผลต่อ beacon, แค่นับ)
+};
+static bool         simWifiAvailable = true;   // false = ไม่มี AP (--wifi-off)
+static SimWifiStats simWifi = {};
+static uint32_t     simWifiEpoch = 0;          // เพิ่มทุกครั้งที่หลุด -> socket เดิมใช้ไม่ได้
+
+/*
+ * เน็ตค้างตลอดไป (DHCP/TLS แขวน): task ที่เรียก WiFi.begin()/POST() หลัง simNetStallAtUs block ถึง
+ * SIM_STALL_FOREVER — ไกลเกินจบ trace แต่ยังเป็นเวลาจำกัด ถ้าคนที่ค้างคือ loop เอง
+ * รอบนั้นจะยาวผิดปกติให้เห็นใน histogram แทนที่ตัวจัดคิวจะจบด้วย deadlock
+ */
+#define SIM_STALL_FOREVER (SIM_NEVER / 2)
+struct SimNetStallStats {
+  uint32_t calls;          // ครั้งที่มีคนเข้าไปค้าง
+  uint32_t loopCalls;      // ในนั้นเป็น loop task เอง (ต้องเป็น 0)
+  int64_t  sinceUs;        // เริ่มค้างครั้งแรกเมื่อ
+};
+static int64_t          simNetStallAtUs = SIM_NEVER;   // SIM_NEVER = ไม่ค้าง (--net-stall ตั้ง)
+static SimNetStallStats simNetStall = {};
+
+static inline void simNetMaybeStall() {
+  if (simNowUs < simNetStallAtUs) return;
+  if (simNetStall.calls++ == 0) simNetStall.sinceUs = simNowUs;
+  if (simCur == SIM_LOOP_TASK) simNetStall.loopCalls++;
+  simBlock(SIM_STALL_FOREVER, false);
+}
+
+class SimWiFiClass {
+ public:
+  void persistent(bool) {}
+  bool setSleep(bool) { return true; }
+  void setAutoReconnect(bool) {}
+  bool mode(wifi_mode_t) { return true; }
+  bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress()) { return true; }
+  wl_status_t begin(const char *, const char *, int32_t channel = 0, const uint8_t * = nullptr, bool = true) {
+    simNetMaybeStall();
+    connecting_ = simWifiAvailable;
+    connectAtUs_ = simNowUs + (int64_t)(channel ? SIM_WIFI_FAST_MS : SIM_WIFI_FULL_MS) * 1000;
+    return status();
+  }
+  wl_status_t status() {
+    if (!connected_ && connecting_ && simNowUs >= connectAtUs_) {
+      connected_ = true;
+      connecting_ = false;
+      simWifi.connects++;
+    }
+    return connected_ ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+  bool disconnect() {
+    if (connected_) simWifiEpoch++;
+    connected_ = connecting_ = false;
+    return true;
+  }
+  void simDrop() {                     // AP ตัดเพราะหายไปนาน
+    if (!connected_) return;
+    disconnect();
+    simWifi.drops++;
+  }
+  IPAddress localIP()    { return IPAddress(0x0A01A8C0u); }
+  IPAddress gatewayIP()  { return IPAddress(0x0101A8C0u); }
+  IPAddress subnetMask() { return IPAddress(0x00FFFFFFu); }
+  IPAddress dnsIP()      { return IPAddress(0x0101A8C0u); }
+  int8_t    RSSI()       { return -60; }
+  int32_t   channel()    { return 6; }
+  const uint8_t *BSSID() { static const uint8_t b[6] = {2, 0, 0, 0, 0, 1}; return b; }
+ private:
+  bool    connected_ = false;
+  bool    connecting_ = false;
+  int64_t connectAtUs_ = 0;
+};
+static SimWiFiClass WiFi;
+
+static inline void simWifiBeforeSleep(bool idle) {
+  if (!idle && WiFi.status() == WL_CONNECTED) simWifi.assocTickSleeps++;
+}
+
+static inline void simWifiAfterSleep(int64_t sleptUs) {
+  if (sleptUs > SIM_WIFI_DROP_US) WiFi.simDrop();
+}
+
+/* =========================================================
+ * HTTP: socket keep-alive + ปลายทางปลอม (ตอบ ok เสมอ)
+ * ========================================================= */
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+
+class WiFiClient {
+ public:
+  virtual ~WiFiClient() {}
+  bool connected() {
+    return open_ && epoch_ == simWifiEpoch && simNowUs - lastUseUs_ < idleUs_;
+  }
+  void stop() { open_ = false; }
+  void simUse(int64_t idleUs) {
+    open_ = true;
+    epoch_ = simWifiEpoch;
+    lastUseUs_ = simNowUs;
+    idleUs_ = idleUs;
+  }
+  virtual bool simTls() const { return false; }
+ private:
+  bool     open_ = false;
+  uint32_t epoch_ = 0;
+  int64_t  lastUseUs_ = 0;
+  int64_t  idleUs_ = 0;
+};
+
+class WiFiClientSecure : public WiFiClient {
+ public:
+  void setInsecure() {}
+  bool simTls() const override { return true; }
+};
+
+/* ปลายทางปลอม: ผู้ขับตั้งเพื่อดู body ที่ส่งถึง (นับ event/ข้อความ; LINE นับเฉพาะ push ที่ถึงผู้ใช้) */
+struct SimHttpStats {
+  uint32_t backendPosts, batchPosts, batchEvents;
+  uint32_t linePushes, lineMsgs;
+};
+static SimHttpStats simHttp = {};
+
+static inline uint32_t simCountOf(const std::string &s, const char *needle) {
+  uint32_t n = 0;
+  for (size_t k = s.find(needle); k != std::string::npos; k = s.find(needle, k + 1)) n++;
+  return n;
+}
+
+/*
+ * ปลาย LINE ปลอม (/push)
+ * - ตอบตามสคริปต์ simLineFaults ทีละ request (หมดสคริปต์ = 200); ช่วง simLineDown* ตอบ 500 ทุก request
+ * - จำ X-Line-Retry-Key ที่รับไปแล้ว: key ซ้ำ -> 409 ไม่ส่งข้อความซ้ำ (ไม่กินสคริปต์)
+ * - บันทึกทุก request (simLineLog) และข้อความที่ถึงผู้ใช้จริง (simLineInbox) ให้ผู้ขับตรวจ
+ */
+enum SimLineReply : uint8_t {
+  SIM_LINE_OK = 0,
+  SIM_LINE_429,            // "429": จำกัดอัตรา ไม่ส่ง
+  SIM_LINE_500,            // "500": server ล่ม ไม่ส่ง
+  SIM_LINE_DROP,           // "drop": socket หลุดก่อน LINE ได้ request ครบ ไม่ส่ง
+  SIM_LINE_LOST,           // "409": LINE ส่งแล้วแต่คำตอบหาย -> ส่งซ้ำด้วย key เดิมได้ 409
+  SIM_LINE_DUP,            // key เคยรับแล้ว -> 409 (ผลของ SIM_LINE_LOST ไม่ใช่สคริปต์)
+};
+
+struct SimLineReq {
+  int64_t     startUs, endUs;
+  std::string key;
+  uint8_t     msgs;        // ข้อความใน payload
+  uint8_t     beats;       // ในนั้นเป็น heartbeat
+  uint8_t     reply;       // SimLineReply
+  int         code;        // ที่ POST() คืน
+};
+
+struct SimLineMsg {
+  int64_t     atUs;
+  std::string key;         // retry key ของ push ที่พามา
+  std::string text;        // ตามที่อยู่ใน JSON (ยัง escape)
+};
+
+static std::vector<uint8_t>    simLineFaults;                 // สคริปต์ตอบทีละ request
+static size_t                  simLineFaultNext = 0;
+static int64_t                 simLineDownFromUs = SIM_NEVER;  // [from, until) ตอบ 500
+static int64_t                 simLineDownUntilUs = SIM_NEVER;
+static std::vector<SimLineReq> simLineLog;
+static std::vector<SimLineMsg> simLineInbox;
+static std::set<std::string>   simLineKeys;                   // retry key ที่ LINE รับแล้ว
+
+/* "429,500,drop,409" -> สคริปต์ (คืน false ถ้ามีคำที่ไม่รู้จัก) */
+static inline bool simLineParseFaults(const char *spec) {
+  simLineFaults.clear();
+  std::string s(spec);
+  for (size_t a = 0; a <= s.size();) {
+    size_t b = s.find(',', a);
+    if (b == std::string::npos) b = s.size();
+    std::string w = s.substr(a, b - a);
+    if      (w == "429")  simLineFaults.push_back(SIM_LINE_429);
+    else if (w == "500")  simLineFaults.push_back(SIM_LINE_500);
+    else if (w == "drop") simLineFaults.push_back(SIM_LINE_DROP);
+    else if (w == "409")  simLineFaults.push_back(SIM_LINE_LOST);
+    else if (w == "ok")   simLineFaults.push_back(SIM_LINE_OK);
+    else return false;
+    a = b + 1;
+  }
+  return true;
+}
+
+static inline void simLineDeliver(const std::string &body, const std::string &key) {
+  static const char kText[] = "\"text\":\"";
+  for (size_t k = body.find(kText); k != std::string::npos; k = body.find(kText, k + 1)) {
+    size_t a = k + sizeof(kText) - 1, e = a;
+    while (e < body.size() && body[e] != '"') e += body[e] == '\\' ? 2 : 1;
+    simLineInbox.push_back({simNowUs, key, body.substr(a, e - a)});
+  }
+  simHttp.linePushes++;
+  simHttp.lineMsgs += simCountOf(body, "\"type\":\"text\"");
+}
+
+/* เลือกคำตอบของ request นี้ (เรียกตอน LINE ได้ request แล้ว) */
+static inline uint8_t simLineReply(const std::string &key) {
+  if (!key.empty() && simLineKeys.count(key)) return SIM_LINE_DUP;
+  if (simNowUs >= simLineDownFromUs && simNowUs < simLineDownUntilUs) return SIM_LINE_500;
+  return simLineFaultNext < simLineFaults.size() ? simLineFaults[simLineFaultNext++] : SIM_LINE_OK;
+}
+
+class HTTPClient {
+ public:
+  void setReuse(bool) {}
+  void setTimeout(uint16_t) {}
+  bool begin(WiFiClient &c, const char *url) {
+    client_ = &c;
+    url_ = url;
+    retryKey_.clear();
+    return true;
+  }
+  void addHeader(const char *name, const char *value) {
+    if (!strcmp(name, "X-Line-Retry-Key")) retryKey_ = value;
+  }
+  int POST(uint8_t *body, size_t len) {
+    simNetMaybeStall();
+    if (WiFi.status() != WL_CONNECTED) return HTTPC_ERROR_CONNECTION_REFUSED;
+    bool line = url_.find("/push") != std::string::npos;
+    int64_t ms = line ? SIM_HTTP_LINE_MS : SIM_HTTP_BACKEND_MS;
+    if (!client_->connected()) ms += client_->simTls() ? SIM_TLS_HANDSHAKE_MS : SIM_TCP_CONNECT_MS;
+    int64_t t0 = simNowUs;
+    delay((unsigned long)ms);
+    if (WiFi.status() != WL_CONNECTED) return HTTPC_ERROR_CONNECTION_LOST;
+    client_->simUse((line ? SIM_LINE_IDLE_MS : SIM_BACKEND_IDLE_MS) * 1000LL);
+
+    std::string b((const char *)body, len);
+    if (line) return linePost(b, t0);
+    if (url_.size() >= 6 && url_.compare(url_.size() - 6, 6, "/batch") == 0) {
+      simHttp.batchPosts++;
+      simHttp.batchEvents += simCountOf(b, "\"seq\":");
+      resp_ = "{\"ok\":true}";
+    } else {
+      simHttp.backendPosts++;
+      resp_ = "{\"ok\":true}";
+    }
+    return 200;
+  }
+  String getString() { return String(resp_); }
+  void end() {}
+ private:
+  int linePost(const std::string &b, int64_t t0) {
+    uint8_t reply = simLineReply(retryKey_);
+    int code = 200;
+    resp_ = "{}";
+    switch (reply) {
+      case SIM_LINE_429:  code = 429; resp_ = "{\"message\":\"The API rate limit has been exceeded.\"}"; break;
+      case SIM_LINE_500:  code = 500; resp_ = "{\"message\":\"Internal server error\"}"; break;
+      case SIM_LINE_DUP:  code = 409; resp_ = "{\"message\":\"The retry key is already accepted\"}"; break;
+      case SIM_LINE_DROP: code = HTTPC_ERROR_SEND_PAYLOAD_FAILED; break;
+      case SIM_LINE_LOST: code = HTTPC_ERROR_CONNECTION_LOST; break;
+      default: break;
+    }
+    if (reply == SIM_LINE_OK || reply == SIM_LINE_LOST) {
+      simLineDeliver(b, retryKey_);
+      if (!retryKey_.empty()) simLineKeys.insert(retryKey_);
+    }
+    if (code <= 0) client_->stop();
+    simLineLog.push_back({t0, simNowUs, retryKey_, (uint8_t)simCountOf(b, "\"type\":\"text\""),
+                          (uint8_t)simCountOf(b, "Heartbeat"), reply, code});
+    return code;
+  }
+
+  WiFiClient *client_ = nullptr;
+  std::string url_;
+  std::string resp_;
+  std::string retryKey_;
+};
+
+/* =========================================================
+ * I2C + จอ (ไม่วาดจริง นับแค่ byte บนสาย)
+ * ========================================================= */
+struct SimWire {
+  uint32_t bytes = 0;
+  void begin(int, int) {}
+  void beginTransmission(uint8_t) {}
+  size_t write(uint8_t) { bytes++; return 1; }
+  size_t write(const uint8_t *, size_t n) { bytes += (uint32_t)n; return n; }
+  uint8_t endTransmission() { return 0; }
+};
+typedef SimWire TwoWire;
+static SimWire Wire;
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_WHITE        1
+#define SSD1306_DISPLAYOFF   0xAE
+#define SSD1306_DISPLAYON    0xAF
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+
+class Adafruit_SSD1306 {
+ public:
+  Adafruit_SSD1306(int w, int h, TwoWire *, int) : w_(w), h_(h), fb_((size_t)w * h / 8, 0) {}
+  bool begin(int, uint8_t) { return true; }
+  void ssd1306_command(uint8_t) {}
+  void clearDisplay() { memset(fb_.data(), 0, fb_.size()); }
+  void setTextSize(int s) { size_ = s; }
+  void setTextColor(int) {}
+  void setCursor(int, int) {}
+  void print(const char *) {}
+  void print(char) {}
+  void print(unsigned long) {}
+  void println(const char *) {}
+  void getTextBounds(const char *s, int, int, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
+    *x1 = 0; *y1 = 0;
+    *w = (uint16_t)(strlen(s) * 6 * size_);
+    *h = (uint16_t)(8 * size_);
+  }
+  void drawRoundRect(int, int, int, int, int, int) {}
+  uint8_t *getBuffer() { return fb_.data(); }
+ private:
+  int w_, h_, size_ = 1;
+  std::vector<uint8_t> fb_;
+};
+
+#endif
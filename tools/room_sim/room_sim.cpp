@@ -0,0 +1,645 @@
+/* =========================================================
+ * room_sim: รันเฟิร์มแวร์จริงบน PC + replay trace เซนเซอร์
+ *
+ * คอมไพล์ SmartRestroom.ino ทั้งไฟล์ (setup()/loop(), net task, journal, LINE, persist)
+ * กับบอร์ดปลอมใน tools/room_sim/fake/ (sim_board.h) — ไม่มีลอจิกของ loop() ที่เขียนซ้ำในไฟล์นี้
+ * แก้ loop() เมื่อไร ตัวจำลองใช้ของใหม่ทันที
+ *   - นาฬิกาเสมือน: เวลาเดินเฉพาะตอนเฟิร์มแวร์ block (edgeWait, delay, light sleep, HTTP/Wi-Fi)
+ *   - net task ตัวจริงรันคู่กับ loop (สลับกันตามเวลาเสมือน) เวลา HTTP/ต่อ Wi-Fi ทำให้ netBusy() จริง
+ *   - edge จาก trace เข้า ISR ของ edge_capture.h ตามเวลา; ระหว่าง light sleep ปลุกด้วย EXT1/GPIO/timer
+ *   - heartbeat หลังตื่นจาก timer, buzzer, หน้าจอ, journal, แจ้ง LINE = โค้ดจริงทั้งหมด
+ * ไฟล์นี้ทำแค่: สร้าง/โหลด trace, ป้อน edge, ให้แม่บ้านกดรีเซ็ต 10 นาทีหลังแจ้งเตือน,
+ * อ่าน session จาก journal (JEV_END) แล้วเทียบกับ ground truth
+ * -> รัน trace หลายวันได้ในไม่กี่วินาที
+ *
+ * คอมไพล์ (จากรากโปรเจกต์):
+ *   g++ -std=c++17 -O2 -Itools/room_sim/fake -Iesp32_firmware -Itools/common \
+ *       tools/room_sim/room_sim.cpp -o room_sim
+ *
+ * ใช้งาน:
+ *   ./room_sim                              # สร้าง trace สุ่ม 7 วัน แล้วรัน
+ *   ./room_sim --days 30 --seed 7 --rate 4  # 30 วัน, ห้องละ ~4 คน/ชม. ช่วงกลางวัน
+ *   ./room_sim --save trace.csv             # บันทึก trace ที่สร้างไว้ replay ภายหลัง
+ *   ./room_sim --trace trace.csv            # replay trace ที่บันทึกไว้ (หรือที่ dump จากบอร์ด)
+ *   ./room_sim --wifi-off                   # ไม่มี AP (net task วนต่อ Wi-Fi ไม่สำเร็จ, journal ค้าง)
+ *   ./room_sim --days 1 --net-stall 3600    # ตั้งแต่ชั่วโมงที่ 1 WiFi.begin()/POST() ค้างตลอดไป
+ *                                           # PASS/FAIL จาก histogram รอบ loop() (exit 1 ถ้า FAIL)
+ *   ./room_sim --line-faults 429,500,drop   # LINE ตอบตามลำดับนี้ทีละ request แล้วกลับเป็น 200
+ *                                           # (409 = ส่งถึงแล้วแต่คำตอบหาย -> ส่งซ้ำได้ 409 จาก retry key)
+ *   ./room_sim --line-scenario              # trace ตายตัว: หลายห้องถึงเกณฑ์ใน 1.5s + LINE ผิดพลาด/ล่ม
+ *                                           # ตรวจจำนวน push, <= 5 ข้อความ/push, backoff, heartbeat ซ้ำ,
+ *                                           # retry key/409 (FAIL -> exit 1)
+ *   ./room_sim --days 1 --serial            # พิมพ์ log Serial ของเฟิร์มแวร์พร้อมเวลาเสมือน
+ *
+ * รูปแบบ trace (CSV เรียงตามเวลา):
+ *   t_us,pin,level            edge ของขา GPIO (เหมือน EdgeEvent ใน edge_capture.h)
+ *   #V,room,start_us,end_us   ground truth: คนเข้าห้อง (ประตูปิด) .. ออก (ประตูเปิด)
+ *   บรรทัดอื่นที่ขึ้นต้นด้วย # ถูกข้าม
+ *
+ * รายงาน: จำนวน session, ความคลาดเคลื่อนของระยะเวลา, จำนวนแจ้งเตือนทำความสะอาด,
+ *         สัดส่วนเวลาตื่น/จำนวนครั้งที่ตื่น, งานเน็ต (POST/push/ต่อ Wi-Fi) และ latency ต่อรอบ loop
+ *         (เวลา CPU ของเครื่อง PC ที่ใช้ประมวลผล loop() หนึ่งรอบ ไม่รวมช่วง block
+ *          ใช้เทียบว่าการแก้ไขทำให้ลอจิกช้าลงหรือไม่)
+ *         และเวลาเสมือนต่อรอบ loop ที่ตื่นอยู่ (รวม edgeWait/HTTP ที่ block แต่ไม่รวม light sleep)
+ *         --net-stall: ผ่านเมื่อ net task ค้างจริงแต่ทุกรอบ loop ยังไม่เกิน LOOP_STALL_MAX_MS
+ *         (loop ต้องกลับมา feed watchdog ตาม WDT_FEED_MS ไม่ว่าเน็ตจะเป็นอย่างไร)
+ * ========================================================= */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "visit_gen.h"        // คนเข้าห้องสังเคราะห์ (ชุดเดียวกับเครื่องมืออื่นใน tools/)
+#include "SmartRestroom.ino"  // เฟิร์มแวร์ทั้งไฟล์: setup()/loop()/net task ตัวจริง บนบอร์ดปลอมใน fake/
+
+/* --net-stall: รอบ loop() ที่ตื่นอยู่ต้องไม่ยาวกว่านี้ (รอได้ถึง deadline feed watchdog + เวลาประมวลผล) */
+#define LOOP_STALL_MAX_MS (WDT_FEED_MS + 100)
+
+struct Trace {
+  std::vector<PinEdge> edges;
+  std::vector<Visit>   visits;   // ground truth (ว่างได้ถ้า trace มาจากบอร์ดจริง)
+  int64_t durationUs = 0;
+};
+
+static bool doorClosedLevel() { return !PanelPins::reedActiveLow; }
+
+/* =========================================================
+ * สร้าง trace สุ่มด้วย visit_gen.h (กลางวัน 07-21 น. คนเข้าถี่กว่ากลางคืน 10 เท่า)
+ * ========================================================= */
+static Trace generateTrace(int days, uint32_t seed, double ratePerHour) {
+  Trace tr;
+  tr.durationUs = (int64_t)days * 86400LL * 1000000LL;
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> U(0.0, 1.0);
+  const VisitParams vp = {ratePerHour};
+  const bool closedLvl = doorClosedLevel();
+  auto emit = [&](const PinEdge &e) { tr.edges.push_back(e); };
+
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    int64_t after = (int64_t)(600.0 * U(rng) * 1e6);
+    for (;;) {
+      Visit v = visitDraw(rng, i, after, vp);
+      if (v.endUs + 1800LL * 1000000 >= tr.durationUs) break;
+      after = visitEmit<PanelPins>(rng, v, emit);
+      tr.visits.push_back(v);
+    }
+  }
+
+  std::stable_sort(tr.edges.begin(), tr.edges.end(),
+                   [](const PinEdge &a, const PinEdge &b) { return a.tUs < b.tUs; });
+
+  // ตัด edge ที่ระดับไม่เปลี่ยนจริง (พัลส์ท้ายของคนก่อนซ้อนกับคนถัดไป)
+  bool level[ROOM_MAX_GPIO] = {};
+  for (size_t i = 0; i < ROOM_COUNT; i++) level[PanelPins::door[i]] = !closedLvl;
+  std::vector<PinEdge> clean;
+  clean.reserve(tr.edges.size());
+  for (const PinEdge &e : tr.edges) {
+    if ((bool)e.level == level[e.pin]) continue;
+    level[e.pin] = e.level;
+    clean.push_back(e);
+  }
+  tr.edges.swap(clean);
+  return tr;
+}
+
+/* =========================================================
+ * --line-scenario: trace ตายตัวสำหรับตรวจคิว LINE (line_dispatch.h) กับปลาย LINE ปลอมที่ตอบผิดพลาด
+ * - ช่วง A: ทุกห้องใช้ครบ USES_THRESHOLD_PER_ROOM รอบ รอบสุดท้ายจบห่างกัน < LINE_COALESCE_MS
+ *           -> แจ้งเตือนทุกห้องต้องไปใน push เดียว ที่โดน 429, 500, drop, คำตอบหาย (409 ตอนส่งซ้ำ)
+ * - ช่วง B: LINE ล่ม (500) ระหว่างที่ทุกห้องถึงเกณฑ์ 2 ชุดคั่นด้วยการรีเซ็ต + heartbeat ใหม่
+ *           -> ชุดแรกค้างส่งซ้ำ + รีเซ็ต + heartbeat + แจ้งเตือนชุดสอง = 8 ข้อความ ต้องแบ่ง push ละไม่เกิน 5
+ * - ที่เหลือว่าง: heartbeat หลังตื่นจาก timer ซ้ำข้อความเดิม (ต้องถูกข้ามจนครบ 6 ชม.)
+ * ========================================================= */
+#define SCN_FAULTS      "429,500,drop,409"
+#define SCN_A_US        (30LL * 1000000)
+#define SCN_B1_US       (3600LL * 1000000)
+#define SCN_SOLO_US     (4420LL * 1000000)          // หลังแม่บ้านรีเซ็ตชุด B1 (ถึงเกณฑ์ + 10 นาที): ห้อง 1 ใช้ 1 รอบ
+                                                    // -> heartbeat ตอนตื่นจาก timer ไม่ซ้ำข้อความเดิม
+#define SCN_B2_US       (4900LL * 1000000)
+#define SCN_DOWN_FROM_US SCN_B1_US
+#define SCN_DOWN_UNTIL_US (5200LL * 1000000)
+#define SCN_DURATION_US (8LL * 3600 * 1000000)       // ให้ heartbeat เดิมครบ LINE_HEARTBEAT_REPEAT_MS อย่างน้อยรอบหนึ่ง
+#define SCN_VISIT_US    (20LL * 1000000)             // 5 รอบ x 20s ไม่ถึงเกณฑ์เวลาสะสม 2 นาที
+#define SCN_GAP_US      (40LL * 1000000)
+
+/* ใช้ห้อง 1 รอบ: ประตูปิด, PIR เป็นพัลส์ 2s ทุก 4s (ไม่เกิน HOLD_ON_MS), ประตูเปิด */
+static void addFixedVisit(Trace &tr, uint8_t room, int64_t startUs, int64_t endUs) {
+  const bool closedLvl = doorClosedLevel();
+  tr.edges.push_back({startUs, PanelPins::door[room], (uint8_t)closedLvl});
+  for (int64_t t = startUs + 1000000; t + 2000000 < endUs; t += 4000000) {
+    tr.edges.push_back({t, PanelPins::pir[room], 1});
+    tr.edges.push_back({t + 2000000, PanelPins::pir[room], 0});
+  }
+  tr.edges.push_back({endUs, PanelPins::door[room], (uint8_t)!closedLvl});
+  tr.visits.push_back({room, startUs, endUs});
+}
+
+/* ทุกห้องใช้ครบเกณฑ์ เหลื่อมกันห้องละ LINE_COALESCE_MS / (ROOM_COUNT + 1) -> ถึงเกณฑ์ภายในหน้าต่างเดียว */
+static void addThresholdBurst(Trace &tr, int64_t atUs) {
+  const int64_t stagger = LINE_COALESCE_MS * 1000LL / (ROOM_COUNT + 1);
+  for (uint32_t k = 0; k < USES_THRESHOLD_PER_ROOM; k++) {
+    for (size_t i = 0; i < ROOM_COUNT; i++) {
+      int64_t start = atUs + k * SCN_GAP_US + (int64_t)i * stagger;
+      addFixedVisit(tr, (uint8_t)i, start, start + SCN_VISIT_US);
+    }
+  }
+}
+
+static Trace lineScenarioTrace() {
+  Trace tr;
+  tr.durationUs = SCN_DURATION_US;
+  addThresholdBurst(tr, SCN_A_US);
+  addThresholdBurst(tr, SCN_B1_US);
+  addFixedVisit(tr, 0, SCN_SOLO_US, SCN_SOLO_US + SCN_VISIT_US);
+  addThresholdBurst(tr, SCN_B2_US);
+  std::stable_sort(tr.edges.begin(), tr.edges.end(),
+                   [](const PinEdge &a, const PinEdge &b) { return a.tUs < b.tUs; });
+  return tr;
+}
+
+static bool saveTrace(const Trace &tr, const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "# room_sim trace: rooms=%u duration_us=%lld\n",
+          (unsigned)ROOM_COUNT, (long long)tr.durationUs);
+  for (const Visit &v : tr.visits)
+    fprintf(f, "#V,%u,%lld,%lld\n", v.room, (long long)v.startUs, (long long)v.endUs);
+  for (const PinEdge &e : tr.edges)
+    fprintf(f, "%lld,%u,%u\n", (long long)e.tUs, e.pin, e.level);
+  fclose(f);
+  return true;
+}
+
+static bool loadTrace(Trace &tr, const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return false;
+  char line[128];
+  long long headerUs = 0;
+  while (fgets(line, sizeof(line), f)) {
+    long long a, b, c;
+    unsigned room;
+    if (sscanf(line, "# room_sim trace: rooms=%u duration_us=%lld", &room, &a) == 2) {
+      headerUs = a;
+    } else if (sscanf(line, "#V,%u,%lld,%lld", &room, &a, &b) == 3) {
+      if (room < ROOM_COUNT) tr.visits.push_back({(uint8_t)room, a, b});
+    } else if (line[0] != '#' && sscanf(line, "%lld,%lld,%lld", &a, &b, &c) == 3) {
+      if (b >= 0 && b < ROOM_MAX_GPIO) tr.edges.push_back({a, (uint8_t)b, (uint8_t)(c != 0)});
+    }
+  }
+  fclose(f);
+  std::stable_sort(tr.edges.begin(), tr.edges.end(),
+                   [](const PinEdge &x, const PinEdge &y) { return x.tUs < y.tUs; });
+  int64_t last = tr.edges.empty() ? 0 : tr.edges.back().tUs;
+  for (const Visit &v : tr.visits) last = std::max(last, v.endUs);
+  tr.durationUs = std::max((int64_t)headerUs,
+                           last + (int64_t)SLEEP_IDLE_MS * 1000);   // เผื่อให้ session สุดท้ายจบ
+  return true;
+}
+
+/* =========================================================
+ * Histogram latency ต่อรอบ loop (100000 ช่อง: ช่องละ 10ns ถึง 1ms สำหรับเวลา CPU ของ PC,
+ * ช่องละ 1ms ถึง 100s สำหรับเวลาเสมือน)
+ * ========================================================= */
+struct LatencyHist {
+  static const size_t kBuckets = 100000;
+  std::vector<uint64_t> bins = std::vector<uint64_t>(kBuckets + 1, 0);
+  uint64_t widthNs;
+  uint64_t count = 0;
+  uint64_t maxNs = 0;
+
+  explicit LatencyHist(uint64_t width = 10) : widthNs(width) {}
+  void add(uint64_t ns) {
+    size_t b = (size_t)(ns / widthNs);
+    bins[b < kBuckets ? b : kBuckets]++;
+    count++;
+    if (ns > maxNs) maxNs = ns;
+  }
+  uint64_t percentileNs(double p) const {
+    uint64_t want = (uint64_t)ceil(p * (double)count);
+    uint64_t acc = 0;
+    for (size_t b = 0; b < kBuckets; b++) {
+      acc += bins[b];
+      if (acc >= want && want) return (uint64_t)(b + 1) * widthNs;
+    }
+    return maxNs;
+  }
+};
+
+/* =========================================================
+ * ผู้ขับ: ป้อน edge ตามเวลา, แม่บ้านกดรีเซ็ต, สังเกตผลจาก journal/สถานะห้อง
+ * ========================================================= */
+enum WakeCause { WAKE_PIR = 0, WAKE_BUTTON, WAKE_TIMER, WAKE_CAUSES };
+
+struct Driver {
+  const Trace *tr = nullptr;
+  size_t nextEdge = 0;
+  std::vector<PinEdge> injected;     // การกดปุ่มของแม่บ้าน (ใส่เพิ่มระหว่างรัน)
+  size_t nextInjected = 0;
+  bool cleanerScheduled = false;
+
+  std::vector<Visit> sessions;       // session ที่เฟิร์มแวร์นับได้ (จาก JEV_END ใน journal)
+  uint32_t nextSeq = 0;              // seq ถัดไปของ journal ที่ยังไม่ได้ดู
+  uint32_t lastUses[ROOM_COUNT] = {};
+  bool     lastNeed[ROOM_COUNT] = {};
+
+  uint32_t alerts = 0;
+  uint8_t  linePeak = 0;             // ข้อความค้างในคิว LINE มากสุด (รวมชุดที่ค้างส่งซ้ำ)
+  uint32_t resets = 0;
+  uint32_t timeoutEnds = 0;
+  uint32_t idleWake[WAKE_CAUSES] = {};
+  LatencyHist loopNs;
+  LatencyHist loopAwakeNs{1000000};   // เวลาเสมือนต่อรอบ loop() ไม่รวมช่วง light sleep (ช่องละ 1ms)
+};
+static Driver drv;
+
+static const PinEdge *nextExternal() {
+  const Trace &tr = *drv.tr;
+  const PinEdge *a = drv.nextEdge < tr.edges.size() ? &tr.edges[drv.nextEdge] : nullptr;
+  const PinEdge *b = drv.nextInjected < drv.injected.size() ? &drv.injected[drv.nextInjected] : nullptr;
+  if (!a) return b;
+  if (!b) return a;
+  return b->tUs < a->tUs ? b : a;
+}
+
+static int64_t extNextUs() {
+  const PinEdge *e = nextExternal();
+  return e ? e->tUs : SIM_NEVER;
+}
+
+static void extApply() {
+  const PinEdge *e = nextExternal();
+  PinEdge ev = *e;
+  if (drv.nextInjected < drv.injected.size() && e == &drv.injected[drv.nextInjected]) drv.nextInjected++;
+  else drv.nextEdge++;
+  simSetPin(ev.pin, ev.level);
+}
+
+/* แม่บ้านกด double click หลังได้แจ้งเตือน (กด 150ms เว้น 200ms) */
+static void scheduleCleaner(int64_t atUs) {
+  const int64_t ms = 1000;
+  PinEdge presses[] = {
+    {atUs,            RESET_BTN, 1}, {atUs + 150 * ms, RESET_BTN, 0},
+    {atUs + 350 * ms, RESET_BTN, 1}, {atUs + 500 * ms, RESET_BTN, 0},
+  };
+  for (const PinEdge &p : presses) {
+    auto it = std::upper_bound(drv.injected.begin() + drv.nextInjected, drv.injected.end(), p,
+                               [](const PinEdge &x, const PinEdge &y) { return x.tUs < y.tUs; });
+    drv.injected.insert(it, p);
+  }
+  drv.cleanerScheduled = true;
+}
+
+/*
+ * เรียกทุกครั้งก่อน loop block: event ใหม่ทุกตัวยังอยู่ใน ring ของ journal เสมอ
+ * (loop เป็นผู้เขียนคนเดียว และ net task ส่ง/ย้ายลง NVS ได้ก็ต่อเมื่อ loop block แล้ว)
+ */
+static void observe() {
+  if (journalRTC.nextSeq != drv.nextSeq) {
+    for (uint16_t k = 0; k < journalRTC.count; k++) {
+      const JournalEvent &e = journalRTC.ev[(journalRTC.head + k) % JOURNAL_RTC_LEN];
+      if (e.seq < drv.nextSeq) continue;
+      if (e.kind == JEV_END) {
+        int64_t endUs = (int64_t)e.tsMs * 1000;
+        drv.sessions.push_back({e.room, endUs - (int64_t)e.durMs * 1000, endUs});
+      } else if (e.kind == JEV_RESET) {
+        drv.resets++;
+        drv.cleanerScheduled = false;
+      }
+    }
+    drv.nextSeq = journalRTC.nextSeq;
+  }
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    if (panel.uses[i] > drv.lastUses[i] && panel.doorClosed[i]) drv.timeoutEnds++;   // จบโดยประตูยังปิด
+    drv.lastUses[i] = panel.uses[i];
+    if (panel.needCleaning[i] && !drv.lastNeed[i]) drv.alerts++;
+    drv.lastNeed[i] = panel.needCleaning[i];
+  }
+  drv.linePeak = std::max(drv.linePeak, lineDispatch.count);
+  if (cleaningRequired && !drv.cleanerScheduled) scheduleCleaner(simNowUs + CLEANER_DELAY_US);
+}
+
+static void onSleepEnd(bool idle) {
+  if (!idle) return;
+  WakeCause c = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER ? WAKE_TIMER
+              : (fakeGpioIn & Panel::pirWakeMask())                    ? WAKE_PIR
+                                                                       : WAKE_BUTTON;
+  drv.idleWake[c]++;
+}
+
+/* บูตบอร์ดแล้ววน loop() จริงจนจบ trace */
+static void runFirmware(const Trace &tr, bool wifiOff, int64_t netStallAtUs) {
+  drv.tr = &tr;
+  simBoardInit();
+  simWifiAvailable = !wifiOff;
+  simNetStallAtUs = netStallAtUs;
+  // ระดับขาตอนบูต: ประตูเปิดหมด, PIR/ปุ่ม LOW
+  for (size_t i = 0; i < ROOM_COUNT; i++) {
+    if (!doorClosedLevel()) fakeGpioIn |= 1ULL << PanelPins::door[i];
+  }
+  simExtNextUs   = extNextUs;
+  simExtApply    = extApply;
+  simOnLoopYield = observe;
+  simOnSleepEnd  = onSleepEnd;
+
+  setup();
+  while (simNowUs < tr.durationUs) {
+    int64_t t0 = simNowUs, slept0 = simSleep.asleepUs;
+    simLoopHostNs = 0;
+    simLoopSegStart = std::chrono::steady_clock::now();
+    loop();
+    simLoopHostNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - simLoopSegStart).count();
+    drv.loopNs.add(simLoopHostNs);
+    int64_t awakeUs = (simNowUs - t0) - (simSleep.asleepUs - slept0);
+    drv.loopAwakeNs.add((uint64_t)std::min(awakeUs, tr.durationUs) * 1000);   // ค้างเกินจบ trace -> นับเท่า trace
+  }
+  observe();
+}
+
+/* =========================================================
+ * เทียบ session ของเฟิร์มแวร์กับ ground truth
+ * session ถูกนับให้ visit ล่าสุดของห้องเดียวกันที่เริ่มก่อน session เริ่ม
+ * ========================================================= */
+struct MatchReport {
+  uint32_t matched = 0, missed = 0, split = 0, extra = 0;
+  std::vector<int64_t> absErrMs;
+};
+
+static MatchReport matchSessions(const Trace &tr, const std::vector<Visit> &sessions) {
+  MatchReport r;
+  for (size_t room = 0; room < ROOM_COUNT; room++) {
+    std::vector<Visit> truth, dev;
+    for (const Visit &v : tr.visits) if (v.room == room) truth.push_back(v);
+    for (const Visit &s : sessions)  if (s.room == room) dev.push_back(s);
+    auto byStart = [](const Visit &a, const Visit &b) { return a.startUs < b.startUs; };
+    std::sort(truth.begin(), truth.end(), byStart);
+    std::sort(dev.begin(), dev.end(), byStart);
+
+    std::vector<int64_t> devUs(truth.size(), 0);
+    std::vector<uint32_t> devCount(truth.size(), 0);
+    for (const Visit &s : dev) {
+      auto it = std::upper_bound(truth.begin(), truth.end(), s, byStart);
+      if (it == truth.begin()) { r.extra++; continue; }
+      size_t k = (size_t)(it - truth.begin()) - 1;
+      if (s.startUs > truth[k].endUs) { r.extra++; continue; }
+      devUs[k] += s.endUs - s.startUs;
+      devCount[k]++;
+    }
+    for (size_t k = 0; k < truth.size(); k++) {
+      if (devCount[k] == 0) { r.missed++; continue; }
+      r.matched++;
+      if (devCount[k] > 1) r.split++;
+      int64_t trueUs = truth[k].endUs - truth[k].startUs;
+      r.absErrMs.push_back(llabs(devUs[k] - trueUs) / 1000);
+    }
+  }
+  std::sort(r.absErrMs.begin(), r.absErrMs.end());
+  return r;
+}
+
+static int64_t pctl(const std::vector<int64_t> &v, double p) {
+  if (v.empty()) return 0;
+  size_t k = (size_t)ceil(p * (double)v.size());
+  return v[k ? k - 1 : 0];
+}
+
+/* =========================================================
+ * --line-scenario: ตรวจผลจาก log ของปลาย LINE ปลอม (simLineLog / simLineInbox)
+ * ========================================================= */
+static bool scnCheck(const char *name, bool ok, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  printf("line check : %s %-10s ", ok ? "PASS" : "FAIL", name);
+  vprintf(fmt, ap);
+  printf("\n");
+  va_end(ap);
+  return ok;
+}
+
+static bool lineScenarioCheck() {
+  bool pass = true;
+
+  // ชุดแรกของช่วง A = request แรกที่มีแจ้งเตือนทำความสะอาด; ทุก request ที่ใช้ key เดียวกันคือชุดนั้น
+  const SimLineReq *first = nullptr;
+  for (const SimLineReq &r : simLineLog) {
+    if (r.startUs < SCN_B1_US && r.msgs > r.beats) { first = &r; break; }
+  }
+  if (!first) return scnCheck("coalesce", false, "no cleaning push before t=%lld s", SCN_B1_US / 1000000);
+  const std::string key = first->key;
+  std::vector<const SimLineReq *> a;
+  for (const SimLineReq &r : simLineLog) if (r.key == key) a.push_back(&r);
+
+  // 1) ทุกห้องที่ถึงเกณฑ์ในหน้าต่างเดียวไปใน push เดียว
+  pass &= scnCheck("coalesce", first->msgs == ROOM_COUNT, "first alert push carries %u msg(s), want %u",
+                   (unsigned)first->msgs, (unsigned)ROOM_COUNT);
+
+  // 2) จำนวน request ของชุดนั้น: ตามสคริปต์ 429, 500, drop (+ลองใหม่ทันทีบน socket ใหม่), คำตอบหาย, 409
+  const uint8_t want[] = {SIM_LINE_429, SIM_LINE_500, SIM_LINE_DROP, SIM_LINE_LOST, SIM_LINE_DUP};
+  bool seqOk = a.size() == sizeof(want);
+  for (size_t k = 0; seqOk && k < a.size(); k++) seqOk = a[k]->reply == want[k];
+  std::string got;
+  for (const SimLineReq *r : a) got += (got.empty() ? "" : ",") + std::to_string(r->code);
+  pass &= scnCheck("push count", seqOk, "%zu request(s) with one retry key, codes %s", a.size(), got.c_str());
+
+  // 3) ไม่มี push ไหนเกิน LINE_BATCH_MAX และคิวเคยค้างเกินนั้นจริง (ต้องแบ่งหลาย push)
+  uint8_t maxMsgs = 0;
+  for (const SimLineReq &r : simLineLog) maxMsgs = std::max(maxMsgs, r.msgs);
+  pass &= scnCheck("cap", maxMsgs <= LINE_BATCH_MAX && drv.linePeak > LINE_BATCH_MAX,
+                   "max %u msg(s) per push (cap %u), queue peak %u", (unsigned)maxMsgs,
+                   (unsigned)LINE_BATCH_MAX, (unsigned)drv.linePeak);
+
+  // 4) backoff: push ถัดไปของชุดเริ่มหลังจบครั้งก่อน LINE_BACKOFF_MIN_MS x 2^k (+ net task ตื่นช้าได้ไม่เกิน 1s)
+  //    request ที่เริ่มทันทีหลังครั้งก่อนคือ httpPost ลองใหม่บน socket ใหม่ในการเรียกเดียวกัน ไม่นับเป็น push ใหม่
+  bool boOk = true;
+  uint32_t expect = LINE_BACKOFF_MIN_MS;
+  std::string gaps;
+  for (size_t k = 1; k < a.size(); k++) {
+    int64_t gapMs = (a[k]->startUs - a[k - 1]->endUs) / 1000;
+    if (gapMs < (int64_t)LINE_MIN_INTERVAL_MS) continue;
+    gaps += (gaps.empty() ? "" : ",") + std::to_string(gapMs);
+    boOk &= gapMs >= (int64_t)expect && gapMs <= (int64_t)expect + 1000;
+    expect = std::min<uint32_t>(expect * 2, LINE_BACKOFF_MAX_MS);
+  }
+  pass &= scnCheck("backoff", boOk && !gaps.empty(), "gaps %s ms (from %lu, doubling)", gaps.c_str(),
+                   (unsigned long)LINE_BACKOFF_MIN_MS);
+
+  // 5) retry key: ส่งซ้ำด้วย key เดิมจน LINE ตอบ 409, ผู้ใช้ได้ชุดนั้นครั้งเดียว, ชุดถัดไปได้ key ใหม่
+  size_t delivered = 0;
+  for (const SimLineMsg &m : simLineInbox) if (m.key == key) delivered++;
+  bool newKey = true;
+  std::set<std::string> keys;
+  for (const SimLineReq &r : simLineLog) keys.insert(r.key);
+  for (const std::string &k : keys) newKey &= !k.empty();
+  pass &= scnCheck("retry key", a.back()->code == 409 && delivered == first->msgs && newKey,
+                   "last code %d, %zu of %u msg(s) delivered once, %zu distinct key(s)",
+                   a.back()->code, delivered, (unsigned)first->msgs, keys.size());
+
+  // 6) ทุกแจ้งเตือนทำความสะอาดถึงผู้ใช้ครั้งเดียว (ไม่หายในช่วงล่ม ไม่ซ้ำจากการส่งซ้ำ)
+  uint32_t cleanMsgs = 0;
+  for (const SimLineMsg &m : simLineInbox) cleanMsgs += m.text.find("needs cleaning") != std::string::npos;
+  pass &= scnCheck("delivered", cleanMsgs == drv.alerts, "%u cleaning msg(s) delivered for %u alert(s)",
+                   cleanMsgs, drv.alerts);
+
+  // 7) heartbeat ที่เหมือนตัวก่อนหน้าที่ถึงผู้ใช้ ห่างกันไม่น้อยกว่า LINE_HEARTBEAT_REPEAT_MS,
+  //    ถูกข้ามจริง และส่งซ้ำเมื่อครบเวลา
+  const SimLineMsg *prev = nullptr;
+  uint32_t beats = 0, repeats = 0;
+  int64_t minGapMs = INT64_MAX;
+  for (const SimLineMsg &m : simLineInbox) {
+    if (m.text.find("Heartbeat") == std::string::npos) continue;
+    beats++;
+    if (prev && prev->text == m.text) {
+      repeats++;
+      minGapMs = std::min(minGapMs, (m.atUs - prev->atUs) / 1000);
+    }
+    prev = &m;
+  }
+  bool dedupOk = lineDispatch.st.beatsSkipped > 0 && repeats > 0 &&
+                 minGapMs >= (int64_t)LINE_HEARTBEAT_REPEAT_MS;
+  pass &= scnCheck("heartbeat", dedupOk, "%u delivered, %lu skipped, %u back-to-back repeat(s) >= %lld s apart",
+                   beats, (unsigned long)lineDispatch.st.beatsSkipped, repeats,
+                   (long long)(repeats ? minGapMs / 1000 : 0));
+  return pass;
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--days D] [--seed S] [--rate VISITS_PER_HOUR] [--trace IN.csv] [--save OUT.csv]"
+          " [--wifi-off] [--net-stall SEC] [--line-faults 429,500,409,drop,...] [--line-scenario] [--serial]\n",
+          argv0);
+}
+
+int main(int argc, char **argv) {
+  int days = 7;
+  uint32_t seed = 1;
+  double rate = 3.0;
+  const char *tracePath = nullptr;
+  const char *savePath = nullptr;
+  bool wifiOff = false;
+  int64_t netStallAtUs = SIM_NEVER;
+  bool lineScenario = false;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasVal = i + 1 < argc;
+    if      (!strcmp(argv[i], "--days")  && hasVal) days = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed")  && hasVal) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--rate")  && hasVal) rate = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--trace") && hasVal) tracePath = argv[++i];
+    else if (!strcmp(argv[i], "--save")  && hasVal) savePath = argv[++i];
+    else if (!strcmp(argv[i], "--wifi-off")) wifiOff = true;
+    else if (!strcmp(argv[i], "--net-stall") && hasVal) netStallAtUs = (int64_t)(atof(argv[++i]) * 1e6);
+    else if (!strcmp(argv[i], "--line-faults") && hasVal) {
+      if (!simLineParseFaults(argv[++i])) { usage(argv[0]); return 2; }
+    }
+    else if (!strcmp(argv[i], "--line-scenario")) lineScenario = true;
+    else if (!strcmp(argv[i], "--serial"))   simSerialEcho = true;
+    else { usage(argv[0]); return 2; }
+  }
+  if (days <= 0 || rate <= 0.0) { usage(argv[0]); return 2; }
+
+  Trace tr;
+  if (lineScenario) {
+    tr = lineScenarioTrace();
+    simLineParseFaults(SCN_FAULTS);
+    simLineDownFromUs  = SCN_DOWN_FROM_US;
+    simLineDownUntilUs = SCN_DOWN_UNTIL_US;
+  } else if (tracePath) {
+    if (!loadTrace(tr, tracePath)) { fprintf(stderr, "cannot read %s\n", tracePath); return 1; }
+  } else {
+    tr = generateTrace(days, seed, rate);
+  }
+  if (savePath && !saveTrace(tr, savePath)) { fprintf(stderr, "cannot write %s\n", savePath); return 1; }
+
+  auto w0 = std::chrono::steady_clock::now();
+  runFirmware(tr, wifiOff, netStallAtUs);
+  double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - w0).count();
+  double simS = (double)simNowUs / 1e6;
+
+  MatchReport m = matchSessions(tr, drv.sessions);
+  double totalUs = (double)simNowUs;
+  double awakeUs = totalUs - (double)simSleep.asleepUs;
+
+  // sleepStats ของเฟิร์มแวร์รวมหลับยาวด้วย (นับเป็น heartbeat) -> หักออกให้เหลือเฉพาะหลับสั้น
+  const uint32_t idleN = simSleep.idleSleeps;
+  const uint32_t idleGpio = drv.idleWake[WAKE_PIR] + drv.idleWake[WAKE_BUTTON];
+  const uint32_t idleTimer = drv.idleWake[WAKE_TIMER];
+  SleepStats k = sleepStats;
+  k.sleeps -= idleN;
+  k.wakeGpio -= idleGpio;
+  k.wakeTimer -= idleTimer;
+  k.byReason[SCHED_HEARTBEAT] -= idleTimer;
+
+  printf("trace      : %s, rooms=%u, %.2f days, %zu edges, %zu visits\n",
+         lineScenario ? "line scenario" : tracePath ? tracePath : "generated", (unsigned)ROOM_COUNT, simS / 86400.0,
+         tr.edges.size(), tr.visits.size());
+  printf("speed      : %.2f s wall, %.0fx real time\n", wallS, wallS > 0 ? simS / wallS : 0.0);
+  printf("sessions   : %zu counted (%u ended by timeout)\n", drv.sessions.size(), drv.timeoutEnds);
+  if (!tr.visits.empty()) {
+    printf("match      : matched=%u missed=%u split=%u extra=%u\n", m.matched, m.missed, m.split, m.extra);
+    printf("dur error  : p50=%lld ms p99=%lld ms max=%lld ms\n",
+           (long long)pctl(m.absErrMs, 0.50), (long long)pctl(m.absErrMs, 0.99),
+           (long long)(m.absErrMs.empty() ? 0 : m.absErrMs.back()));
+  }
+  printf("cleaning   : alerts=%u resets=%u\n", drv.alerts, drv.resets);
+  printf("awake      : %.2f%% (wifi %s; idle sleeps=%u, wake pir=%u button=%u timer=%u)\n",
+         totalUs > 0 ? 100.0 * awakeUs / totalUs : 0.0, wifiOff ? "off" : "associated", idleN,
+         drv.idleWake[WAKE_PIR], drv.idleWake[WAKE_BUTTON], drv.idleWake[WAKE_TIMER]);
+  printf("tick sleep : %u (%.1f/min), wake gpio=%u timer=%u"
+         " [room=%u blink=%u beat=%u buzzer=%u wdt=%u button=%u]\n",
+         k.sleeps, simS > 0 ? k.sleeps / (simS / 60.0) : 0.0, k.wakeGpio, k.wakeTimer,
+         k.byReason[SCHED_ROOM], k.byReason[SCHED_BLINK], k.byReason[SCHED_HEARTBEAT],
+         k.byReason[SCHED_BUZZER], k.byReason[SCHED_WDT], k.byReason[SCHED_BUTTON]);
+  printf("net        : status=%u batch=%u (%u events, %lu pending) line pushes=%u msgs=%u"
+         " wifi connects=%u drops=%u assoc tick sleeps=%u\n",
+         simHttp.backendPosts, simHttp.batchPosts, simHttp.batchEvents,
+         (unsigned long)journalPending(), simHttp.linePushes, simHttp.lineMsgs,
+         simWifi.connects, simWifi.drops, simWifi.assocTickSleeps);
+  uint32_t byReply[SIM_LINE_DUP + 1] = {};
+  for (const SimLineReq &r : simLineLog) byReply[r.reply]++;
+  printf("line       : requests=%zu (ok=%u 429=%u 500=%u drop=%u lost reply=%u 409=%u)"
+         " queued=%lu merged=%lu beat skip=%lu dropped=%lu\n",
+         simLineLog.size(), byReply[SIM_LINE_OK], byReply[SIM_LINE_429], byReply[SIM_LINE_500],
+         byReply[SIM_LINE_DROP], byReply[SIM_LINE_LOST], byReply[SIM_LINE_DUP],
+         (unsigned long)lineDispatch.st.queued, (unsigned long)lineDispatch.st.merged,
+         (unsigned long)lineDispatch.st.beatsSkipped, (unsigned long)lineDispatch.st.dropped);
+  printf("firmware   : flash writes=%lu i2c bytes=%lu wdt max gap=%lu ms\n",
+         (unsigned long)persistLogFlashWrites(), (unsigned long)oledStats.bytes,
+         (unsigned long)perf.wdtMaxGapMs);
+  printf("loop (host): %llu iterations, p50=%llu ns p99=%llu ns p999=%llu ns max=%llu ns\n",
+         (unsigned long long)drv.loopNs.count,
+         (unsigned long long)drv.loopNs.percentileNs(0.50),
+         (unsigned long long)drv.loopNs.percentileNs(0.99),
+         (unsigned long long)drv.loopNs.percentileNs(0.999),
+         (unsigned long long)drv.loopNs.maxNs);
+  printf("loop (sim) : awake per iteration p50=%llu ms p99=%llu ms p999=%llu ms max=%llu ms\n",
+         (unsigned long long)(drv.loopAwakeNs.percentileNs(0.50) / 1000000),
+         (unsigned long long)(drv.loopAwakeNs.percentileNs(0.99) / 1000000),
+         (unsigned long long)(drv.loopAwakeNs.percentileNs(0.999) / 1000000),
+         (unsigned long long)(drv.loopAwakeNs.maxNs / 1000000));
+
+  bool pass = true;
+  if (lineScenario) pass &= lineScenarioCheck();
+  if (netStallAtUs != SIM_NEVER) {
+    // ค้างจริงอย่างน้อยครั้งหนึ่ง, loop ไม่ได้เข้าไปค้างเอง และทุกรอบยังทันรอบ feed watchdog
+    // (journal ring เต็มแล้วทิ้ง event ใหม่เพราะ net task ไม่ได้ย้ายลง NVS -> session ที่นับได้ลดลงเป็นปกติ)
+    uint64_t maxMs = drv.loopAwakeNs.maxNs / 1000000;
+    pass = simNetStall.calls > 0 && simNetStall.loopCalls == 0 && maxMs <= LOOP_STALL_MAX_MS;
+    printf("net stall  : %s (blocked since t=%.0f s, calls=%u from loop=%u; loop max=%llu ms, limit %lu ms;"
+           " journal dropped=%lu)\n",
+           pass ? "PASS" : "FAIL", simNetStall.sinceUs / 1e6, simNetStall.calls, simNetStall.loopCalls,
+           (unsigned long long)maxMs, (unsigned long)LOOP_STALL_MAX_MS,
+           (unsigned long)journalRTC.dropped);
+  }
+  fflush(stdout);
+  _exit(pass ? 0 : 1);   // net task ยัง block อยู่บน stack ของตัวเอง -> ไม่ต้องรัน destructor
+}